@@ -0,0 +1,380 @@
+/**
+ * @file ETC1.cpp
+ * @author Brais Solla González
+ * @brief ETC1 encoder and decoder
+ * @version 0.1
+ * @date 2021-12-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ETC1.h"
+
+// Intensity modifiers, the texel index picks +a, +b, -a or -b (OES_compressed_ETC1_RGB8_texture)
+static const int etc1_modifiers[8][2] = {
+    {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}
+};
+
+struct etc1_fit_t {
+    uint32_t error;
+    int      table;
+    // Texel indices in the block layout (LSBs from bit 0, MSBs from bit 16)
+    uint32_t indices;
+};
+
+static inline int clamp8(int value){
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+static inline int expand4(int value){
+    return (value << 4) | value;
+}
+
+static inline int expand5(int value){
+    return (value << 3) | (value >> 2);
+}
+
+static inline int modifier(int table, int index){
+    int value = etc1_modifiers[table][index & 1];
+    return (index & 2) ? -value : value;
+}
+
+// Texels of one half of a block, row major positions.
+// flip 0: two 2x4 halves side by side, flip 1: two 4x2 halves on top of each other
+static void halfTexels(int flip, int half, int* texels){
+    int count = 0;
+    for(int y = 0; y < 4; y++){
+        for(int x = 0; x < 4; x++){
+            if((flip ? (y >> 1) : (x >> 1)) == half) texels[count++] = y * 4 + x;
+        }
+    }
+}
+
+// Best table and texel indices for 8 texels around a base color
+static etc1_fit_t fitHalf(const uint8_t* rgb, const int* texels, int r, int g, int b){
+    etc1_fit_t fit;
+    fit.error   = UINT32_MAX;
+    fit.table   = 0;
+    fit.indices = 0;
+
+    for(int table = 0; table < 8; table++){
+        uint32_t error   = 0;
+        uint32_t indices = 0;
+
+        for(int i = 0; i < 8 && error < fit.error; i++){
+            const uint8_t* texel = rgb + texels[i] * 3;
+            uint32_t best       = UINT32_MAX;
+            int      best_index = 0;
+
+            for(int index = 0; index < 4; index++){
+                int m  = modifier(table, index);
+                int dr = clamp8(r + m) - texel[0];
+                int dg = clamp8(g + m) - texel[1];
+                int db = clamp8(b + m) - texel[2];
+
+                uint32_t e = (uint32_t) (dr * dr + dg * dg + db * db);
+                if(e < best){
+                    best       = e;
+                    best_index = index;
+                }
+            }
+            error += best;
+
+            // Indices are stored column by column
+            int position = (texels[i] & 3) * 4 + (texels[i] >> 2);
+            indices |= (uint32_t) (best_index & 1) << position;
+            indices |= (uint32_t) (best_index >> 1) << (16 + position);
+        }
+
+        if(error < fit.error){
+            fit.error   = error;
+            fit.table   = table;
+            fit.indices = indices;
+        }
+    }
+    return fit;
+}
+
+// Base color candidates (bits per channel) for the average of 8 texels.
+// Returns the candidates written to bases (3 values each)
+static int baseCandidates(const int* sum, int bits, int quality, int* bases){
+    int maximum = (1 << bits) - 1;
+    int low[3], high[3];
+
+    for(int c = 0; c < 3; c++){
+        // sum / 8 scaled to [0, maximum]
+        int scaled = sum[c] * maximum;
+        if(quality == ETC1_QUALITY_HIGH){
+            low[c]  = scaled / (8 * 255);
+            high[c] = low[c] < maximum ? low[c] + 1 : maximum;
+        } else {
+            low[c]  = (scaled + 4 * 255) / (8 * 255);
+            high[c] = low[c];
+        }
+    }
+
+    int count = 0;
+    for(int i = 0; i < 8; i++){
+        int r = (i & 1) ? high[0] : low[0];
+        int g = (i & 2) ? high[1] : low[1];
+        int b = (i & 4) ? high[2] : low[2];
+
+        // Same candidate twice when low == high
+        if(((i & 1) && high[0] == low[0]) || ((i & 2) && high[1] == low[1]) || ((i & 4) && high[2] == low[2])) continue;
+
+        bases[count * 3 + 0] = r;
+        bases[count * 3 + 1] = g;
+        bases[count * 3 + 2] = b;
+        count++;
+    }
+    return count;
+}
+
+static void writeBlock(uint8_t* block, uint32_t high, uint32_t low){
+    block[0] = (uint8_t) (high >> 24);
+    block[1] = (uint8_t) (high >> 16);
+    block[2] = (uint8_t) (high >> 8);
+    block[3] = (uint8_t) (high);
+    block[4] = (uint8_t) (low >> 24);
+    block[5] = (uint8_t) (low >> 16);
+    block[6] = (uint8_t) (low >> 8);
+    block[7] = (uint8_t) (low);
+}
+
+size_t ETC1::encodedSize(int width, int height){
+    return (size_t) ((width + 3) / 4) * ((height + 3) / 4) * ETC1_BLOCK_SIZE;
+}
+
+int ETC1::planeHeight(int height){
+    // One guard row or more under the color, then a block row guarding the alpha
+    return ((height + 1 + 3) & ~3) + 4;
+}
+
+int ETC1::storedComponents(int components){
+    return (components == 2 || components == 4) ? 4 : 3;
+}
+
+size_t ETC1::imageSize(int width, int height, int components){
+    if(ETC1::storedComponents(components) == 4) return ETC1::encodedSize(width, 2 * ETC1::planeHeight(height));
+    return ETC1::encodedSize(width, height);
+}
+
+void ETC1::encodeBlock(const uint8_t* rgb, uint8_t* block, int quality){
+    uint32_t best_error = UINT32_MAX;
+    uint32_t best_high  = 0;
+    uint32_t best_low   = 0;
+
+    int bases[8 * 3];
+
+    for(int flip = 0; flip < 2; flip++){
+        int texels[2][8];
+        int sum[2][3];
+
+        for(int half = 0; half < 2; half++){
+            halfTexels(flip, half, texels[half]);
+
+            sum[half][0] = sum[half][1] = sum[half][2] = 0;
+            for(int i = 0; i < 8; i++){
+                for(int c = 0; c < 3; c++) sum[half][c] += rgb[texels[half][i] * 3 + c];
+            }
+        }
+
+        // Individual mode: 4 bit base colors
+        etc1_fit_t fit[2];
+        int        base[2][3];
+        for(int half = 0; half < 2; half++){
+            fit[half].error = UINT32_MAX;
+
+            int count = baseCandidates(sum[half], 4, quality, bases);
+            for(int i = 0; i < count; i++){
+                int* q = &bases[i * 3];
+                etc1_fit_t candidate = fitHalf(rgb, texels[half], expand4(q[0]), expand4(q[1]), expand4(q[2]));
+                if(candidate.error < fit[half].error){
+                    fit[half] = candidate;
+                    memcpy(base[half], q, sizeof(base[half]));
+                }
+            }
+        }
+
+        if(fit[0].error + fit[1].error < best_error){
+            best_error = fit[0].error + fit[1].error;
+            best_high  = ((uint32_t) base[0][0] << 28) | ((uint32_t) base[1][0] << 24) |
+                         ((uint32_t) base[0][1] << 20) | ((uint32_t) base[1][1] << 16) |
+                         ((uint32_t) base[0][2] << 12) | ((uint32_t) base[1][2] << 8)  |
+                         ((uint32_t) fit[0].table << 5) | ((uint32_t) fit[1].table << 2) | (uint32_t) flip;
+            best_low   = fit[0].indices | fit[1].indices;
+        }
+
+        // Differential mode: 5 bit base color and a 3 bit signed delta (-4 to 3) for the second half
+        fit[0].error = UINT32_MAX;
+        int count = baseCandidates(sum[0], 5, quality, bases);
+        for(int i = 0; i < count; i++){
+            int* q = &bases[i * 3];
+            etc1_fit_t candidate = fitHalf(rgb, texels[0], expand5(q[0]), expand5(q[1]), expand5(q[2]));
+            if(candidate.error < fit[0].error){
+                fit[0] = candidate;
+                memcpy(base[0], q, sizeof(base[0]));
+            }
+        }
+
+        fit[1].error = UINT32_MAX;
+        count = baseCandidates(sum[1], 5, quality, bases);
+        for(int i = 0; i < count; i++){
+            int q[3];
+            for(int c = 0; c < 3; c++){
+                q[c] = bases[i * 3 + c];
+                if(q[c] < base[0][c] - 4) q[c] = base[0][c] - 4;
+                if(q[c] > base[0][c] + 3) q[c] = base[0][c] + 3;
+            }
+            etc1_fit_t candidate = fitHalf(rgb, texels[1], expand5(q[0]), expand5(q[1]), expand5(q[2]));
+            if(candidate.error < fit[1].error){
+                fit[1] = candidate;
+                memcpy(base[1], q, sizeof(base[1]));
+            }
+        }
+
+        if(fit[0].error + fit[1].error < best_error){
+            best_error = fit[0].error + fit[1].error;
+            best_high  = ((uint32_t) base[0][0] << 27) | ((uint32_t) ((base[1][0] - base[0][0]) & 7) << 24) |
+                         ((uint32_t) base[0][1] << 19) | ((uint32_t) ((base[1][1] - base[0][1]) & 7) << 16) |
+                         ((uint32_t) base[0][2] << 11) | ((uint32_t) ((base[1][2] - base[0][2]) & 7) << 8)  |
+                         ((uint32_t) fit[0].table << 5) | ((uint32_t) fit[1].table << 2) | (1 << 1) | (uint32_t) flip;
+            best_low   = fit[0].indices | fit[1].indices;
+        }
+    }
+
+    writeBlock(block, best_high, best_low);
+}
+
+void ETC1::decodeBlock(const uint8_t* block, uint8_t* rgb){
+    uint32_t high = ((uint32_t) block[0] << 24) | ((uint32_t) block[1] << 16) | ((uint32_t) block[2] << 8) | block[3];
+    uint32_t low  = ((uint32_t) block[4] << 24) | ((uint32_t) block[5] << 16) | ((uint32_t) block[6] << 8) | block[7];
+
+    int base[2][3];
+    if(high & (1 << 1)){
+        // Differential
+        for(int c = 0; c < 3; c++){
+            int shift = 27 - c * 8;
+            int value = (high >> shift) & 31;
+            int delta = (high >> (shift - 3)) & 7;
+            if(delta & 4) delta -= 8;
+
+            base[0][c] = expand5(value);
+            // Out of range on ETC1 encoders (ETC2 modes), clamped
+            int second = value + delta;
+            base[1][c] = expand5(second < 0 ? 0 : (second > 31 ? 31 : second));
+        }
+    } else {
+        for(int c = 0; c < 3; c++){
+            int shift = 28 - c * 8;
+            base[0][c] = expand4((high >> shift) & 15);
+            base[1][c] = expand4((high >> (shift - 4)) & 15);
+        }
+    }
+
+    int  table[2] = {(int) ((high >> 5) & 7), (int) ((high >> 2) & 7)};
+    bool flip     = (high & 1) != 0;
+
+    for(int y = 0; y < 4; y++){
+        for(int x = 0; x < 4; x++){
+            int position = x * 4 + y;
+            int half     = flip ? (y >> 1) : (x >> 1);
+            int index    = (((low >> (16 + position)) & 1) << 1) | ((low >> position) & 1);
+            int m        = modifier(table[half], index);
+
+            uint8_t* texel = rgb + (y * 4 + x) * 3;
+            texel[0] = (uint8_t) clamp8(base[half][0] + m);
+            texel[1] = (uint8_t) clamp8(base[half][1] + m);
+            texel[2] = (uint8_t) clamp8(base[half][2] + m);
+        }
+    }
+}
+
+bool ETC1::encode(const uint8_t* pixels, int width, int height, int components, int stride, uint8_t* dest, int quality){
+    if(pixels == NULL || dest == NULL || width <= 0 || height <= 0 || components < 1 || components > 4) return false;
+    if(stride == 0) stride = width * components;
+
+    bool alpha = ETC1::storedComponents(components) == 4;
+    int  plane = alpha ? ETC1::planeHeight(height) : height;
+    int  rows  = alpha ? 2 * plane : height;
+
+    uint8_t* block = dest;
+    uint8_t  rgb[48];
+
+    for(int by = 0; by < rows; by += 4){
+        for(int bx = 0; bx < width; bx += 4){
+            for(int y = 0; y < 4; y++){
+                for(int x = 0; x < 4; x++){
+                    // Outside texels repeat the last column / row
+                    int sx = (bx + x < width) ? bx + x : width - 1;
+                    int sy = by + y;
+                    if(sy >= rows) sy = rows - 1;
+
+                    // Color plane, alpha plane (Its first row repeated in the last block row of the color plane)
+                    bool alpha_texel = alpha && (sy >= plane - 4);
+                    if(alpha_texel) sy = (sy >= plane) ? sy - plane : 0;
+                    if(sy >= height) sy = height - 1;
+
+                    const uint8_t* src   = pixels + (size_t) sy * stride + (size_t) sx * components;
+                    uint8_t*       texel = rgb + (y * 4 + x) * 3;
+
+                    if(alpha_texel){
+                        texel[0] = texel[1] = texel[2] = src[components - 1];
+                    } else if(components < 3){
+                        texel[0] = texel[1] = texel[2] = src[0];
+                    } else {
+                        texel[0] = src[0];
+                        texel[1] = src[1];
+                        texel[2] = src[2];
+                    }
+                }
+            }
+
+            ETC1::encodeBlock(rgb, block, quality);
+            block += ETC1_BLOCK_SIZE;
+        }
+    }
+    return true;
+}
+
+void ETC1::decode(const uint8_t* data, int width, int height, int components, uint8_t* pixels){
+    bool alpha = (components == 4);
+    int  plane = alpha ? ETC1::planeHeight(height) : height;
+    int  rows  = alpha ? 2 * plane : height;
+
+    const uint8_t* block = data;
+    uint8_t        rgb[48];
+
+    for(int by = 0; by < rows; by += 4){
+        for(int bx = 0; bx < width; bx += 4){
+            ETC1::decodeBlock(block, rgb);
+            block += ETC1_BLOCK_SIZE;
+
+            for(int y = 0; y < 4; y++){
+                int  sy          = by + y;
+                bool alpha_texel = alpha && sy >= plane;
+                if(alpha_texel) sy -= plane;
+                if(sy >= height) continue;
+
+                for(int x = 0; x < 4 && bx + x < width; x++){
+                    const uint8_t* texel = rgb + (y * 4 + x) * 3;
+                    uint8_t*       dest  = pixels + ((size_t) sy * width + bx + x) * components;
+
+                    if(alpha_texel){
+                        dest[3] = texel[1];
+                    } else {
+                        dest[0] = texel[0];
+                        dest[1] = texel[1];
+                        dest[2] = texel[2];
+                    }
+                }
+            }
+        }
+    }
+}
@@ -10,16 +10,33 @@
  */
 
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <limits.h>
+#include <thread>
 #include "ImageDriver.h"
 #include "Debug.h"
+#include "SIMD.h"
 
-// Enable on NEON (ARM) build
-// #define STBI_NEON
+// SIMD decoding (JPEG IDCT, YCbCr to RGB and upsampling) follows SIMD.h:
+// stb_image picks SSE2 by itself on x86, NEON has to be asked for.
+// Build with -DENYX_STBI_NO_SIMD (Or -DENYX_NO_SIMD) to debug the scalar decoder
+#if defined(ENYX_STBI_NO_SIMD) || !defined(ENYX_SIMD)
+#define STBI_NO_SIMD
+#elif defined(ENYX_SIMD_NEON)
+#define STBI_NEON
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ID_MMAP_AVAILABLE
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
-#define STBI_NO_SIMD // Enabled for debugging for now
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
@@ -32,11 +49,84 @@ static void _id_progress_report(float progress);
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "stb/stb_image_resize.h"
 
+#define ID_MAX_RESIZE_THREADS  16
+// Smaller bands / images are not worth a thread
+#define ID_MIN_BAND_ROWS       32
+#define ID_MIN_PARALLEL_PIXELS (256 * 256)
+
+// One resize, split in bands of output rows
+struct id_resize_t {
+    const uint8_t* input;
+    int      in_w, in_h, in_stride;
+    uint8_t* output;
+    int      out_w, out_h, out_stride;
+    int      n;
+    const imageresize_t* options;
+
+    int      bands;
+    // Output rows done by each band (Atomic)
+    int      rows_done[ID_MAX_RESIZE_THREADS];
+};
+
+struct id_band_t {
+    id_resize_t* resize;
+    int index;
+    int y0, y1;
+    int result;
+};
+
+// Band being resized by this thread, for _id_progress_report
+static thread_local id_band_t*          id_band     = NULL;
+static thread_local progress_callback_t id_callback = NULL;
+
 static void _id_progress_report(float progress){
-    if(ImageDriver::callback_fnc) ImageDriver::callback_fnc(progress);
+    id_band_t* band = id_band;
+    if(band == NULL) return;
+
+    id_resize_t* resize = band->resize;
+    __atomic_store_n(&resize->rows_done[band->index], (int) (progress * (band->y1 - band->y0)), __ATOMIC_RELAXED);
+
+    // Reported by the calling thread (Band 0) only
+    if(band->index == 0 && resize->options->progress){
+        int done = 0;
+        for(int i = 0; i < resize->bands; i++) done += __atomic_load_n(&resize->rows_done[i], __ATOMIC_RELAXED);
+        resize->options->progress((float) done / resize->out_h, resize->options->userdata);
+    }
+}
+
+// Progress of resizeImage() calls without options
+static void id_legacy_progress(float progress, void* userdata){
+    if(id_callback) id_callback(progress);
+}
+
+static void id_resize_band(id_band_t* band){
+    id_resize_t* resize  = band->resize;
+    const imageresize_t* options = resize->options;
+
+    int flags = (options->flags & IMAGE_RESIZE_PREMULTIPLIED) ? STBIR_FLAG_ALPHA_PREMULTIPLIED : 0;
+    stbir_colorspace space = (options->flags & IMAGE_RESIZE_SRGB) ? STBIR_COLORSPACE_SRGB : STBIR_COLORSPACE_LINEAR;
+
+    // Same scale as the whole image, shifted to the first row of the band: bands match a single resize exactly
+    id_band = band;
+    band->result = stbir_resize_subpixel(resize->input, resize->in_w, resize->in_h, resize->in_stride,
+        resize->output + (size_t) band->y0 * resize->out_stride, resize->out_w, band->y1 - band->y0, resize->out_stride,
+        STBIR_TYPE_UINT8, resize->n, options->alpha_channel, flags, STBIR_EDGE_CLAMP, STBIR_EDGE_CLAMP,
+        STBIR_FILTER_DEFAULT, STBIR_FILTER_DEFAULT, space, NULL,
+        (float) resize->out_w / resize->in_w, (float) resize->out_h / resize->in_h, 0.f, (float) band->y0);
+    id_band = NULL;
 }
 
 
+const char* ImageDriver::getDecoderSIMD(){
+#if defined(STBI_SSE2)
+    return "SSE2";
+#elif defined(STBI_NEON)
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+
 int ImageDriver::infoImage(const char* fileName, int* sx, int* sy, int* n){
     return stbi_info(fileName, sx, sy, n);
 }
@@ -51,49 +141,190 @@ float* ImageDriver::loadImageF(const char* fileName, int* sx, int* sy, int* n){
     return (float*) stbi_loadf(fileName, sx, sy, n, 0);
 }
 
+int ImageDriver::infoImageFromMemory(const void* data, size_t size, int* sx, int* sy, int* n){
+    if(data == NULL || size == 0 || size > INT_MAX) return 0;
+    return stbi_info_from_memory((const stbi_uc*) data, (int) size, sx, sy, n);
+}
+
+uint8_t* ImageDriver::loadImageFromMemory(const void* data, size_t size, int* sx, int* sy, int* n){
+    if(data == NULL || size == 0 || size > INT_MAX){
+        Debug::error("[%s:%d]: ID::loadImageFromMemory: Invalid buffer %p (%lu bytes)\n", __FILE__, __LINE__, data, (unsigned long) size);
+        return NULL;
+    }
+
+    Debug::info("[%s:%d]: ID::loadImageFromMemory: Loading image from %p (%lu bytes)...\n", __FILE__, __LINE__, data, (unsigned long) size);
+    uint8_t* px = (uint8_t*) stbi_load_from_memory((const stbi_uc*) data, (int) size, sx, sy, n, 0);
+    if(px == NULL){
+        Debug::error("[%s:%d]: ID::loadImageFromMemory: Cannot decode image: %s\n", __FILE__, __LINE__, stbi_failure_reason());
+    }
+    return px;
+}
+
+int ImageDriver::mapFile(const char* fileName, imagemapping_t* mapping){
+    if(fileName == NULL || mapping == NULL) return -1;
+
+    mapping->data   = NULL;
+    mapping->size   = 0;
+    mapping->mapped = false;
+
+#ifdef ID_MMAP_AVAILABLE
+    int fd = open(fileName, O_RDONLY);
+    if(fd < 0){
+        Debug::error("[%s:%d]: ID::mapFile: Cannot open %s\n", __FILE__, __LINE__, fileName);
+        return 1;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size <= 0){
+        Debug::error("[%s:%d]: ID::mapFile: Cannot get the size of %s\n", __FILE__, __LINE__, fileName);
+        close(fd);
+        return 2;
+    }
+
+    void* data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+
+    if(data == MAP_FAILED){
+        Debug::error("[%s:%d]: ID::mapFile: Cannot map %s\n", __FILE__, __LINE__, fileName);
+        return 3;
+    }
+    // Read once from start to end by the decoders
+    madvise(data, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+    mapping->data   = (const uint8_t*) data;
+    mapping->size   = (size_t) st.st_size;
+    mapping->mapped = true;
+    return 0;
+#else
+    // No mmap, one read of the whole file
+    FILE* file = fopen(fileName, "rb");
+    if(file == NULL){
+        Debug::error("[%s:%d]: ID::mapFile: Cannot open %s\n", __FILE__, __LINE__, fileName);
+        return 1;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if(size <= 0){
+        Debug::error("[%s:%d]: ID::mapFile: Cannot get the size of %s\n", __FILE__, __LINE__, fileName);
+        fclose(file);
+        return 2;
+    }
+
+    uint8_t* data = (uint8_t*) malloc((size_t) size);
+    if(data == NULL || fread(data, 1, (size_t) size, file) != (size_t) size){
+        Debug::error("[%s:%d]: ID::mapFile: Cannot read %s\n", __FILE__, __LINE__, fileName);
+        free(data);
+        fclose(file);
+        return 3;
+    }
+    fclose(file);
+
+    mapping->data   = data;
+    mapping->size   = (size_t) size;
+    mapping->mapped = false;
+    return 0;
+#endif
+}
+
+void ImageDriver::unmapFile(imagemapping_t* mapping){
+    if(mapping == NULL || mapping->data == NULL) return;
+
+#ifdef ID_MMAP_AVAILABLE
+    if(mapping->mapped){
+        munmap((void*) mapping->data, mapping->size);
+    } else {
+        free((void*) mapping->data);
+    }
+#else
+    free((void*) mapping->data);
+#endif
+
+    mapping->data   = NULL;
+    mapping->size   = 0;
+    mapping->mapped = false;
+}
+
+uint8_t* ImageDriver::loadImageMapped(const char* fileName, int* sx, int* sy, int* n){
+    imagemapping_t mapping;
+    if(ImageDriver::mapFile(fileName, &mapping) != 0) return NULL;
+
+    Debug::info("[%s:%d]: ID::loadImageMapped: Loading image %s...\n", __FILE__, __LINE__, fileName);
+    uint8_t* px = NULL;
+    if(mapping.size <= INT_MAX){
+        px = (uint8_t*) stbi_load_from_memory(mapping.data, (int) mapping.size, sx, sy, n, 0);
+    }
+    if(px == NULL){
+        Debug::error("[%s:%d]: ID::loadImageMapped: Cannot decode %s: %s\n", __FILE__, __LINE__, fileName, stbi_failure_reason());
+    }
+
+    ImageDriver::unmapFile(&mapping);
+    return px;
+}
+
 void ImageDriver::freeImage(void* image_ptr){
     Debug::info("[%s:%d]: ID::freeImage: Freeing image pointer %p...\n", __FILE__, __LINE__, image_ptr);
     stbi_image_free(image_ptr);
 }
 
+// Case insensitive extension compare (strcasecmp is not portable)
+static bool id_extension_is(const char* extension, const char* lower){
+    while(*extension && *lower){
+        char c = *extension;
+        if(c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        if(c != *lower) return false;
+        extension++;
+        lower++;
+    }
+    return (*extension == 0 && *lower == 0);
+}
+
+int ImageDriver::getImageFormat(const char* fileName){
+    if(fileName == NULL) return IMAGE_FORMAT_UNKNOWN;
+
+    const char* extension = strrchr(fileName, '.');
+    if(extension == NULL || strchr(extension, '/') || strchr(extension, '\\')) return IMAGE_FORMAT_UNKNOWN;
+    extension++;
+
+    if(id_extension_is(extension, "png")) return IMAGE_FORMAT_PNG;
+    if(id_extension_is(extension, "jpg") || id_extension_is(extension, "jpeg")) return IMAGE_FORMAT_JPG;
+    if(id_extension_is(extension, "bmp")) return IMAGE_FORMAT_BMP;
+    if(id_extension_is(extension, "tga")) return IMAGE_FORMAT_TGA;
+    return IMAGE_FORMAT_UNKNOWN;
+}
+
 int ImageDriver::writeImage(const char* fileName, int w, int h, int n, void* data){
     if(data == NULL) return -1;
 
-    // Find last '.' for extension
-    int lenptr = strlen(fileName);
-    while(lenptr > 0){
-        if(fileName[lenptr] == '.') break;
-        lenptr--;
-    }
-
-    if(lenptr != 0){
-        const char* extension = fileName + lenptr;
-        
-        if(strstr(extension, "jpg") || strstr(extension,"jpeg")){
+    int ok = 0;
+    switch(ImageDriver::getImageFormat(fileName)){
+        case IMAGE_FORMAT_JPG:
             Debug::info("[%s:%d]: ID::writeImage: Writing JPG image %s...\n", __FILE__, __LINE__, fileName);
-            stbi_write_jpg(fileName, w, h, n, data, 100);
-            return 0;
-        } else if(strstr(extension, "tga")){
+            ok = stbi_write_jpg(fileName, w, h, n, data, 100);
+            break;
+        case IMAGE_FORMAT_TGA:
             Debug::info("[%s:%d]: ID::writeImage: Writing TGA image %s...\n", __FILE__, __LINE__, fileName);
-            stbi_write_tga(fileName, w, h, n, data);
-            return 0;
-        } else if(strstr(extension, "bmp")){
+            ok = stbi_write_tga(fileName, w, h, n, data);
+            break;
+        case IMAGE_FORMAT_BMP:
             Debug::info("[%s:%d]: ID::writeImage: Writing BMP image %s...\n", __FILE__, __LINE__, fileName);
-            stbi_write_bmp(fileName, w, h, n, data);
-            return 0;
-        } else if(strstr(extension,"png")){
+            ok = stbi_write_bmp(fileName, w, h, n, data);
+            break;
+        case IMAGE_FORMAT_PNG:
             Debug::info("[%s:%d]: ID::writeImage: Writing PNG image %s...\n", __FILE__, __LINE__, fileName);
-            stbi_write_png(fileName, w, h, n, data, 0);
-            return 0;
-        } else {
-            Debug::info("[%s:%d]: ERROR ID::writeImage: Format not supported\n", __FILE__, __LINE__);
+            ok = stbi_write_png(fileName, w, h, n, data, 0);
+            break;
+        default:
+            Debug::error("[%s:%d]: ID::writeImage: Format of %s not supported\n", __FILE__, __LINE__, fileName);
             return -2;
-        }
-    } else {
-        Debug::error("[%s:%d]: ID::writeImage: Cannot determine extension\n", __FILE__, __LINE__);
-        return 1;
     }
 
+    if(!ok){
+        Debug::error("[%s:%d]: ID::writeImage: Cannot write %s\n", __FILE__, __LINE__, fileName);
+        return 1;
+    }
     return 0;
 }
 
@@ -101,18 +332,191 @@ int ImageDriver::writeImage(const char* fileName, int w, int h, int n, void* dat
     if(data == NULL) return -1;
 
     Debug::info("[%s:%d]: ID::writeImage: Writing JPG image %s with quality %d...\n", __FILE__, __LINE__, fileName, q);
-    stbi_write_jpg(fileName, w, h, n, data, q);
+    if(!stbi_write_jpg(fileName, w, h, n, data, q)){
+        Debug::error("[%s:%d]: ID::writeImage: Cannot write %s\n", __FILE__, __LINE__, fileName);
+        return 1;
+    }
     return 0;
 }
 
+int ImageDriver::writeImageToFunc(imagewrite_func_t func, void* context, int format, int w, int h, int n, const void* data, int q){
+    if(func == NULL || data == NULL) return -1;
+
+    int ok = 0;
+    switch(format){
+        case IMAGE_FORMAT_PNG: ok = stbi_write_png_to_func(func, context, w, h, n, data, 0); break;
+        case IMAGE_FORMAT_JPG: ok = stbi_write_jpg_to_func(func, context, w, h, n, data, q); break;
+        case IMAGE_FORMAT_BMP: ok = stbi_write_bmp_to_func(func, context, w, h, n, data);    break;
+        case IMAGE_FORMAT_TGA: ok = stbi_write_tga_to_func(func, context, w, h, n, data);    break;
+        default:
+            Debug::error("[%s:%d]: ID::writeImageToFunc: Format %d not supported\n", __FILE__, __LINE__, format);
+            return -2;
+    }
+    return ok ? 0 : 1;
+}
+
 void ImageDriver::resizingCallback(progress_callback_t callback){
-    ImageDriver::callback_fnc = callback;
+    id_callback = callback;
 }
 
 int ImageDriver::resizeImage(void* input, int in_w, int in_h, void* output, int out_w, int out_h, int n){
+    return ImageDriver::resizeImage(input, in_w, in_h, 0, output, out_w, out_h, 0, n);
+}
+
+int ImageDriver::resizeImage(const void* input, int in_w, int in_h, int in_stride, void* output, int out_w, int out_h, int out_stride, int n){
+    // Same filtering as stbir_resize_uint8 (No alpha weighting, linear)
+    imageresize_t options = ImageDriver::resizeOptions(n);
+    options.alpha_channel = -1;
+    options.progress      = id_legacy_progress;
+    return ImageDriver::resizeImage(input, in_w, in_h, in_stride, output, out_w, out_h, out_stride, n, &options);
+}
+
+imageresize_t ImageDriver::resizeOptions(int n){
+    imageresize_t options;
+    options.flags         = 0;
+    options.alpha_channel = (n == 4) ? 3 : (n == 2) ? 1 : -1;
+    options.threads       = 0;
+    options.progress      = NULL;
+    options.userdata      = NULL;
+    return options;
+}
+
+int ImageDriver::resizeImage(const void* input, int in_w, int in_h, int in_stride, void* output, int out_w, int out_h, int out_stride, int n, const imageresize_t* options){
     if(input == NULL || output == NULL) return 1;
-    
-    Debug::info("[%s:%d]: ID::resizeImage: Resizing image (%dx%d)->(%dx%d)...\n", __FILE__, __LINE__, in_w, in_h, out_w, out_h);
-    stbir_resize_uint8((uint8_t*) input, in_w, in_h, 0, (uint8_t*) output, out_w, out_h, 0, n);
+    if(in_w <= 0 || in_h <= 0 || out_w <= 0 || out_h <= 0 || n < 1 || n > 4) return 1;
+
+    imageresize_t defaults = ImageDriver::resizeOptions(n);
+    if(options == NULL) options = &defaults;
+
+    id_resize_t resize;
+    resize.input      = (const uint8_t*) input;
+    resize.in_w       = in_w;
+    resize.in_h       = in_h;
+    resize.in_stride  = in_stride  ? in_stride  : in_w  * n;
+    resize.output     = (uint8_t*) output;
+    resize.out_w      = out_w;
+    resize.out_h      = out_h;
+    resize.out_stride = out_stride ? out_stride : out_w * n;
+    resize.n          = n;
+    resize.options    = options;
+
+    int threads = options->threads;
+    if(threads <= 0) threads = (int) std::thread::hardware_concurrency();
+    if(threads > ID_MAX_RESIZE_THREADS) threads = ID_MAX_RESIZE_THREADS;
+    if(threads > out_h / ID_MIN_BAND_ROWS) threads = out_h / ID_MIN_BAND_ROWS;
+    if((long) out_w * out_h < ID_MIN_PARALLEL_PIXELS || threads < 1) threads = 1;
+    resize.bands = threads;
+
+    id_band_t   bands[ID_MAX_RESIZE_THREADS];
+    std::thread workers[ID_MAX_RESIZE_THREADS];
+    for(int i = 0; i < resize.bands; i++){
+        resize.rows_done[i] = 0;
+        bands[i].resize = &resize;
+        bands[i].index  = i;
+        bands[i].y0     = (int) (((long) out_h * i) / resize.bands);
+        bands[i].y1     = (int) (((long) out_h * (i + 1)) / resize.bands);
+        bands[i].result = 0;
+    }
+
+    Debug::info("[%s:%d]: ID::resizeImage: Resizing image (%dx%d)->(%dx%d) in %d bands...\n", __FILE__, __LINE__, in_w, in_h, out_w, out_h, resize.bands);
+
+    // Band 0 runs here, the other bands on their own threads
+    int started = 1;
+    for(int i = 1; i < resize.bands; i++){
+        try {
+            workers[i] = std::thread(id_resize_band, &bands[i]);
+            started++;
+        } catch(...){
+            break;
+        }
+    }
+    // Bands without a thread are resized here too
+    for(int i = started; i < resize.bands; i++){
+        id_resize_band(&bands[i]);
+    }
+    id_resize_band(&bands[0]);
+
+    bool ok = bands[0].result != 0;
+    for(int i = 1; i < resize.bands; i++){
+        if(workers[i].joinable()) workers[i].join();
+        ok = ok && bands[i].result != 0;
+    }
+
+    if(!ok){
+        Debug::error("[%s:%d]: ID::resizeImage: Cannot resize image!\n", __FILE__, __LINE__);
+        return 2;
+    }
+    if(options->progress) options->progress(1.f, options->userdata);
     return 0;
-}
\ No newline at end of file
+}
+
+int ImageDriver::getMipLevels(int w, int h){
+    int levels = 1;
+    while((w >> levels) || (h >> levels)) levels++;
+    return levels;
+}
+
+size_t ImageDriver::getMipOffset(int w, int h, int n, int level){
+    size_t offset = 0;
+    for(int i = 0; i < level; i++){
+        size_t level_w = (w >> i) ? (w >> i) : 1;
+        size_t level_h = (h >> i) ? (h >> i) : 1;
+        offset += level_w * level_h * n;
+    }
+    return offset;
+}
+
+// Progress of a mip chain: level progress scaled to its share of the pixels
+struct id_mip_progress_t {
+    const imageresize_t* options;
+    float start, share;
+};
+
+static void id_mip_progress(float progress, void* userdata){
+    id_mip_progress_t* mip = (id_mip_progress_t*) userdata;
+    mip->options->progress(mip->start + progress * mip->share, mip->options->userdata);
+}
+
+uint8_t* ImageDriver::buildMipChain(const void* input, int w, int h, int n, int* levels, const imageresize_t* options){
+    if(input == NULL || w <= 0 || h <= 0 || n < 1 || n > 4) return NULL;
+
+    imageresize_t defaults = ImageDriver::resizeOptions(n);
+    if(options == NULL) options = &defaults;
+
+    int      count = ImageDriver::getMipLevels(w, h);
+    uint8_t* chain = (uint8_t*) malloc(ImageDriver::getMipOffset(w, h, n, count));
+    if(chain == NULL){
+        Debug::error("[%s:%d]: ID::buildMipChain: Cannot allocate the mip chain of a %dx%dx%d image!\n", __FILE__, __LINE__, w, h, n);
+        return NULL;
+    }
+    memcpy(chain, input, (size_t) w * h * n);
+
+    id_mip_progress_t mip     = {options, 0.f, 0.f};
+    imageresize_t     request = *options;
+    float             total   = (float) (ImageDriver::getMipOffset(w, h, n, count) - (size_t) w * h * n);
+    if(options->progress){
+        request.progress = id_mip_progress;
+        request.userdata = &mip;
+    }
+
+    // Half size steps, each level costs a quarter of the one before
+    for(int level = 1; level < count; level++){
+        int prev_w  = (w >> (level - 1)) ? (w >> (level - 1)) : 1;
+        int prev_h  = (h >> (level - 1)) ? (h >> (level - 1)) : 1;
+        int level_w = (w >> level) ? (w >> level) : 1;
+        int level_h = (h >> level) ? (h >> level) : 1;
+
+        const uint8_t* src  = chain + ImageDriver::getMipOffset(w, h, n, level - 1);
+        uint8_t*       dest = chain + ImageDriver::getMipOffset(w, h, n, level);
+
+        mip.share = ((float) level_w * level_h * n) / total;
+        if(ImageDriver::resizeImage(src, prev_w, prev_h, 0, dest, level_w, level_h, 0, n, &request) != 0){
+            free(chain);
+            return NULL;
+        }
+        mip.start += mip.share;
+    }
+
+    if(levels) *levels = count;
+    return chain;
+}
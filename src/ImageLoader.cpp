@@ -0,0 +1,367 @@
+/**
+ * @file ImageLoader.cpp
+ * @author Brais Solla González
+ * @brief Asynchronous image loading implementation for Enyx (SDL2 threads)
+ * @version 0.1
+ * @date 2021-12-05
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+#include "ImageLoader.h"
+#include "ImageDriver.h"
+#include "Platform_SDL2.h"
+#include "JobTable.h"
+#include "Debug.h"
+
+struct imageloader_job_t {
+    // 0 = free slot (JobTable)
+    uint16_t generation;
+    int      state;
+    // Released by the user while queued / loading. The worker frees the slot
+    bool     cancelled;
+
+    char*    fileName;
+    imageloader_callback_t callback;
+    void*    userdata;
+
+    // Result (ImageDriver allocated)
+    uint8_t* px;
+    int      width, height, components;
+};
+
+static SDL_mutex*  il_mutex   = NULL;
+// Signaled when a job is queued / finished
+static SDL_cond*   il_queued  = NULL;
+static SDL_cond*   il_done    = NULL;
+static SDL_Thread* il_workers[IMAGELOADER_MAX_WORKERS];
+static int         il_worker_count = 0;
+static bool        il_running      = false;
+
+static JobTable<imageloader_job_t> il_jobs     = {NULL, 0, 0};
+// Queued jobs / finished jobs with a callback
+static JobFifo                     il_queue    = {NULL, 0, 0, 0};
+static JobFifo                     il_finished = {NULL, 0, 0, 0};
+// Queued + loading
+static int                         il_pending  = 0;
+
+
+// Job of a handle, NULL if the handle is not valid anymore. Called with il_mutex locked
+static imageloader_job_t* getJob(imagehandle_t handle){
+    return il_jobs.get(handle);
+}
+
+static imagehandle_t newJob(const char* fileName, imageloader_callback_t callback, void* userdata){
+    int slot = il_jobs.findFree();
+    if(slot == -1) slot = il_jobs.grow();
+    if(slot == -1) return 0;
+
+    char* name = strdup(fileName);
+    if(name == NULL) return 0;
+
+    imagehandle_t      handle = il_jobs.claim(slot);
+    imageloader_job_t* job    = &il_jobs.jobs[slot];
+    job->state      = IMAGELOADER_QUEUED;
+    job->cancelled  = false;
+    job->fileName   = name;
+    job->callback   = callback;
+    job->userdata   = userdata;
+    job->px         = NULL;
+    job->width      = 0;
+    job->height     = 0;
+    job->components = 0;
+
+    return handle;
+}
+
+static void freeJob(imageloader_job_t* job){
+    if(job->px) ImageDriver::freeImage(job->px);
+    ::free(job->fileName);
+    memset(job, 0, sizeof(imageloader_job_t));
+}
+
+// Move the result of a finished job to a pixmap and free the job
+static Pixmap takeJob(imageloader_job_t* job){
+    Pixmap pixmap;
+    if(job->px){
+        pixmap = Pixmap(job->px, job->width, job->height, job->components, PIXMAP_LOADER_IMAGEDRIVER);
+        job->px = NULL;
+    }
+    freeJob(job);
+    return pixmap;
+}
+
+// Decode a job (Any thread, il_mutex NOT locked). Results are stored with the mutex locked
+static void runJob(imagehandle_t handle, const char* fileName){
+    int width = 0, height = 0, components = 0;
+    // Decoded from a mapping of the file, no stdio reads
+    uint8_t* px = ImageDriver::loadImageMapped(fileName, &width, &height, &components);
+    if(px == NULL){
+        Debug::error("[%s:%d]: Cannot load image %s!\n", __FILE__, __LINE__, fileName);
+    }
+
+    SDL_LockMutex(il_mutex);
+    imageloader_job_t* job = getJob(handle);
+    if(job->cancelled){
+        if(px) ImageDriver::freeImage(px);
+        freeJob(job);
+    } else {
+        job->px         = px;
+        job->width      = width;
+        job->height     = height;
+        job->components = components;
+        job->state      = px ? IMAGELOADER_DONE : IMAGELOADER_FAILED;
+
+        if(job->callback && !il_finished.push(handle)){
+            Debug::error("[%s:%d]: Cannot queue the callback of image %s!\n", __FILE__, __LINE__, fileName);
+        }
+    }
+    il_pending--;
+    SDL_CondBroadcast(il_done);
+    SDL_UnlockMutex(il_mutex);
+}
+
+static int workerMain(void* data){
+    SDL_LockMutex(il_mutex);
+    while(true){
+        while(il_running && il_queue.count == 0) SDL_CondWait(il_queued, il_mutex);
+        if(!il_running) break;
+
+        imagehandle_t      handle = il_queue.pop();
+        imageloader_job_t* job    = getJob(handle);
+        if(job->cancelled){
+            freeJob(job);
+            il_pending--;
+            SDL_CondBroadcast(il_done);
+            continue;
+        }
+
+        // fileName is not freed until the job is, and only this worker can free it now
+        job->state = IMAGELOADER_LOADING;
+        const char* fileName = job->fileName;
+        SDL_UnlockMutex(il_mutex);
+
+        runJob(handle, fileName);
+
+        SDL_LockMutex(il_mutex);
+    }
+    SDL_UnlockMutex(il_mutex);
+    return 0;
+}
+
+
+int ImageLoader::init(int workers){
+    if(il_mutex){
+        Debug::warning("[%s:%d]: ImageLoader already initialized!\n", __FILE__, __LINE__);
+        return 0;
+    }
+
+    if(workers <= 0) workers = System::getCPUCount();
+    if(workers <= 0) workers = 1;
+    if(workers > IMAGELOADER_MAX_WORKERS) workers = IMAGELOADER_MAX_WORKERS;
+
+    il_mutex  = SDL_CreateMutex();
+    il_queued = SDL_CreateCond();
+    il_done   = SDL_CreateCond();
+    if(il_mutex == NULL || il_queued == NULL || il_done == NULL){
+        Debug::error("[%s:%d]: Cannot create ImageLoader locks: %s\n", __FILE__, __LINE__, SDL_GetError());
+        if(il_mutex)  SDL_DestroyMutex(il_mutex);
+        if(il_queued) SDL_DestroyCond(il_queued);
+        if(il_done)   SDL_DestroyCond(il_done);
+        il_mutex  = NULL;
+        il_queued = NULL;
+        il_done   = NULL;
+        return 1;
+    }
+
+    il_running      = true;
+    il_worker_count = 0;
+    for(int i = 0; i < workers; i++){
+        SDL_Thread* thread = SDL_CreateThread(workerMain, "EnyxImageLoader", NULL);
+        if(thread == NULL){
+            Debug::warning("[%s:%d]: Cannot create image loader thread %d: %s\n", __FILE__, __LINE__, i, SDL_GetError());
+            break;
+        }
+        il_workers[il_worker_count++] = thread;
+    }
+
+    Debug::info("[%s:%d]: ImageLoader started with %d workers\n", __FILE__, __LINE__, il_worker_count);
+    return 0;
+}
+
+void ImageLoader::destroy(){
+    if(il_mutex == NULL) return;
+
+    SDL_LockMutex(il_mutex);
+    il_running = false;
+    SDL_CondBroadcast(il_queued);
+    SDL_UnlockMutex(il_mutex);
+
+    for(int i = 0; i < il_worker_count; i++) SDL_WaitThread(il_workers[i], NULL);
+    il_worker_count = 0;
+
+    // Nothing else runs now
+    for(int i = 0; i < il_jobs.size; i++){
+        if(il_jobs.jobs[i].generation) freeJob(&il_jobs.jobs[i]);
+    }
+    il_jobs.release();
+    il_pending = 0;
+
+    il_queue.release();
+    il_finished.release();
+
+    SDL_DestroyCond(il_queued);
+    SDL_DestroyCond(il_done);
+    SDL_DestroyMutex(il_mutex);
+    il_mutex  = NULL;
+    il_queued = NULL;
+    il_done   = NULL;
+}
+
+imagehandle_t ImageLoader::load(const char* fileName){
+    return ImageLoader::load(fileName, NULL, NULL);
+}
+
+imagehandle_t ImageLoader::load(const char* fileName, imageloader_callback_t callback, void* userdata){
+    if(fileName == NULL) return 0;
+    if(il_mutex == NULL){
+        Debug::error("[%s:%d]: ImageLoader not initialized, cannot load %s!\n", __FILE__, __LINE__, fileName);
+        return 0;
+    }
+
+    SDL_LockMutex(il_mutex);
+    imagehandle_t handle = newJob(fileName, callback, userdata);
+    if(handle == 0){
+        SDL_UnlockMutex(il_mutex);
+        Debug::error("[%s:%d]: Cannot queue image %s!\n", __FILE__, __LINE__, fileName);
+        return 0;
+    }
+
+    il_pending++;
+    if(il_worker_count == 0){
+        // No threads, load it here
+        imageloader_job_t* job = getJob(handle);
+        job->state = IMAGELOADER_LOADING;
+        const char* name = job->fileName;
+        SDL_UnlockMutex(il_mutex);
+
+        runJob(handle, name);
+        return handle;
+    }
+
+    if(!il_queue.push(handle)){
+        freeJob(getJob(handle));
+        il_pending--;
+        SDL_UnlockMutex(il_mutex);
+        Debug::error("[%s:%d]: Cannot queue image %s!\n", __FILE__, __LINE__, fileName);
+        return 0;
+    }
+    SDL_CondSignal(il_queued);
+    SDL_UnlockMutex(il_mutex);
+    return handle;
+}
+
+int ImageLoader::getState(imagehandle_t handle){
+    if(il_mutex == NULL) return IMAGELOADER_INVALID;
+
+    SDL_LockMutex(il_mutex);
+    imageloader_job_t* job = getJob(handle);
+    int state = (job && !job->cancelled) ? job->state : IMAGELOADER_INVALID;
+    SDL_UnlockMutex(il_mutex);
+    return state;
+}
+
+bool ImageLoader::isReady(imagehandle_t handle){
+    int state = ImageLoader::getState(handle);
+    return (state == IMAGELOADER_DONE || state == IMAGELOADER_FAILED);
+}
+
+Pixmap ImageLoader::take(imagehandle_t handle){
+    Pixmap pixmap;
+    if(il_mutex == NULL) return pixmap;
+
+    SDL_LockMutex(il_mutex);
+    imageloader_job_t* job = getJob(handle);
+    if(job && !job->cancelled && (job->state == IMAGELOADER_DONE || job->state == IMAGELOADER_FAILED)){
+        // A callback job taken here is skipped by dispatch() (Its handle is not valid anymore)
+        pixmap = takeJob(job);
+    }
+    SDL_UnlockMutex(il_mutex);
+    return pixmap;
+}
+
+Pixmap ImageLoader::wait(imagehandle_t handle){
+    if(il_mutex == NULL) return Pixmap();
+
+    SDL_LockMutex(il_mutex);
+    imageloader_job_t* job = getJob(handle);
+    while(job && !job->cancelled && (job->state == IMAGELOADER_QUEUED || job->state == IMAGELOADER_LOADING)){
+        SDL_CondWait(il_done, il_mutex);
+        // The table may have been reallocated
+        job = getJob(handle);
+    }
+    SDL_UnlockMutex(il_mutex);
+
+    return ImageLoader::take(handle);
+}
+
+void ImageLoader::cancel(imagehandle_t handle){
+    if(il_mutex == NULL) return;
+
+    SDL_LockMutex(il_mutex);
+    imageloader_job_t* job = getJob(handle);
+    if(job){
+        if(job->state == IMAGELOADER_QUEUED || job->state == IMAGELOADER_LOADING){
+            // Still owned by the queue / a worker
+            job->cancelled = true;
+        } else {
+            freeJob(job);
+        }
+    }
+    SDL_UnlockMutex(il_mutex);
+}
+
+int ImageLoader::dispatch(int max){
+    if(il_mutex == NULL) return 0;
+
+    int called = 0;
+    SDL_LockMutex(il_mutex);
+    while(il_finished.count > 0 && (max <= 0 || called < max)){
+        imagehandle_t      handle = il_finished.pop();
+        imageloader_job_t* job    = getJob(handle);
+        // Taken or cancelled before
+        if(job == NULL) continue;
+
+        imageloader_callback_t callback = job->callback;
+        void*  userdata = job->userdata;
+        Pixmap pixmap   = takeJob(job);
+
+        // The callback may load more images
+        SDL_UnlockMutex(il_mutex);
+        callback(handle, pixmap, userdata);
+        called++;
+        SDL_LockMutex(il_mutex);
+    }
+    SDL_UnlockMutex(il_mutex);
+    return called;
+}
+
+int ImageLoader::getPending(){
+    if(il_mutex == NULL) return 0;
+
+    SDL_LockMutex(il_mutex);
+    int pending = il_pending;
+    SDL_UnlockMutex(il_mutex);
+    return pending;
+}
+
+int ImageLoader::getWorkers(){
+    return il_worker_count;
+}
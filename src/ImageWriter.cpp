@@ -0,0 +1,479 @@
+/**
+ * @file ImageWriter.cpp
+ * @author Brais Solla González
+ * @brief Background image encoding implementation for Enyx (SDL2 thread)
+ * @version 0.1
+ * @date 2021-12-07
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+#include "ImageWriter.h"
+#include "ImageDriver.h"
+#include "JobTable.h"
+#include "Debug.h"
+
+struct imagewriter_job_t {
+    // 0 = free slot (JobTable)
+    uint16_t generation;
+    int      state;
+    // Released by the user while queued / writing. The encoder frees the slot
+    bool     cancelled;
+
+    char*    fileName;
+    // IMAGE_FORMAT, parsed once in newJob
+    int      format;
+    int      width, height, components;
+    int      quality, flags;
+
+    // Pixels: a pixmap given to save(), or a buffer filled by writeRows() / the row callback
+    Pixmap*  pixmap;
+    uint8_t* px;
+    // Rows received by writeRows()
+    int      rows;
+
+    imagewriter_row_t callback;
+    void*    userdata;
+};
+
+// Output of one image (stbi_write_*_to_func)
+struct imagewriter_output_t {
+    FILE*  file;
+    size_t bytes;
+    bool   ok;
+};
+
+static SDL_mutex*  iw_mutex  = NULL;
+// Signaled when a job is queued / finished
+static SDL_cond*   iw_queued = NULL;
+static SDL_cond*   iw_done   = NULL;
+static SDL_Thread* iw_thread = NULL;
+static bool        iw_running = false;
+
+static JobTable<imagewriter_job_t> iw_jobs    = {NULL, 0, 0};
+// FIFO of queued handles
+static JobFifo                     iw_queue   = {NULL, 0, 0, 0};
+// Queued + writing
+static int                         iw_pending = 0;
+
+
+// Job of a handle, NULL if the handle is not valid anymore. Called with iw_mutex locked
+static imagewriter_job_t* getJob(imagewrite_t handle){
+    return iw_jobs.get(handle);
+}
+
+// Release the pixels of a job, the result is kept
+static void releasePixels(imagewriter_job_t* job){
+    delete job->pixmap;
+    ::free(job->px);
+    job->pixmap = NULL;
+    job->px     = NULL;
+}
+
+static void freeJob(imagewriter_job_t* job){
+    releasePixels(job);
+    ::free(job->fileName);
+    memset(job, 0, sizeof(imagewriter_job_t));
+}
+
+static imagewrite_t newJob(const char* fileName, int width, int height, int components, int quality){
+    int format = ImageDriver::getImageFormat(fileName);
+    if(format == IMAGE_FORMAT_UNKNOWN){
+        Debug::error("[%s:%d]: Cannot save %s, unknown image format!\n", __FILE__, __LINE__, fileName);
+        return 0;
+    }
+    if(width <= 0 || height <= 0 || components < 1 || components > 4){
+        Debug::error("[%s:%d]: Cannot save %s, bad image size (%dx%dx%d)!\n", __FILE__, __LINE__, fileName, width, height, components);
+        return 0;
+    }
+
+    // Free slot first, then the slot of a finished image (Its result is forgotten)
+    int slot = iw_jobs.findFree();
+    for(int i = 0; i < iw_jobs.size && slot == -1; i++){
+        if(iw_jobs.jobs[i].state == IMAGEWRITER_DONE || iw_jobs.jobs[i].state == IMAGEWRITER_FAILED){
+            freeJob(&iw_jobs.jobs[i]);
+            slot = i;
+        }
+    }
+    if(slot == -1) slot = iw_jobs.grow();
+    if(slot == -1) return 0;
+
+    char* name = strdup(fileName);
+    if(name == NULL) return 0;
+
+    imagewrite_t       handle = iw_jobs.claim(slot);
+    imagewriter_job_t* job    = &iw_jobs.jobs[slot];
+    job->state      = IMAGEWRITER_QUEUED;
+    job->cancelled  = false;
+    job->fileName   = name;
+    job->format     = format;
+    job->width      = width;
+    job->height     = height;
+    job->components = components;
+    job->quality    = (quality > 0) ? quality : IMAGEWRITER_DEFAULT_QUALITY;
+    job->flags      = 0;
+    job->pixmap     = NULL;
+    job->px         = NULL;
+    job->rows       = 0;
+    job->callback   = NULL;
+    job->userdata   = NULL;
+
+    return handle;
+}
+
+static void writeOutput(void* context, void* data, int size){
+    imagewriter_output_t* output = (imagewriter_output_t*) context;
+    if(!output->ok) return;
+
+    if(fwrite(data, 1, size, output->file) != (size_t) size) output->ok = false;
+    output->bytes += size;
+}
+
+// Encode a job (Encoder thread or the caller without one, iw_mutex NOT locked).
+// A job being written is only read here, cancel() just flags it
+static void runJob(imagewrite_t handle){
+    SDL_LockMutex(iw_mutex);
+    imagewriter_job_t  job = *getJob(handle);
+    SDL_UnlockMutex(iw_mutex);
+
+    bool     ok = true;
+    uint8_t* px = job.pixmap ? (uint8_t*) job.pixmap->getPixels() : job.px;
+
+    if(job.callback){
+        // stbi_write_* takes the whole image, so the rows are gathered in one buffer here.
+        // The callback only moves the copy off the render thread, it does not save memory
+        size_t row_size = (size_t) job.width * job.components;
+        px = (uint8_t*) malloc(row_size * job.height);
+        ok = (px != NULL);
+        for(int y = 0; y < job.height && ok; y++) ok = job.callback(y, px + row_size * y, job.userdata);
+        if(!ok) Debug::error("[%s:%d]: Cannot get the rows of image %s!\n", __FILE__, __LINE__, job.fileName);
+    }
+
+    if(ok){
+        imagewriter_output_t output = {fopen(job.fileName, "wb"), 0, true};
+        if(output.file == NULL){
+            Debug::error("[%s:%d]: Cannot create image file %s!\n", __FILE__, __LINE__, job.fileName);
+            ok = false;
+        } else {
+            ok = ImageDriver::writeImageToFunc(writeOutput, &output, job.format, job.width, job.height, job.components, px, job.quality) == 0;
+            ok = (fclose(output.file) == 0) && ok && output.ok;
+
+            if(ok){
+                Debug::info("[%s:%d]: Image %s written (%dx%dx%d, %lu bytes)\n", __FILE__, __LINE__, job.fileName, job.width, job.height, job.components, (unsigned long) output.bytes);
+            } else {
+                Debug::error("[%s:%d]: Cannot write image %s!\n", __FILE__, __LINE__, job.fileName);
+                remove(job.fileName);
+            }
+        }
+    }
+    if(job.callback) ::free(px);
+
+    SDL_LockMutex(iw_mutex);
+    imagewriter_job_t* current = getJob(handle);
+    if(current->cancelled){
+        freeJob(current);
+    } else {
+        releasePixels(current);
+        current->state = ok ? IMAGEWRITER_DONE : IMAGEWRITER_FAILED;
+    }
+    iw_pending--;
+    SDL_CondBroadcast(iw_done);
+    SDL_UnlockMutex(iw_mutex);
+}
+
+static int encoderMain(void* data){
+    SDL_LockMutex(iw_mutex);
+    while(true){
+        // Queued images are written before stopping
+        while(iw_running && iw_queue.count == 0) SDL_CondWait(iw_queued, iw_mutex);
+        if(iw_queue.count == 0) break;
+
+        imagewrite_t       handle = iw_queue.pop();
+        imagewriter_job_t* job    = getJob(handle);
+        if(job->cancelled){
+            freeJob(job);
+            iw_pending--;
+            SDL_CondBroadcast(iw_done);
+            continue;
+        }
+
+        job->state = IMAGEWRITER_WRITING;
+        SDL_UnlockMutex(iw_mutex);
+
+        runJob(handle);
+
+        SDL_LockMutex(iw_mutex);
+    }
+    SDL_UnlockMutex(iw_mutex);
+    return 0;
+}
+
+// Queue a complete job. Called with iw_mutex locked, returns with it unlocked
+static imagewrite_t queueJob(imagewrite_t handle){
+    imagewriter_job_t* job = getJob(handle);
+    job->state = IMAGEWRITER_QUEUED;
+    iw_pending++;
+
+    if(iw_thread == NULL){
+        // No thread, write it here
+        job->state = IMAGEWRITER_WRITING;
+        SDL_UnlockMutex(iw_mutex);
+
+        runJob(handle);
+        return handle;
+    }
+
+    if(!iw_queue.push(handle)){
+        Debug::error("[%s:%d]: Cannot queue image %s!\n", __FILE__, __LINE__, job->fileName);
+        freeJob(job);
+        iw_pending--;
+        SDL_UnlockMutex(iw_mutex);
+        return 0;
+    }
+    SDL_CondSignal(iw_queued);
+    SDL_UnlockMutex(iw_mutex);
+    return handle;
+}
+
+
+int ImageWriter::init(){
+    if(iw_mutex){
+        Debug::warning("[%s:%d]: ImageWriter already initialized!\n", __FILE__, __LINE__);
+        return 0;
+    }
+
+    iw_mutex  = SDL_CreateMutex();
+    iw_queued = SDL_CreateCond();
+    iw_done   = SDL_CreateCond();
+    if(iw_mutex == NULL || iw_queued == NULL || iw_done == NULL){
+        Debug::error("[%s:%d]: Cannot create ImageWriter locks: %s\n", __FILE__, __LINE__, SDL_GetError());
+        if(iw_mutex)  SDL_DestroyMutex(iw_mutex);
+        if(iw_queued) SDL_DestroyCond(iw_queued);
+        if(iw_done)   SDL_DestroyCond(iw_done);
+        iw_mutex  = NULL;
+        iw_queued = NULL;
+        iw_done   = NULL;
+        return 1;
+    }
+
+    iw_running = true;
+    iw_thread  = SDL_CreateThread(encoderMain, "EnyxImageWriter", NULL);
+    if(iw_thread == NULL){
+        Debug::warning("[%s:%d]: Cannot create image writer thread, images are written when saved: %s\n", __FILE__, __LINE__, SDL_GetError());
+    }
+
+    Debug::info("[%s:%d]: ImageWriter started\n", __FILE__, __LINE__);
+    return 0;
+}
+
+void ImageWriter::destroy(){
+    if(iw_mutex == NULL) return;
+
+    SDL_LockMutex(iw_mutex);
+    iw_running = false;
+    SDL_CondBroadcast(iw_queued);
+    SDL_UnlockMutex(iw_mutex);
+
+    if(iw_thread) SDL_WaitThread(iw_thread, NULL);
+    iw_thread = NULL;
+
+    // Nothing else runs now
+    for(int i = 0; i < iw_jobs.size; i++){
+        imagewriter_job_t* job = &iw_jobs.jobs[i];
+        if(job->generation == 0) continue;
+        if(job->state == IMAGEWRITER_FILLING){
+            Debug::warning("[%s:%d]: Image %s dropped, %d of %d rows given\n", __FILE__, __LINE__, job->fileName, job->rows, job->height);
+        }
+        freeJob(job);
+    }
+    iw_jobs.release();
+    iw_pending = 0;
+
+    iw_queue.release();
+
+    SDL_DestroyCond(iw_queued);
+    SDL_DestroyCond(iw_done);
+    SDL_DestroyMutex(iw_mutex);
+    iw_mutex  = NULL;
+    iw_queued = NULL;
+    iw_done   = NULL;
+}
+
+imagewrite_t ImageWriter::save(const char* fileName, Pixmap&& pixmap, int quality){
+    if(fileName == NULL || !pixmap.exists()) return 0;
+    if(iw_mutex == NULL){
+        Debug::error("[%s:%d]: ImageWriter not initialized, cannot save %s!\n", __FILE__, __LINE__, fileName);
+        return 0;
+    }
+
+    // Allocated before locking, the pixels are moved (Not copied)
+    Pixmap* owned = new Pixmap(static_cast<Pixmap&&>(pixmap));
+
+    SDL_LockMutex(iw_mutex);
+    imagewrite_t handle = newJob(fileName, owned->getWidth(), owned->getHeight(), owned->getComponents(), quality);
+    if(handle == 0){
+        SDL_UnlockMutex(iw_mutex);
+        // Given back, the caller still has its image
+        pixmap = static_cast<Pixmap&&>(*owned);
+        delete owned;
+        return 0;
+    }
+
+    getJob(handle)->pixmap = owned;
+    return queueJob(handle);
+}
+
+imagewrite_t ImageWriter::save(const char* fileName, const Pixmap& pixmap, int quality){
+    return ImageWriter::save(fileName, Pixmap(pixmap), quality);
+}
+
+imagewrite_t ImageWriter::save(const char* fileName, int width, int height, int components, imagewriter_row_t callback, void* userdata, int quality){
+    if(fileName == NULL || callback == NULL) return 0;
+    if(iw_mutex == NULL){
+        Debug::error("[%s:%d]: ImageWriter not initialized, cannot save %s!\n", __FILE__, __LINE__, fileName);
+        return 0;
+    }
+
+    SDL_LockMutex(iw_mutex);
+    imagewrite_t handle = newJob(fileName, width, height, components, quality);
+    if(handle == 0){
+        SDL_UnlockMutex(iw_mutex);
+        return 0;
+    }
+
+    imagewriter_job_t* job = getJob(handle);
+    job->callback = callback;
+    job->userdata = userdata;
+    return queueJob(handle);
+}
+
+imagewrite_t ImageWriter::begin(const char* fileName, int width, int height, int components, int flags, int quality){
+    if(fileName == NULL) return 0;
+    if(iw_mutex == NULL){
+        Debug::error("[%s:%d]: ImageWriter not initialized, cannot save %s!\n", __FILE__, __LINE__, fileName);
+        return 0;
+    }
+
+    SDL_LockMutex(iw_mutex);
+    imagewrite_t handle = newJob(fileName, width, height, components, quality);
+    if(handle == 0){
+        SDL_UnlockMutex(iw_mutex);
+        return 0;
+    }
+
+    // The rows are stored in the buffer the encoder reads, one copy of the image in total
+    imagewriter_job_t* job = getJob(handle);
+    job->px = (uint8_t*) malloc((size_t) width * height * components);
+    if(job->px == NULL){
+        Debug::error("[%s:%d]: Cannot allocate %dx%dx%d image %s!\n", __FILE__, __LINE__, width, height, components, fileName);
+        freeJob(job);
+        SDL_UnlockMutex(iw_mutex);
+        return 0;
+    }
+    job->state = IMAGEWRITER_FILLING;
+    job->flags = flags;
+    SDL_UnlockMutex(iw_mutex);
+    return handle;
+}
+
+int ImageWriter::writeRows(imagewrite_t handle, const void* pixels, int rows, int stride){
+    if(iw_mutex == NULL || pixels == NULL || rows <= 0) return -1;
+
+    SDL_LockMutex(iw_mutex);
+    imagewriter_job_t* job = getJob(handle);
+    if(job == NULL || job->state != IMAGEWRITER_FILLING || rows > job->height - job->rows){
+        SDL_UnlockMutex(iw_mutex);
+        Debug::error("[%s:%d]: Cannot write %d rows to image handle %08x!\n", __FILE__, __LINE__, rows, handle);
+        return -1;
+    }
+
+    size_t         row_size = (size_t) job->width * job->components;
+    const uint8_t* src      = (const uint8_t*) pixels;
+    if(stride <= 0) stride = (int) row_size;
+
+    for(int i = 0; i < rows; i++){
+        int y = job->rows + i;
+        if(job->flags & IMAGEWRITER_FLIP_Y) y = job->height - 1 - y;
+        memcpy(job->px + row_size * y, src + (size_t) stride * i, row_size);
+    }
+    job->rows += rows;
+
+    int missing = job->height - job->rows;
+    if(missing == 0){
+        // Last rows, queue it
+        return queueJob(handle) ? 0 : -1;
+    }
+    SDL_UnlockMutex(iw_mutex);
+    return missing;
+}
+
+int ImageWriter::getState(imagewrite_t handle){
+    if(iw_mutex == NULL) return IMAGEWRITER_INVALID;
+
+    SDL_LockMutex(iw_mutex);
+    imagewriter_job_t* job = getJob(handle);
+    int state = (job && !job->cancelled) ? job->state : IMAGEWRITER_INVALID;
+    SDL_UnlockMutex(iw_mutex);
+    return state;
+}
+
+bool ImageWriter::wait(imagewrite_t handle){
+    if(iw_mutex == NULL) return false;
+
+    SDL_LockMutex(iw_mutex);
+    imagewriter_job_t* job = getJob(handle);
+    if(job && job->state == IMAGEWRITER_FILLING){
+        SDL_UnlockMutex(iw_mutex);
+        Debug::warning("[%s:%d]: Image %08x is waiting for rows, not written yet!\n", __FILE__, __LINE__, handle);
+        return false;
+    }
+
+    while(job && !job->cancelled && (job->state == IMAGEWRITER_QUEUED || job->state == IMAGEWRITER_WRITING)){
+        SDL_CondWait(iw_done, iw_mutex);
+        // The table may have been reallocated
+        job = getJob(handle);
+    }
+    bool written = job && !job->cancelled && job->state == IMAGEWRITER_DONE;
+    SDL_UnlockMutex(iw_mutex);
+    return written;
+}
+
+void ImageWriter::cancel(imagewrite_t handle){
+    if(iw_mutex == NULL) return;
+
+    SDL_LockMutex(iw_mutex);
+    imagewriter_job_t* job = getJob(handle);
+    if(job){
+        if(job->state == IMAGEWRITER_QUEUED || job->state == IMAGEWRITER_WRITING){
+            // Still owned by the queue / the encoder
+            job->cancelled = true;
+        } else {
+            freeJob(job);
+        }
+    }
+    SDL_UnlockMutex(iw_mutex);
+}
+
+void ImageWriter::flush(){
+    if(iw_mutex == NULL) return;
+
+    SDL_LockMutex(iw_mutex);
+    while(iw_pending > 0) SDL_CondWait(iw_done, iw_mutex);
+    SDL_UnlockMutex(iw_mutex);
+}
+
+int ImageWriter::getPending(){
+    if(iw_mutex == NULL) return 0;
+
+    SDL_LockMutex(iw_mutex);
+    int pending = iw_pending;
+    SDL_UnlockMutex(iw_mutex);
+    return pending;
+}
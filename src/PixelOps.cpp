@@ -0,0 +1,389 @@
+/**
+ * @file PixelOps.cpp
+ * @author Brais Solla González
+ * @brief Bulk pixel operations (SIMD kernels) implementation
+ * @version 0.1
+ * @date 2021-12-04
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "SIMD.h"
+#include "PixelOps.h"
+
+// Bytes of the fill pattern. Whole pixels of 1, 2, 3 and 4 components, three AVX2 / six SSE2 vectors
+#define FILL_PATTERN_SIZE 96
+// Bytes swapped at a time by the scalar swapRows
+#define SWAP_CHUNK_SIZE   256
+
+// x / 255, rounded. Exact for x <= 65025 (255 * 255)
+static inline uint8_t div255(uint32_t x){
+    x += 128;
+    return (uint8_t) ((x + (x >> 8)) >> 8);
+}
+
+// Same as div255() for 16 bit lanes
+#if defined(ENYX_SIMD_AVX2)
+static inline __m256i div255_avx2(__m256i x){
+    x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+#endif
+
+#if defined(ENYX_SIMD_SSE2)
+static inline __m128i div255_sse2(__m128i x){
+    x = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+#endif
+
+#if defined(ENYX_SIMD_NEON)
+// (s * a + d * inv) / 255 for 16 pixels of one channel
+static inline uint8x16_t blend_neon(uint8x16_t s, uint8x16_t d, uint8x16_t a, uint8x16_t inv){
+    uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(s),  vget_low_u8(a)),  vget_low_u8(d),  vget_low_u8(inv));
+    uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(s), vget_high_u8(a)), vget_high_u8(d), vget_high_u8(inv));
+
+    lo = vaddq_u16(lo, vdupq_n_u16(128));
+    hi = vaddq_u16(hi, vdupq_n_u16(128));
+    lo = vaddq_u16(lo, vshrq_n_u16(lo, 8));
+    hi = vaddq_u16(hi, vshrq_n_u16(hi, 8));
+
+    return vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+}
+#endif
+
+
+void PixelOps::fill(void* dest, const uint8_t* pixel, int components, size_t count){
+    uint8_t* dst   = (uint8_t*) dest;
+    size_t   bytes = count * components;
+
+    if(components == 1){
+        memset(dst, pixel[0], bytes);
+        return;
+    }
+
+    uint8_t pattern[FILL_PATTERN_SIZE];
+    for(int i = 0; i < FILL_PATTERN_SIZE; i++) pattern[i] = pixel[i % components];
+
+    size_t i = 0;
+#if defined(ENYX_SIMD_AVX2)
+    __m256i v0 = _mm256_loadu_si256((const __m256i*) (pattern + 0));
+    __m256i v1 = _mm256_loadu_si256((const __m256i*) (pattern + 32));
+    __m256i v2 = _mm256_loadu_si256((const __m256i*) (pattern + 64));
+
+    for(; i + 96 <= bytes; i += 96){
+        _mm256_storeu_si256((__m256i*) (dst + i + 0),  v0);
+        _mm256_storeu_si256((__m256i*) (dst + i + 32), v1);
+        _mm256_storeu_si256((__m256i*) (dst + i + 64), v2);
+    }
+#elif defined(ENYX_SIMD_SSE2)
+    __m128i v0 = _mm_loadu_si128((const __m128i*) (pattern + 0));
+    __m128i v1 = _mm_loadu_si128((const __m128i*) (pattern + 16));
+    __m128i v2 = _mm_loadu_si128((const __m128i*) (pattern + 32));
+
+    for(; i + 48 <= bytes; i += 48){
+        _mm_storeu_si128((__m128i*) (dst + i + 0),  v0);
+        _mm_storeu_si128((__m128i*) (dst + i + 16), v1);
+        _mm_storeu_si128((__m128i*) (dst + i + 32), v2);
+    }
+#elif defined(ENYX_SIMD_NEON)
+    uint8x16_t v0 = vld1q_u8(pattern + 0);
+    uint8x16_t v1 = vld1q_u8(pattern + 16);
+    uint8x16_t v2 = vld1q_u8(pattern + 32);
+
+    for(; i + 48 <= bytes; i += 48){
+        vst1q_u8(dst + i + 0,  v0);
+        vst1q_u8(dst + i + 16, v1);
+        vst1q_u8(dst + i + 32, v2);
+    }
+#endif
+    // Scalar path and tail. i is always a multiple of 48, the pattern starts over
+    for(; i + FILL_PATTERN_SIZE <= bytes; i += FILL_PATTERN_SIZE){
+        memcpy(dst + i, pattern, FILL_PATTERN_SIZE);
+    }
+    memcpy(dst + i, pattern, bytes - i);
+}
+
+void PixelOps::swapRows(void* a, void* b, size_t bytes){
+    uint8_t* pa = (uint8_t*) a;
+    uint8_t* pb = (uint8_t*) b;
+
+    size_t i = 0;
+#if defined(ENYX_SIMD_AVX2)
+    for(; i + 32 <= bytes; i += 32){
+        __m256i va = _mm256_loadu_si256((const __m256i*) (pa + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*) (pb + i));
+        _mm256_storeu_si256((__m256i*) (pa + i), vb);
+        _mm256_storeu_si256((__m256i*) (pb + i), va);
+    }
+#elif defined(ENYX_SIMD_SSE2)
+    for(; i + 16 <= bytes; i += 16){
+        __m128i va = _mm_loadu_si128((const __m128i*) (pa + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*) (pb + i));
+        _mm_storeu_si128((__m128i*) (pa + i), vb);
+        _mm_storeu_si128((__m128i*) (pb + i), va);
+    }
+#elif defined(ENYX_SIMD_NEON)
+    for(; i + 16 <= bytes; i += 16){
+        uint8x16_t va = vld1q_u8(pa + i);
+        uint8x16_t vb = vld1q_u8(pb + i);
+        vst1q_u8(pa + i, vb);
+        vst1q_u8(pb + i, va);
+    }
+#endif
+    // Scalar path and tail, memcpy through a small buffer
+    uint8_t tmp[SWAP_CHUNK_SIZE];
+    while(i < bytes){
+        size_t chunk = bytes - i;
+        if(chunk > SWAP_CHUNK_SIZE) chunk = SWAP_CHUNK_SIZE;
+
+        memcpy(tmp,    pa + i, chunk);
+        memcpy(pa + i, pb + i, chunk);
+        memcpy(pb + i, tmp,    chunk);
+        i += chunk;
+    }
+}
+
+void PixelOps::mirrorRow(void* row, int components, size_t count){
+    if(count < 2) return;
+
+    if(components == 4){
+        uint32_t* p = (uint32_t*) row;
+        size_t    l = 0;
+        size_t    r = count;
+
+#if defined(ENYX_SIMD_AVX2)
+        const __m256i reverse = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        while(r - l >= 16){
+            __m256i a = _mm256_loadu_si256((const __m256i*) (p + l));
+            __m256i b = _mm256_loadu_si256((const __m256i*) (p + r - 8));
+            _mm256_storeu_si256((__m256i*) (p + l),     _mm256_permutevar8x32_epi32(b, reverse));
+            _mm256_storeu_si256((__m256i*) (p + r - 8), _mm256_permutevar8x32_epi32(a, reverse));
+            l += 8;
+            r -= 8;
+        }
+#elif defined(ENYX_SIMD_SSE2)
+        while(r - l >= 8){
+            __m128i a = _mm_loadu_si128((const __m128i*) (p + l));
+            __m128i b = _mm_loadu_si128((const __m128i*) (p + r - 4));
+            _mm_storeu_si128((__m128i*) (p + l),     _mm_shuffle_epi32(b, 0x1B));
+            _mm_storeu_si128((__m128i*) (p + r - 4), _mm_shuffle_epi32(a, 0x1B));
+            l += 4;
+            r -= 4;
+        }
+#elif defined(ENYX_SIMD_NEON)
+        while(r - l >= 8){
+            uint32x4_t a = vrev64q_u32(vld1q_u32(p + l));
+            uint32x4_t b = vrev64q_u32(vld1q_u32(p + r - 4));
+            vst1q_u32(p + l,     vcombine_u32(vget_high_u32(b), vget_low_u32(b)));
+            vst1q_u32(p + r - 4, vcombine_u32(vget_high_u32(a), vget_low_u32(a)));
+            l += 4;
+            r -= 4;
+        }
+#endif
+        for(; r - l >= 2; l++, r--){
+            uint32_t tmp = p[l];
+            p[l]         = p[r - 1];
+            p[r - 1]     = tmp;
+        }
+        return;
+    }
+
+    // 1, 2 and 3 components
+    uint8_t* p = (uint8_t*) row;
+    uint8_t  tmp[4];
+    for(size_t l = 0, r = count - 1; l < r; l++, r--){
+        memcpy(tmp,                 p + (l * components), components);
+        memcpy(p + (l * components), p + (r * components), components);
+        memcpy(p + (r * components), tmp,                 components);
+    }
+}
+
+void PixelOps::blendRow(void* dest, int dest_components, const void* src, size_t count){
+    uint8_t*       d = (uint8_t*) dest;
+    const uint8_t* s = (const uint8_t*) src;
+
+    size_t i = 0;
+    if(dest_components == 4){
+        // Alpha result is a + d * (255 - a), the source alpha lane is multiplied as 255
+#if defined(ENYX_SIMD_AVX2)
+        const __m256i zero      = _mm256_setzero_si256();
+        const __m256i ones      = _mm256_set1_epi16(255);
+        const __m256i alpha_one = _mm256_set1_epi32(0xFF000000);
+
+        for(; i + 8 <= count; i += 8){
+            __m256i sv = _mm256_loadu_si256((const __m256i*) (s + i * 4));
+            __m256i dv = _mm256_loadu_si256((const __m256i*) (d + i * 4));
+            __m256i cv = _mm256_or_si256(sv, alpha_one);
+
+            __m256i s_lo = _mm256_unpacklo_epi8(sv, zero);
+            __m256i s_hi = _mm256_unpackhi_epi8(sv, zero);
+            __m256i a_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, 0xFF), 0xFF);
+            __m256i a_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, 0xFF), 0xFF);
+
+            __m256i r_lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(cv, zero), a_lo), _mm256_mullo_epi16(_mm256_unpacklo_epi8(dv, zero), _mm256_sub_epi16(ones, a_lo)));
+            __m256i r_hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(cv, zero), a_hi), _mm256_mullo_epi16(_mm256_unpackhi_epi8(dv, zero), _mm256_sub_epi16(ones, a_hi)));
+
+            _mm256_storeu_si256((__m256i*) (d + i * 4), _mm256_packus_epi16(div255_avx2(r_lo), div255_avx2(r_hi)));
+        }
+#elif defined(ENYX_SIMD_SSE2)
+        const __m128i zero      = _mm_setzero_si128();
+        const __m128i ones      = _mm_set1_epi16(255);
+        const __m128i alpha_one = _mm_set1_epi32(0xFF000000);
+
+        for(; i + 4 <= count; i += 4){
+            __m128i sv = _mm_loadu_si128((const __m128i*) (s + i * 4));
+            __m128i dv = _mm_loadu_si128((const __m128i*) (d + i * 4));
+            __m128i cv = _mm_or_si128(sv, alpha_one);
+
+            __m128i s_lo = _mm_unpacklo_epi8(sv, zero);
+            __m128i s_hi = _mm_unpackhi_epi8(sv, zero);
+            __m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xFF), 0xFF);
+            __m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xFF), 0xFF);
+
+            __m128i r_lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(cv, zero), a_lo), _mm_mullo_epi16(_mm_unpacklo_epi8(dv, zero), _mm_sub_epi16(ones, a_lo)));
+            __m128i r_hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(cv, zero), a_hi), _mm_mullo_epi16(_mm_unpackhi_epi8(dv, zero), _mm_sub_epi16(ones, a_hi)));
+
+            _mm_storeu_si128((__m128i*) (d + i * 4), _mm_packus_epi16(div255_sse2(r_lo), div255_sse2(r_hi)));
+        }
+#elif defined(ENYX_SIMD_NEON)
+        const uint8x16_t opaque = vdupq_n_u8(255);
+
+        for(; i + 16 <= count; i += 16){
+            uint8x16x4_t sv = vld4q_u8(s + i * 4);
+            uint8x16x4_t dv = vld4q_u8(d + i * 4);
+            uint8x16_t   a   = sv.val[3];
+            uint8x16_t   inv = vsubq_u8(opaque, a);
+
+            dv.val[0] = blend_neon(sv.val[0], dv.val[0], a, inv);
+            dv.val[1] = blend_neon(sv.val[1], dv.val[1], a, inv);
+            dv.val[2] = blend_neon(sv.val[2], dv.val[2], a, inv);
+            dv.val[3] = blend_neon(opaque,    dv.val[3], a, inv);
+
+            vst4q_u8(d + i * 4, dv);
+        }
+#endif
+    }
+
+    // Scalar path and tail
+    for(; i < count; i++){
+        const uint8_t* sp = s + (i * 4);
+        uint8_t*       dp = d + (i * dest_components);
+
+        uint32_t a   = sp[3];
+        uint32_t inv = 255 - a;
+
+        dp[0] = div255(sp[0] * a + dp[0] * inv);
+        dp[1] = div255(sp[1] * a + dp[1] * inv);
+        dp[2] = div255(sp[2] * a + dp[2] * inv);
+        if(dest_components == 4) dp[3] = div255(255 * a + dp[3] * inv);
+    }
+}
+
+// Grey value of a RGB pixel (Same weights as stb_image)
+static inline uint8_t luma(uint32_t r, uint32_t g, uint32_t b){
+    return (uint8_t) (((r * 77) + (g * 150) + (b * 29)) >> 8);
+}
+
+void PixelOps::convertRow(void* dest, int dest_components, const void* src, int src_components, size_t count){
+    uint8_t*       d = (uint8_t*) dest;
+    const uint8_t* s = (const uint8_t*) src;
+
+    if(dest_components == src_components){
+        memcpy(d, s, count * src_components);
+        return;
+    }
+
+    size_t i = 0;
+    if(src_components == 3 && dest_components == 4){
+#if defined(ENYX_SIMD_NEON)
+        for(; i + 16 <= count; i += 16){
+            uint8x16x3_t rgb = vld3q_u8(s + i * 3);
+            uint8x16x4_t rgba;
+            rgba.val[0] = rgb.val[0];
+            rgba.val[1] = rgb.val[1];
+            rgba.val[2] = rgb.val[2];
+            rgba.val[3] = vdupq_n_u8(255);
+            vst4q_u8(d + i * 4, rgba);
+        }
+#elif defined(ENYX_SIMD_SSSE3)
+        // Four pixels per 16 byte load, the load stays inside the row
+        const __m128i shuffle   = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha_one = _mm_set1_epi32(0xFF000000);
+        for(; i + 6 <= count; i += 4){
+            __m128i rgb = _mm_loadu_si128((const __m128i*) (s + i * 3));
+            _mm_storeu_si128((__m128i*) (d + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha_one));
+        }
+#endif
+    } else if(src_components == 4 && dest_components == 3){
+#if defined(ENYX_SIMD_NEON)
+        for(; i + 16 <= count; i += 16){
+            uint8x16x4_t rgba = vld4q_u8(s + i * 4);
+            uint8x16x3_t rgb;
+            rgb.val[0] = rgba.val[0];
+            rgb.val[1] = rgba.val[1];
+            rgb.val[2] = rgba.val[2];
+            vst3q_u8(d + i * 3, rgb);
+        }
+#elif defined(ENYX_SIMD_SSSE3)
+        // 16 byte stores, the last 4 bytes are overwritten by the next pixels. Stays inside the row
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        for(; i + 6 <= count; i += 4){
+            __m128i rgba = _mm_loadu_si128((const __m128i*) (s + i * 4));
+            _mm_storeu_si128((__m128i*) (d + i * 3), _mm_shuffle_epi8(rgba, shuffle));
+        }
+#endif
+    } else if(src_components == 1 && dest_components == 4){
+#if defined(ENYX_SIMD_SSE2)
+        const __m128i opaque = _mm_set1_epi8((char) 0xFF);
+        for(; i + 16 <= count; i += 16){
+            __m128i grey = _mm_loadu_si128((const __m128i*) (s + i));
+            __m128i gg   = _mm_unpacklo_epi8(grey, grey);
+            __m128i ga   = _mm_unpacklo_epi8(grey, opaque);
+            __m128i gg2  = _mm_unpackhi_epi8(grey, grey);
+            __m128i ga2  = _mm_unpackhi_epi8(grey, opaque);
+
+            _mm_storeu_si128((__m128i*) (d + i * 4 + 0),  _mm_unpacklo_epi16(gg,  ga));
+            _mm_storeu_si128((__m128i*) (d + i * 4 + 16), _mm_unpackhi_epi16(gg,  ga));
+            _mm_storeu_si128((__m128i*) (d + i * 4 + 32), _mm_unpacklo_epi16(gg2, ga2));
+            _mm_storeu_si128((__m128i*) (d + i * 4 + 48), _mm_unpackhi_epi16(gg2, ga2));
+        }
+#elif defined(ENYX_SIMD_NEON)
+        for(; i + 16 <= count; i += 16){
+            uint8x16_t   grey = vld1q_u8(s + i);
+            uint8x16x4_t rgba;
+            rgba.val[0] = grey;
+            rgba.val[1] = grey;
+            rgba.val[2] = grey;
+            rgba.val[3] = vdupq_n_u8(255);
+            vst4q_u8(d + i * 4, rgba);
+        }
+#endif
+    }
+
+    // Scalar path and tail, any layout to any layout
+    for(; i < count; i++){
+        const uint8_t* sp = s + (i * src_components);
+        uint8_t*       dp = d + (i * dest_components);
+        uint8_t r, g, b, a;
+
+        switch(src_components){
+            case 1:  r = g = b = sp[0]; a = 255;                break;
+            case 2:  r = g = b = sp[0]; a = sp[1];              break;
+            case 3:  r = sp[0]; g = sp[1]; b = sp[2]; a = 255;  break;
+            default: r = sp[0]; g = sp[1]; b = sp[2]; a = sp[3]; break;
+        }
+
+        switch(dest_components){
+            case 1:  dp[0] = luma(r, g, b);                              break;
+            case 2:  dp[0] = luma(r, g, b); dp[1] = a;                   break;
+            case 3:  dp[0] = r; dp[1] = g; dp[2] = b;                    break;
+            default: dp[0] = r; dp[1] = g; dp[2] = b; dp[3] = a;         break;
+        }
+    }
+}
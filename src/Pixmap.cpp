@@ -19,6 +19,25 @@
 #include "Pixmap.h"
 #include "Debug.h"
 #include "ImageDriver.h"
+#include "PixelOps.h"
+#include "RawPack.h"
+#include "ETC1.h"
+
+
+// Free pixel storage by loader
+static void freeStorage(uint8_t* px, int loader){
+    if(loader != PIXMAP_LOADER_NONE){
+        if(loader == PIXMAP_LOADER_IMAGEDRIVER){
+            Debug::info("[%s:%d]: Deleting an ImageDriver allocated pixmap (%p)\n", __FILE__, __LINE__, px);
+            ImageDriver::freeImage(px);
+        } else {
+            Debug::info("[%s:%d]: Deleting a locally allocated pixmap (%p)\n", __FILE__, __LINE__, px);
+            ::free(px);
+        }
+    } else {
+        Debug::info("[%s:%d]: Deleting a static buffer pixmap (%p)\n", __FILE__, __LINE__, px);
+    }
+}
 
 
 Pixmap::Pixmap(){
@@ -27,6 +46,7 @@ Pixmap::Pixmap(){
     this->height     = 0;
     this->components = 0;
     this->loader     = PIXMAP_LOADER_NONE;
+    this->shared     = NULL;
 }
 
 Pixmap::Pixmap(void* px, int width, int height, int components, int loader){
@@ -35,10 +55,12 @@ Pixmap::Pixmap(void* px, int width, int height, int components, int loader){
     this->height     = height;
     this->components = components;
     this->loader     = loader;
+    this->shared     = NULL;
 }
 
 
 Pixmap::Pixmap(const char* fileName){
+    this->shared = NULL;
     this->px = ImageDriver::loadImage(fileName, &this->width, &this->height, &this->components);
     if(this->px){
         Debug::info("[%s:%d]: Loaded image %s with size (%dx%dx%d)\n", __FILE__, __LINE__, fileName, this->width, this->height, this->components);
@@ -55,6 +77,52 @@ Pixmap::Pixmap(const char* fileName){
 }
 
 Pixmap::Pixmap(const Pixmap& other){
+    this->px         = NULL;
+    this->width      = 0;
+    this->height     = 0;
+    this->components = 0;
+    this->loader     = PIXMAP_LOADER_NONE;
+    this->shared     = NULL;
+
+    this->copy(other);
+}
+
+Pixmap::Pixmap(Pixmap&& other){
+    this->take(other);
+}
+
+Pixmap& Pixmap::operator=(const Pixmap& other){
+    if(this != &other){
+        if(this->exists()) this->free();
+        this->copy(other);
+    }
+    return *this;
+}
+
+Pixmap& Pixmap::operator=(Pixmap&& other){
+    if(this != &other){
+        if(this->exists()) this->free();
+        this->take(other);
+    }
+    return *this;
+}
+
+void Pixmap::copy(const Pixmap& other){
+    if(!other.exists()) return;
+
+    if(other.shared){
+        // Shared storage, one more reference and no pixels copied
+        __atomic_add_fetch(&other.shared->references, 1, __ATOMIC_ACQ_REL);
+
+        this->px         = other.px;
+        this->width      = other.width;
+        this->height     = other.height;
+        this->components = other.components;
+        this->loader     = other.loader;
+        this->shared     = other.shared;
+        return;
+    }
+
     this->px = (uint8_t*) malloc(other.getWidth() * other.getHeight() * other.getComponents());
     if(this->px){
         Debug::info("[%s:%d]: Loading image from another Pixmap (copy constructor) from %p\n", __FILE__, __LINE__, &other);
@@ -77,9 +145,26 @@ Pixmap::Pixmap(const Pixmap& other){
     }
 }
 
+void Pixmap::take(Pixmap& other){
+    this->px         = other.px;
+    this->width      = other.width;
+    this->height     = other.height;
+    this->components = other.components;
+    this->loader     = other.loader;
+    this->shared     = other.shared;
+
+    // other does not own anything now
+    other.px         = NULL;
+    other.width      = 0;
+    other.height     = 0;
+    other.components = 0;
+    other.loader     = PIXMAP_LOADER_NONE;
+    other.shared     = NULL;
+}
+
 
 Pixmap::~Pixmap(){
-    if(this->loader != PIXMAP_LOADER_NONE){
+    if(this->loader != PIXMAP_LOADER_NONE || this->shared){
         this->free();
     } else {
         this->px = NULL;
@@ -99,12 +184,91 @@ bool Pixmap::exists() const {
     return (this->px != NULL);
 }
 
+void Pixmap::share(){
+    if(!this->exists() || this->shared) return;
+
+    this->shared = (pixmap_shared_t*) malloc(sizeof(pixmap_shared_t));
+    if(this->shared == NULL){
+        Debug::error("[%s:%d]: Cannot allocate shared storage for pixmap (%p)!\n", __FILE__, __LINE__, this->px);
+        return;
+    }
+
+    this->shared->px         = this->px;
+    this->shared->loader     = this->loader;
+    this->shared->references = 1;
+}
+
+bool Pixmap::isShared() const {
+    return (this->shared != NULL);
+}
+
+int Pixmap::getReferences() const {
+    if(this->shared) return __atomic_load_n(&this->shared->references, __ATOMIC_ACQUIRE);
+    return 1;
+}
+
+bool Pixmap::unshare(){
+    if(this->shared == NULL) return true;
+
+    // Last user, the storage is ours to write and stays shared for later copies
+    if(__atomic_load_n(&this->shared->references, __ATOMIC_ACQUIRE) == 1) return true;
+
+    size_t   size = this->width * this->height * this->components;
+    uint8_t* copy = (uint8_t*) malloc(size);
+    if(copy == NULL){
+        Debug::error("[%s:%d]: Cannot allocate memory to copy a shared pixmap (%d bytes)!\n", __FILE__, __LINE__, (int) size);
+        return false;
+    }
+
+    // New storage for the copy, so the pixmap keeps sharing its pixels after the write
+    pixmap_shared_t* fresh = (pixmap_shared_t*) malloc(sizeof(pixmap_shared_t));
+    if(fresh == NULL){
+        Debug::error("[%s:%d]: Cannot allocate shared storage for pixmap copy!\n", __FILE__, __LINE__);
+        ::free(copy);
+        return false;
+    }
+
+    Debug::info("[%s:%d]: Copying shared pixmap (%p) before writing\n", __FILE__, __LINE__, this->px);
+    memcpy(copy, this->px, size);
+
+    fresh->px         = copy;
+    fresh->loader     = PIXMAP_LOADER_MALLOC;
+    fresh->references = 1;
+
+    // Drop our reference, someone may have released theirs meanwhile
+    pixmap_shared_t* old = this->shared;
+    this->px     = copy;
+    this->loader = PIXMAP_LOADER_MALLOC;
+    this->shared = fresh;
+
+    if(__atomic_sub_fetch(&old->references, 1, __ATOMIC_ACQ_REL) == 0){
+        freeStorage(old->px, old->loader);
+        ::free(old);
+    }
+    return true;
+}
+
 void* Pixmap::getPixels() const {
     return (void*) this->px;
 }
 
+PixmapView Pixmap::view(int x, int y, int width, int height){
+    if(!this->exists()) return PixmapView();
+
+    if(this->isModifiable()){
+        // Writes through the view must not reach other copies
+        if(!this->unshare()) return PixmapView();
+
+        return PixmapView((void*) this->px, this->width, this->height, this->components, 0).region(x, y, width, height);
+    }
+
+    return PixmapView((const void*) this->px, this->width, this->height, this->components, 0).region(x, y, width, height);
+}
+
 void Pixmap::copyPixels(void* from, size_t size){
     if(this->exists() && this->isModifiable()){
+        if(!this->unshare()) return;
+
         memcpy(this->px, from, size);
     } else {
         if(!this->isModifiable()) Debug::error("[%s:%d]: Attempting to modify a static pixmap!\n", __FILE__, __LINE__);
@@ -112,16 +276,16 @@ void Pixmap::copyPixels(void* from, size_t size){
 }
 
 void Pixmap::free(){
-    if(this->loader != PIXMAP_LOADER_NONE){
-        if(this->loader == PIXMAP_LOADER_IMAGEDRIVER){
-            Debug::info("[%s:%d]: Deleting an ImageDriver allocated pixmap (%p)\n", __FILE__, __LINE__, this->px);
-            ImageDriver::freeImage(this->px);
+    if(this->shared){
+        // Storage is freed by its last user
+        if(__atomic_sub_fetch(&this->shared->references, 1, __ATOMIC_ACQ_REL) == 0){
+            freeStorage(this->shared->px, this->shared->loader);
+            ::free(this->shared);
         } else {
-            Debug::info("[%s:%d]: Deleting a locally allocated pixmap (%p)\n", __FILE__, __LINE__, this->px);
-            ::free(this->px);
+            Debug::info("[%s:%d]: Releasing a shared pixmap (%p)\n", __FILE__, __LINE__, this->px);
         }
     } else {
-        Debug::info("[%s:%d]: Deleting a static buffer pixmap (%p)\n", __FILE__, __LINE__, this->px);
+        freeStorage(this->px, this->loader);
     }
 
     this->px = NULL;
@@ -129,6 +293,7 @@ void Pixmap::free(){
     this->height     = 0;
     this->components = 0;
     this->loader     = PIXMAP_LOADER_NONE;
+    this->shared     = NULL;
 }
 
 void Pixmap::allocate(int width, int height, int components){
@@ -157,79 +322,98 @@ void Pixmap::allocate(int width, int height, int components){
 
 void Pixmap::clear(){
     if(this->exists() && this->isModifiable()){
+        if(!this->unshare()) return;
+
         memset(this->px, 0, this->width * this->height * this->components);
     }
 }
 
 void Pixmap::fill(color_t color){
     if(this->exists() && this->isModifiable()){
-        switch(this->components){
-            case 1:
-                memset(this->px, R(color), this->width * this->height * this->components);
-                break;
-            case 2:
-                for(int i = 0; i < (this->width * this->height * this->components); i+=2){
-                    this->px[i + 0] = R(color);
-                    this->px[i + 1] = G(color);
-                }
-                break;
-            case 3:
-                for(int i = 0; i < (this->width * this->height * this->components); i+=3){
-                    this->px[i + 0] = R(color);
-                    this->px[i + 1] = G(color);
-                    this->px[i + 2] = B(color);
-                }
-                break;
-            case 4:
-                for(int i = 0; i < (this->width * this->height * this->components); i+=4){
-                    this->px[i + 0] = R(color);
-                    this->px[i + 1] = G(color);
-                    this->px[i + 2] = B(color);
-                    this->px[i + 3] = A(color);
-                }
-                break;
-            default:
-                Debug::warning("[%s:%d]: Aborting fill operation. Unknown image components: %d\n", __FILE__, __LINE__, this->components);
-                break;
+        if(!this->unshare()) return;
+
+        if(this->components < 1 || this->components > 4){
+            Debug::warning("[%s:%d]: Aborting fill operation. Unknown image components: %d\n", __FILE__, __LINE__, this->components);
+            return;
         }
+
+        // Image is stored in big endian mode [R G B A]
+        uint8_t pixel[4] = {(uint8_t) R(color), (uint8_t) G(color), (uint8_t) B(color), (uint8_t) A(color)};
+        PixelOps::fill(this->px, pixel, this->components, this->width * this->height);
     } else {
         if(!this->isModifiable()) Debug::error("[%s:%d]: Attempting to modify a static pixmap!\n", __FILE__, __LINE__);
     }
 }
 
-// TODO: Fix flip!!
+// Swaps rows (Top <-> bottom)
 void Pixmap::flipHorizontally(){
     if(this->exists() && this->isModifiable()){
-        for(int y = 0; y < (this->height >> 1); y++){
-            for(int x = 0; x < this->width; x++){
-                color_t px1 = this->getPixel(x, y);
-                color_t px2 = this->getPixel(x, this->height - y);
+        if(!this->unshare()) return;
 
-                this->setPixel(x, y, px2);
-                this->setPixel(x, this->height - y, px1);
-            }
+        size_t row_size = this->width * this->components;
+        for(int y = 0; y < (this->height >> 1); y++){
+            PixelOps::swapRows(this->px + (row_size * y), this->px + (row_size * (this->height - 1 - y)), row_size);
         }
     } else {
         if(!this->isModifiable()) Debug::error("[%s:%d]: Attempting to modify a static pixmap!\n", __FILE__, __LINE__);
     }
 }
 
+// Reverses every row (Left <-> right)
 void Pixmap::flipVertically(){
     if(this->exists() && this->isModifiable()){
-        for(int y = 0; y < this->height; y++){
-            for(int x = 0; x < (this->width >> 1); x++){
-                color_t px1 = this->getPixel(x, y);
-                color_t px2 = this->getPixel(this->width - x, this->height);
+        if(!this->unshare()) return;
 
-                this->setPixel(x, y, px2);
-                this->setPixel(this->width - x, y, px1);
-            }
+        size_t row_size = this->width * this->components;
+        for(int y = 0; y < this->height; y++){
+            PixelOps::mirrorRow(this->px + (row_size * y), this->components, this->width);
         }
     } else {
         if(!this->isModifiable()) Debug::error("[%s:%d]: Attempting to modify a static pixmap!\n", __FILE__, __LINE__);
     }
 }
 
+void Pixmap::blit(const PixmapView& src, int x, int y){
+    if(this->exists() && this->isModifiable()){
+        this->view(0, 0, this->width, this->height).blit(src, x, y);
+    } else {
+        if(!this->isModifiable()) Debug::error("[%s:%d]: Attempting to modify a static pixmap!\n", __FILE__, __LINE__);
+    }
+}
+
+int Pixmap::convert(int components){
+    if(!this->exists()) return 1;
+    if(components < 1 || components > 4){
+        Debug::error("[%s:%d]: Cannot convert pixmap to %d components!\n", __FILE__, __LINE__, components);
+        return 2;
+    }
+    if(components == this->components) return 0;
+
+    uint8_t* converted = (uint8_t*) malloc(this->width * this->height * components);
+    if(converted == NULL){
+        Debug::error("[%s:%d]: Cannot allocate memory to convert image (%d bytes)!\n", __FILE__, __LINE__, this->width * this->height * components);
+        return 3;
+    }
+
+    PixelOps::convertRow(converted, components, this->px, this->components, this->width * this->height);
+
+    // Old storage is released the usual way (Static, shared or owned)
+    int  width  = this->width;
+    int  height = this->height;
+    bool shared = this->isShared();
+    this->free();
+
+    this->px         = converted;
+    this->width      = width;
+    this->height     = height;
+    this->components = components;
+    this->loader     = PIXMAP_LOADER_MALLOC;
+
+    // Converted pixels keep the shared mode
+    if(shared) this->share();
+    return 0;
+}
+
 
 color_t Pixmap::getPixel(int px, int py){
     if(this->exists()){
@@ -262,6 +446,8 @@ color_t Pixmap::getPixel(int px, int py){
 
 void Pixmap::setPixel(int px, int py, color_t color){
     if(this->exists() && this->isModifiable()){
+        if(!this->unshare()) return;
+
         int offset = (this->components * this->width * py) + (this->components * px);
         switch(this->components){
             case 1:
@@ -318,6 +504,41 @@ Pixmap Pixmap::loadImage(const char* fileName){
     return Pixmap(fileName);
 }
 
+Pixmap Pixmap::loadImageFromMemory(const void* data, size_t size){
+    int width, height, components;
+    uint8_t* px = ImageDriver::loadImageFromMemory(data, size, &width, &height, &components);
+    if(px == NULL){
+        Debug::error("[%s:%d]: Cannot load image from memory (%p)!\n", __FILE__, __LINE__, data);
+        return Pixmap();
+    }
+
+    Debug::info("[%s:%d]: Loaded image from memory with size (%dx%dx%d)\n", __FILE__, __LINE__, width, height, components);
+    return Pixmap(px, width, height, components, PIXMAP_LOADER_IMAGEDRIVER);
+}
+
+Pixmap Pixmap::loadRaw(const RawPack& pack, const char* name){
+    int index = pack.find(name);
+    if(index < 0){
+        Debug::error("[%s:%d]: Image %s is not in the raw pack!\n", __FILE__, __LINE__, name);
+        return Pixmap();
+    }
+
+    const rawpack_entry_t* entry  = pack.getEntry(index);
+    const uint8_t*         pixels = pack.acquirePixels(index);
+    if(pixels == NULL) return Pixmap();
+
+    Pixmap pixmap;
+    if(entry->flags & RAWPACK_FLAG_ETC1){
+        // Level 0 decoded (Components are 3, or 4 with the alpha plane)
+        pixmap.allocate(entry->width, entry->height, entry->components);
+        if(pixmap.exists()) ETC1::decode(pixels, entry->width, entry->height, entry->components, (uint8_t*) pixmap.getPixels());
+    } else {
+        pixmap = Pixmap::loadArray((void*) pixels, entry->width, entry->height, entry->components);
+    }
+    pack.releasePixels(index, pixels);
+    return pixmap;
+}
+
 Pixmap Pixmap::loadArray(void* px_ptr, int width, int height, int components){
     Pixmap pixmap;
     Debug::info("[%s:%d]: Allocating a pixmap from array %p\n", __FILE__, __LINE__, px_ptr);
@@ -0,0 +1,241 @@
+/**
+ * @file PixmapView.cpp
+ * @author Brais Solla González
+ * @brief Pixmap views implementation for Enyx
+ * @version 0.1
+ * @date 2021-12-04
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "AGL.h"
+#include "Pixmap.h"
+#include "PixmapView.h"
+#include "Debug.h"
+#include "PixelOps.h"
+
+
+PixmapView::PixmapView(){
+    this->px         = NULL;
+    this->width      = 0;
+    this->height     = 0;
+    this->components = 0;
+    this->stride     = 0;
+    this->modifiable = false;
+}
+
+PixmapView::PixmapView(void* px, int width, int height, int components, int stride){
+    this->px         = (uint8_t*) px;
+    this->width      = width;
+    this->height     = height;
+    this->components = components;
+    this->stride     = stride ? stride : (width * components);
+    this->modifiable = (px != NULL);
+}
+
+PixmapView::PixmapView(const void* px, int width, int height, int components, int stride){
+    this->px         = (uint8_t*) px;
+    this->width      = width;
+    this->height     = height;
+    this->components = components;
+    this->stride     = stride ? stride : (width * components);
+    this->modifiable = false;
+}
+
+PixmapView::PixmapView(Pixmap& pixmap){
+    *this = pixmap.view(0, 0, pixmap.getWidth(), pixmap.getHeight());
+}
+
+PixmapView::PixmapView(Pixmap& pixmap, int x, int y, int width, int height){
+    *this = pixmap.view(x, y, width, height);
+}
+
+PixmapView PixmapView::region(int x, int y, int width, int height) const {
+    // Clip to this view
+    if(x < 0){ width  += x; x = 0; }
+    if(y < 0){ height += y; y = 0; }
+    if(x + width  > this->width)  width  = this->width  - x;
+    if(y + height > this->height) height = this->height - y;
+
+    if(this->px == NULL || width <= 0 || height <= 0){
+        return PixmapView();
+    }
+
+    PixmapView view;
+    view.px         = this->px + (this->stride * y) + (this->components * x);
+    view.width      = width;
+    view.height     = height;
+    view.components = this->components;
+    view.stride     = this->stride;
+    view.modifiable = this->modifiable;
+    return view;
+}
+
+bool PixmapView::onImage(int px, int py) const {
+    if(px >= 0 && px < this->width && py >= 0 && py < this->height) return true;
+    return false;
+}
+
+bool PixmapView::isModifiable() const {
+    return this->modifiable;
+}
+
+bool PixmapView::exists() const {
+    return (this->px != NULL);
+}
+
+bool PixmapView::isContiguous() const {
+    return (this->stride == this->width * this->components) || (this->height <= 1);
+}
+
+void* PixmapView::getPixels() const {
+    return (void*) this->px;
+}
+
+void* PixmapView::getRow(int py) const {
+    return (void*) (this->px + (this->stride * py));
+}
+
+void PixmapView::clear(){
+    if(this->exists() && this->isModifiable()){
+        if(this->isContiguous()){
+            memset(this->px, 0, this->width * this->height * this->components);
+            return;
+        }
+
+        for(int y = 0; y < this->height; y++){
+            memset(this->getRow(y), 0, this->width * this->components);
+        }
+    } else {
+        if(!this->isModifiable()) Debug::error("[%s:%d]: Attempting to modify a read only pixmap view!\n", __FILE__, __LINE__);
+    }
+}
+
+void PixmapView::fill(color_t color){
+    if(this->exists() && this->isModifiable()){
+        if(this->components < 1 || this->components > 4){
+            Debug::warning("[%s:%d]: Aborting fill operation. Unknown image components: %d\n", __FILE__, __LINE__, this->components);
+            return;
+        }
+
+        // Image is stored in big endian mode [R G B A]
+        uint8_t pixel[4] = {(uint8_t) R(color), (uint8_t) G(color), (uint8_t) B(color), (uint8_t) A(color)};
+
+        if(this->isContiguous()){
+            PixelOps::fill(this->px, pixel, this->components, this->width * this->height);
+            return;
+        }
+
+        for(int y = 0; y < this->height; y++){
+            PixelOps::fill(this->getRow(y), pixel, this->components, this->width);
+        }
+    } else {
+        if(!this->isModifiable()) Debug::error("[%s:%d]: Attempting to modify a read only pixmap view!\n", __FILE__, __LINE__);
+    }
+}
+
+void PixmapView::blit(const PixmapView& src, int x, int y){
+    if(this->exists() && this->isModifiable()){
+        if(!src.exists()) return;
+
+        // Clip src to this view, then this view to src. A negative offset already moved src
+        PixmapView from = src.region(-x, -y, this->width, this->height);
+        if(!from.exists()) return;
+
+        PixmapView to = this->region(x > 0 ? x : 0, y > 0 ? y : 0, from.getWidth(), from.getHeight());
+        if(!to.exists()) return;
+
+        bool blend = (from.getComponents() == 4) && (to.getComponents() >= 3);
+        for(int row = 0; row < to.getHeight(); row++){
+            if(blend){
+                PixelOps::blendRow(to.getRow(row), to.getComponents(), from.getRow(row), to.getWidth());
+            } else {
+                PixelOps::convertRow(to.getRow(row), to.getComponents(), from.getRow(row), from.getComponents(), to.getWidth());
+            }
+        }
+    } else {
+        if(!this->isModifiable()) Debug::error("[%s:%d]: Attempting to modify a read only pixmap view!\n", __FILE__, __LINE__);
+    }
+}
+
+color_t PixmapView::getPixel(int px, int py) const {
+    if(this->exists() && this->onImage(px, py)){
+        // Image is stored in big endian mode [R G B A]
+        const uint8_t* pixel = this->px + (this->stride * py) + (this->components * px);
+        switch(this->components){
+            case 1:
+                return RGB(pixel[0], 0, 0);
+            case 2:
+                return RGB(pixel[0], pixel[1], 0);
+            case 3:
+                return RGB(pixel[0], pixel[1], pixel[2]);
+            case 4:
+                return RGBA(pixel[0], pixel[1], pixel[2], pixel[3]);
+            default:
+                return 0;
+        }
+    }
+    return 0;
+}
+
+void PixmapView::setPixel(int px, int py, color_t color){
+    if(this->exists() && this->isModifiable()){
+        if(!this->onImage(px, py)) return;
+
+        uint8_t* pixel = this->px + (this->stride * py) + (this->components * px);
+        switch(this->components){
+            case 4:
+                pixel[3] = A(color);
+                // Fall through
+            case 3:
+                pixel[2] = B(color);
+                // Fall through
+            case 2:
+                pixel[1] = G(color);
+                // Fall through
+            case 1:
+                pixel[0] = R(color);
+                break;
+            default:
+                break;
+        }
+    } else {
+        if(!this->isModifiable()) Debug::error("[%s:%d]: Attempting to modify a read only pixmap view!\n", __FILE__, __LINE__);
+    }
+}
+
+void PixmapView::copyTo(void* dest) const {
+    if(!this->exists() || dest == NULL) return;
+
+    size_t row_size = this->width * this->components;
+    if(this->isContiguous()){
+        memcpy(dest, this->px, row_size * this->height);
+        return;
+    }
+
+    for(int y = 0; y < this->height; y++){
+        memcpy((uint8_t*) dest + (row_size * y), this->getRow(y), row_size);
+    }
+}
+
+int PixmapView::getWidth() const {
+    return this->width;
+}
+
+int PixmapView::getHeight() const {
+    return this->height;
+}
+
+int PixmapView::getComponents() const {
+    return this->components;
+}
+
+int PixmapView::getStride() const {
+    return this->stride;
+}
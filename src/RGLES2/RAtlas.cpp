@@ -0,0 +1,319 @@
+/**
+ * @file RAtlas.cpp
+ * @author Brais Solla González
+ * @brief RAtlas implementation
+ * @version 0.1
+ * @date 2021-12-08
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+
+#include "Debug.h"
+#include "RGLES2/RGLES2.h"
+#include "RGLES2/RAtlas.h"
+
+// Skyline nodes reserved per new page (Grows when needed)
+#define ATLAS_INITIAL_NODES   64
+#define ATLAS_INITIAL_REGIONS 64
+
+
+RAtlas::RAtlas(){
+    this->pageSize   = ATLAS_DEFAULT_PAGE_SIZE;
+    this->components = 4;
+    this->padding    = ATLAS_DEFAULT_PADDING;
+
+    this->pages          = NULL;
+    this->pageCount      = 0;
+    this->regions        = NULL;
+    this->regionCount    = 0;
+    this->regionCapacity = 0;
+}
+
+RAtlas::RAtlas(int pageSize, int components, int padding){
+    this->pageSize   = (pageSize > 0) ? pageSize : ATLAS_DEFAULT_PAGE_SIZE;
+    this->components = (components >= 1 && components <= 4) ? components : 4;
+    this->padding    = (padding >= 0) ? padding : 0;
+
+    this->pages          = NULL;
+    this->pageCount      = 0;
+    this->regions        = NULL;
+    this->regionCount    = 0;
+    this->regionCapacity = 0;
+}
+
+RAtlas::~RAtlas(){
+    this->clear();
+}
+
+void RAtlas::clear(){
+    for(int i = 0; i < this->pageCount; i++){
+        delete this->pages[i].texture;
+        rfree(this->pages[i].skyline);
+    }
+    if(this->pages)   rfree(this->pages);
+    if(this->regions) rfree(this->regions);
+
+    this->pages          = NULL;
+    this->pageCount      = 0;
+    this->regions        = NULL;
+    this->regionCount    = 0;
+    this->regionCapacity = 0;
+}
+
+int RAtlas::addPage(){
+    // Pages are created with a context, the size limit is known by now
+    if(this->pageCount == 0){
+        GLint max_size = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+        if(max_size > 0 && this->pageSize > max_size){
+            Debug::warning("[%s:%d]: Atlas page size %d is too big, using %d\n", __FILE__, __LINE__, this->pageSize, (int) max_size);
+            this->pageSize = max_size;
+        }
+    }
+
+    ratlaspage_t* new_pages = (ratlaspage_t*) rrealloc(this->pages, (this->pageCount + 1) * sizeof(ratlaspage_t));
+    if(new_pages == NULL){
+        Debug::error("[%s:%d]: Cannot allocate a new atlas page!\n", __FILE__, __LINE__);
+        return -1;
+    }
+    this->pages = new_pages;
+
+    ratlaspage_t* page = &this->pages[this->pageCount];
+    page->skyline  = (ratlasnode_t*) rmalloc(ATLAS_INITIAL_NODES * sizeof(ratlasnode_t));
+    page->capacity = ATLAS_INITIAL_NODES;
+    if(page->skyline == NULL){
+        Debug::error("[%s:%d]: Cannot allocate a new atlas page!\n", __FILE__, __LINE__);
+        return -1;
+    }
+
+    // Empty page: one segment, as wide as the page, at row 0
+    page->skyline[0].x     = 0;
+    page->skyline[0].y     = 0;
+    page->skyline[0].width = this->pageSize;
+    page->nodes            = 1;
+
+    page->texture = new RTexture(this->pageSize, this->pageSize, this->components);
+
+    Debug::info("[%s:%d]: Atlas page %d created (%dx%dx%d)\n", __FILE__, __LINE__, this->pageCount, this->pageSize, this->pageSize, this->components);
+    return this->pageCount++;
+}
+
+bool RAtlas::findPosition(const ratlaspage_t* page, int width, int height, int* node, int* px, int* py) const {
+    int best_y     = INT_MAX;
+    int best_width = INT_MAX;
+    int best_node  = -1;
+
+    for(int i = 0; i < page->nodes; i++){
+        int x = page->skyline[i].x;
+        // Nodes are sorted by x, the ones after are further right
+        if(x + width > this->pageSize) break;
+
+        // The rectangle rests on the highest segment below it
+        int y         = 0;
+        int remaining = width;
+        for(int j = i; remaining > 0; j++){
+            if(page->skyline[j].y > y) y = page->skyline[j].y;
+            remaining -= page->skyline[j].width;
+        }
+        if(y + height > this->pageSize) continue;
+
+        // Bottom-left: lowest row first, then the tightest segment
+        if(y < best_y || (y == best_y && page->skyline[i].width < best_width)){
+            best_y     = y;
+            best_width = page->skyline[i].width;
+            best_node  = i;
+        }
+    }
+
+    if(best_node < 0) return false;
+
+    *node = best_node;
+    *px   = page->skyline[best_node].x;
+    *py   = best_y;
+    return true;
+}
+
+bool RAtlas::placeRectangle(ratlaspage_t* page, int node, int px, int py, int width, int height){
+    if(page->nodes + 1 > page->capacity){
+        ratlasnode_t* new_skyline = (ratlasnode_t*) rrealloc(page->skyline, page->capacity * 2 * sizeof(ratlasnode_t));
+        if(new_skyline == NULL) return false;
+
+        page->skyline   = new_skyline;
+        page->capacity *= 2;
+    }
+
+    // New segment on top of the rectangle
+    memmove(&page->skyline[node + 1], &page->skyline[node], (page->nodes - node) * sizeof(ratlasnode_t));
+    page->skyline[node].x     = px;
+    page->skyline[node].y     = py + height;
+    page->skyline[node].width = width;
+    page->nodes++;
+
+    // Segments under the rectangle are cut or removed
+    int i = node + 1;
+    while(i < page->nodes && page->skyline[i].x < px + width){
+        int shrink = (px + width) - page->skyline[i].x;
+
+        if(shrink < page->skyline[i].width){
+            page->skyline[i].x     += shrink;
+            page->skyline[i].width -= shrink;
+            break;
+        }
+
+        memmove(&page->skyline[i], &page->skyline[i + 1], (page->nodes - i - 1) * sizeof(ratlasnode_t));
+        page->nodes--;
+    }
+
+    // Merge neighbours at the same row
+    for(i = 0; i < page->nodes - 1; i++){
+        if(page->skyline[i].y == page->skyline[i + 1].y){
+            page->skyline[i].width += page->skyline[i + 1].width;
+            memmove(&page->skyline[i + 1], &page->skyline[i + 2], (page->nodes - i - 2) * sizeof(ratlasnode_t));
+            page->nodes--;
+            i--;
+        }
+    }
+
+    return true;
+}
+
+int RAtlas::add(const PixmapView& view){
+    if(!view.exists()){
+        Debug::error("[%s:%d]: Cannot add an empty image to the atlas!\n", __FILE__, __LINE__);
+        return -1;
+    }
+
+    if(view.getComponents() != this->components){
+        Debug::error("[%s:%d]: Atlas image has %d components, pages have %d!\n", __FILE__, __LINE__, view.getComponents(), this->components);
+        return -1;
+    }
+
+    int width  = view.getWidth();
+    int height = view.getHeight();
+    int pad    = this->padding;
+    // Packed size, padding on every side
+    int pw     = width  + pad * 2;
+    int ph     = height + pad * 2;
+
+    if(this->regionCount == this->regionCapacity){
+        int new_capacity = this->regionCapacity ? this->regionCapacity * 2 : ATLAS_INITIAL_REGIONS;
+        ratlasregion_t* new_regions = (ratlasregion_t*) rrealloc(this->regions, new_capacity * sizeof(ratlasregion_t));
+        if(new_regions == NULL){
+            Debug::error("[%s:%d]: Cannot grow the atlas region list!\n", __FILE__, __LINE__);
+            return -1;
+        }
+
+        this->regions        = new_regions;
+        this->regionCapacity = new_capacity;
+    }
+
+    // First page with room, or a new one
+    int page = -1;
+    int node = 0, px = 0, py = 0;
+    for(int i = 0; i < this->pageCount && page < 0; i++){
+        if(this->findPosition(&this->pages[i], pw, ph, &node, &px, &py)) page = i;
+    }
+
+    if(page < 0){
+        if(this->pageCount > 0 && (pw > this->pageSize || ph > this->pageSize)){
+            Debug::error("[%s:%d]: Image %dx%d does not fit in a %dx%d atlas page!\n", __FILE__, __LINE__, width, height, this->pageSize, this->pageSize);
+            return -1;
+        }
+
+        page = this->addPage();
+        if(page < 0) return -1;
+
+        if(!this->findPosition(&this->pages[page], pw, ph, &node, &px, &py)){
+            Debug::error("[%s:%d]: Image %dx%d does not fit in a %dx%d atlas page!\n", __FILE__, __LINE__, width, height, this->pageSize, this->pageSize);
+            return -1;
+        }
+    }
+
+    // Image and its extruded borders, uploaded at once
+    size_t   row_bytes = (size_t) pw * this->components;
+    uint8_t* pixels    = (uint8_t*) rmalloc(row_bytes * ph);
+    if(pixels == NULL){
+        Debug::error("[%s:%d]: Cannot allocate %d bytes for an atlas image!\n", __FILE__, __LINE__, (int) (row_bytes * ph));
+        return -1;
+    }
+
+    int cmp = this->components;
+    for(int y = 0; y < ph; y++){
+        // Padding rows repeat the first / last row
+        int sy = y - pad;
+        if(sy < 0)          sy = 0;
+        if(sy > height - 1) sy = height - 1;
+
+        uint8_t* src  = (uint8_t*) view.getRow(sy);
+        uint8_t* dest = pixels + (y * row_bytes);
+
+        memcpy(dest + (pad * cmp), src, (size_t) width * cmp);
+        for(int x = 0; x < pad; x++){
+            memcpy(dest + (x * cmp), src, cmp);
+            memcpy(dest + ((pad + width + x) * cmp), src + ((width - 1) * cmp), cmp);
+        }
+    }
+
+    if(!this->placeRectangle(&this->pages[page], node, px, py, pw, ph)){
+        Debug::error("[%s:%d]: Cannot grow the atlas skyline!\n", __FILE__, __LINE__);
+        rfree(pixels);
+        return -1;
+    }
+
+    this->pages[page].texture->uploadPixels(px, py, PixmapView(pixels, pw, ph, cmp, 0));
+    rfree(pixels);
+
+    ratlasregion_t* region = &this->regions[this->regionCount];
+    region->page   = page;
+    region->x      = px + pad;
+    region->y      = py + pad;
+    region->width  = width;
+    region->height = height;
+
+    return this->regionCount++;
+}
+
+int RAtlas::add(Pixmap& pixmap){
+    if(pixmap.getComponents() == this->components) return this->add(PixmapView(pixmap));
+
+    // Converted copy, the pixmap is not changed
+    Pixmap converted(pixmap);
+    if(converted.convert(this->components) != 0){
+        Debug::error("[%s:%d]: Cannot convert an atlas image to %d components!\n", __FILE__, __LINE__, this->components);
+        return -1;
+    }
+    return this->add(PixmapView(converted));
+}
+
+const ratlasregion_t* RAtlas::getRegion(int region) const {
+    if(region < 0 || region >= this->regionCount) return NULL;
+    return &this->regions[region];
+}
+
+RTexture* RAtlas::getPage(int page) const {
+    if(page < 0 || page >= this->pageCount) return NULL;
+    return this->pages[page].texture;
+}
+
+int RAtlas::getPageCount() const {
+    return this->pageCount;
+}
+
+int RAtlas::getRegionCount() const {
+    return this->regionCount;
+}
+
+int RAtlas::getPageSize() const {
+    return this->pageSize;
+}
+
+int RAtlas::getComponents() const {
+    return this->components;
+}
@@ -46,11 +46,17 @@ void RDotPipeline::setTransform(RMatrix4& matrix){
     glUniformMatrix4fv(this->internalShader->getTransformMatrixUniform(), 1, GL_FALSE, matrix.getArray());
 }
 
+int RDotPipeline::getVertexFormat() const {
+    // Position + color, interleaved
+    return VERTEX_FORMAT_PC;
+}
+
 void RDotPipeline::draw(void* buffer){
     // Shader is currently attached via enable(). Only set the pointers and drawArrays
     // Also, update perfstats
     rbufferheader_t* header = (rbufferheader_t*) buffer;
-    intptr_t buffer_base    = (intptr_t) header + RBUFFERHEADER_SIZE;
+    // Offsets are relative to the bound buffer object when streaming through VBOs
+    intptr_t buffer_base    = header->vbo ? 0 : (intptr_t) header + RBUFFERHEADER_SIZE;
 
     void* vtxaddr = (void*) (buffer_base + header->vtx_offset);
     void* clraddr = (void*) (buffer_base + header->clr_offset);
@@ -58,8 +64,8 @@ void RDotPipeline::draw(void* buffer){
     uint32_t element_count = header->elements;
 
     // Set OpenGL ES attrib pointers
-    glVertexAttribPointer(this->internalShader->getVertexAttrib(), 3, GL_FLOAT, GL_FALSE, 0, vtxaddr);
-    glVertexAttribPointer(this->internalShader->getColorAttrib(),  4, GL_FLOAT, GL_FALSE, 0, clraddr);
+    glVertexAttribPointer(this->internalShader->getVertexAttrib(), 3, GL_FLOAT, GL_FALSE, header->vtx_stride, vtxaddr);
+    glVertexAttribPointer(this->internalShader->getColorAttrib(),  4, GL_UNSIGNED_BYTE, GL_TRUE, header->clr_stride, clraddr);
 
     // Draw arrays!
     glDrawArrays(GL_POINTS, 0, element_count);
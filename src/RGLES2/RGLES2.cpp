@@ -26,6 +26,7 @@
 #include "Debug.h"
 #include "Pixmap.h"
 #include "ImageDriver.h"
+#include "ETC1.h"
 
 // Internal shaders
 #include "RGLES2/shaders/basic.h"
@@ -41,6 +42,40 @@
 #define max(a,b) (((a) > (b)) ? (a) : (b))
 #endif
 
+#ifndef min
+#define min(a,b) (((a) < (b)) ? (a) : (b))
+#endif
+
+
+// OpenGL ES pixel format for a number of components
+static GLenum textureFormat(int components){
+    switch(components){
+        case 1:  return GL_LUMINANCE;
+        case 2:  return GL_LUMINANCE_ALPHA;
+        case 3:  return GL_RGB;
+        default: return GL_RGBA;
+    }
+}
+
+// GL_EXT_unpack_subimage: GL_UNPACK_ROW_LENGTH, strided uploads in one call
+static bool unpackSubimageSupported(){
+    static int supported = -1;
+    if(supported == -1){
+        const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+        supported = (extensions && strstr(extensions, "GL_EXT_unpack_subimage")) ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+// OES_compressed_ETC1_RGB8_texture: ETC1 uploaded as is
+static bool etc1Supported(){
+    static int supported = -1;
+    if(supported == -1){
+        const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+        supported = (extensions && strstr(extensions, "GL_OES_compressed_ETC1_RGB8_texture")) ? 1 : 0;
+    }
+    return supported == 1;
+}
 
 // Implement textures!
 // TODO: Implement textures in class RTexture!
@@ -58,12 +93,17 @@ RTexture::RTexture(){
     this->right  = 0.f;
     this->left   = 0.f;
 
-    this->flipped = false;
+    this->flipped    = false;
+    this->compressed = false;
+    this->alphaPlane = false;
 }
 
 RTexture::RTexture(Pixmap& pixmap){
     // Generate and upload a new texture from pixmap
     Debug::info("[%s:%d]: Generating a new texture from pixmap\n", __FILE__, __LINE__);
+    this->compressed = false;
+    this->alphaPlane = false;
+
     glGenTextures(1, &this->texture_id);
     if(this->texture_id){
         glActiveTexture(GL_TEXTURE0 + 0);
@@ -75,17 +115,18 @@ RTexture::RTexture(Pixmap& pixmap){
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-        if(pixmap.getBpp() == 4){
+        if(pixmap.getComponents() == 4){
             glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         } else {
             glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         }
         // Copy pixels to texture (Upload!)
-        glTexImage2D(GL_TEXTURE_2D, 0, pixmap.getBpp() == 4 ? GL_RGBA : GL_RGB, pixmap.getWidth(), pixmap.getHeight(), 0, pixmap.getBpp() == 4 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, pixmap.getPixels());
+        GLenum format = textureFormat(pixmap.getComponents());
+        glTexImage2D(GL_TEXTURE_2D, 0, format, pixmap.getWidth(), pixmap.getHeight(), 0, format, GL_UNSIGNED_BYTE, pixmap.getPixels());
         // Setup texture parameters
         this->width      = pixmap.getWidth();
         this->height     = pixmap.getHeight();
-        this->components = pixmap.getBpp();
+        this->components = pixmap.getComponents();
 
         this->top        = 1.f;
         this->bottom     = 0.f;
@@ -100,11 +141,273 @@ RTexture::RTexture(Pixmap& pixmap){
     }
 }
 
+RTexture::RTexture(int width, int height, int comp){
+    // Empty texture, filled later with uploadPixels()
+    Debug::info("[%s:%d]: Generating a new empty texture (%dx%dx%d)\n", __FILE__, __LINE__, width, height, comp);
+
+    this->width      = 0;
+    this->height     = 0;
+    this->components = 0;
+
+    this->s_max = 0.f;
+    this->t_max = 0.f;
+
+    this->top    = 0.f;
+    this->bottom = 0.f;
+    this->right  = 0.f;
+    this->left   = 0.f;
+
+    this->flipped    = false;
+    this->compressed = false;
+    this->alphaPlane = false;
+
+    glGenTextures(1, &this->texture_id);
+    if(this->texture_id){
+        glActiveTexture(GL_TEXTURE0 + 0);
+        glBindTexture(GL_TEXTURE_2D, this->texture_id);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        GLenum format = textureFormat(comp);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, NULL);
+
+        this->width      = width;
+        this->height     = height;
+        this->components = comp;
+
+        this->top        = 1.f;
+        this->bottom     = 0.f;
+        this->left       = 0.f;
+        this->right      = 1.f;
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+    } else {
+        Debug::error("[%s:%d]: Cannot generate texture!\n", __FILE__, __LINE__);
+    }
+}
+
+RTexture::RTexture(const RawPack& pack, const char* name){
+    this->texture_id = 0;
+    this->width      = 0;
+    this->height     = 0;
+    this->components = 0;
+
+    this->s_max = 0.f;
+    this->t_max = 0.f;
+
+    this->top    = 0.f;
+    this->bottom = 0.f;
+    this->right  = 0.f;
+    this->left   = 0.f;
+
+    this->flipped    = false;
+    this->compressed = false;
+    this->alphaPlane = false;
+
+    int index = pack.find(name);
+    if(index < 0){
+        Debug::error("[%s:%d]: Texture %s is not in the raw pack!\n", __FILE__, __LINE__, name);
+        return;
+    }
+
+    const rawpack_entry_t* entry  = pack.getEntry(index);
+    const uint8_t*         pixels = pack.acquirePixels(index);
+    if(pixels == NULL) return;
+
+    Debug::info("[%s:%d]: Generating a new texture from raw pack image %s (%ux%ux%d, %d levels)\n", __FILE__, __LINE__, name, entry->width, entry->height, entry->components, entry->mips);
+    glGenTextures(1, &this->texture_id);
+    if(this->texture_id){
+        glActiveTexture(GL_TEXTURE0 + 0);
+        glBindTexture(GL_TEXTURE_2D, this->texture_id);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        this->width      = entry->width;
+        this->height     = entry->height;
+        this->components = entry->components;
+
+        this->top        = 1.f;
+        this->bottom     = 0.f;
+        this->left       = 0.f;
+        this->right      = 1.f;
+
+        // Pack levels use the mip chain layout
+        if(entry->flags & RAWPACK_FLAG_ETC1){
+            this->uploadETC1(pixels, entry->mips);
+        } else {
+            this->uploadMipChain(pixels, entry->mips);
+        }
+    } else {
+        Debug::error("[%s:%d]: Cannot generate texture!\n", __FILE__, __LINE__);
+    }
+
+    pack.releasePixels(index, pixels);
+}
+
+int RTexture::uploadMipChain(const uint8_t* levels, int count){
+    if(this->texture_id == 0 || levels == NULL || count < 1){
+        Debug::error("[%s:%d]: Texture not initialized for uploadMipChain()\n", __FILE__, __LINE__);
+        return 0;
+    }
+
+    // OpenGL ES 2.0 only samples mipmaps of power of 2 textures with every level down to 1x1
+    int  used = 1;
+    int  full = ImageDriver::getMipLevels(this->width, this->height);
+    bool pot  = (this->width & (this->width - 1)) == 0 && (this->height & (this->height - 1)) == 0;
+    if(count >= full && pot) used = full;
+
+    glActiveTexture(GL_TEXTURE0 + 0);
+    glBindTexture(GL_TEXTURE_2D, this->texture_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, used > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+    // Rows are tightly packed in a mip chain
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    GLenum format = textureFormat(this->components);
+    for(int level = 0; level < used; level++){
+        int level_width  = max(this->width  >> level, 1);
+        int level_height = max(this->height >> level, 1);
+        glTexImage2D(GL_TEXTURE_2D, level, format, level_width, level_height, 0, format, GL_UNSIGNED_BYTE, levels + ImageDriver::getMipOffset(this->width, this->height, this->components, level));
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return used;
+}
+
+int RTexture::uploadETC1(const uint8_t* levels, int count){
+    if(this->texture_id == 0 || levels == NULL || count < 1){
+        Debug::error("[%s:%d]: Texture not initialized for uploadETC1()\n", __FILE__, __LINE__);
+        return 0;
+    }
+
+    if(this->components != 3 && this->components != 4){
+        Debug::error("[%s:%d]: ETC1 textures have 3 or 4 components, not %d!\n", __FILE__, __LINE__, this->components);
+        return 0;
+    }
+
+    // Alpha planes are level 0 only
+    if(this->components == 4) count = 1;
+
+    if(!etc1Supported()){
+        // Decoded to a plain mip chain, the GPU memory saving is lost
+        Debug::warning("[%s:%d]: ETC1 not supported by the GPU, decoding %dx%d texture on the CPU\n", __FILE__, __LINE__, this->width, this->height);
+
+        uint8_t* decoded = (uint8_t*) rmalloc(ImageDriver::getMipOffset(this->width, this->height, this->components, count));
+        if(decoded == NULL){
+            Debug::error("[%s:%d]: Cannot allocate memory to decode an ETC1 texture!\n", __FILE__, __LINE__);
+            return 0;
+        }
+
+        size_t offset = 0;
+        for(int level = 0; level < count; level++){
+            int level_width  = max(this->width  >> level, 1);
+            int level_height = max(this->height >> level, 1);
+            ETC1::decode(levels + offset, level_width, level_height, this->components, decoded + ImageDriver::getMipOffset(this->width, this->height, this->components, level));
+            offset += ETC1::imageSize(level_width, level_height, this->components);
+        }
+
+        int used = this->uploadMipChain(decoded, count);
+        rfree(decoded);
+        return used;
+    }
+
+    // Same rules as uploadMipChain()
+    int  used = 1;
+    int  full = ImageDriver::getMipLevels(this->width, this->height);
+    bool pot  = (this->width & (this->width - 1)) == 0 && (this->height & (this->height - 1)) == 0;
+    if(count >= full && pot) used = full;
+
+    glActiveTexture(GL_TEXTURE0 + 0);
+    glBindTexture(GL_TEXTURE_2D, this->texture_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, used > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+    size_t offset = 0;
+    for(int level = 0; level < used; level++){
+        int    level_width  = max(this->width  >> level, 1);
+        int    level_height = max(this->height >> level, 1);
+        int    rows         = (this->components == 4) ? 2 * ETC1::planeHeight(level_height) : level_height;
+        size_t size         = ETC1::encodedSize(level_width, rows);
+
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_ETC1_RGB8_OES, level_width, rows, 0, (GLsizei) size, levels + offset);
+        offset += size;
+    }
+
+    this->compressed = true;
+    if(this->components == 4){
+        // Color in the top rows, alpha 0.5 below
+        this->alphaPlane = true;
+        this->s_max      = 1.f;
+        this->t_max      = (float) this->height / (2 * ETC1::planeHeight(this->height));
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return used;
+}
+
+void RTexture::uploadPixels(int px, int py, int width, int height, int cmp, void* pixels){
+    this->uploadPixels(px, py, PixmapView(pixels, width, height, cmp, 0));
+}
+
+void RTexture::uploadPixels(int px, int py, const PixmapView& view){
+    if(this->texture_id == 0 || !view.exists()){
+        Debug::error("[%s:%d]: Texture not initialized for uploadPixels()\n", __FILE__, __LINE__);
+        return;
+    }
+
+    if(this->compressed){
+        Debug::error("[%s:%d]: Cannot upload pixels to a compressed texture!\n", __FILE__, __LINE__);
+        return;
+    }
+
+    if(view.getComponents() != this->components){
+        Debug::error("[%s:%d]: Cannot upload %d component pixels to a %d component texture!\n", __FILE__, __LINE__, view.getComponents(), this->components);
+        return;
+    }
+
+    // Clip to the texture
+    PixmapView region = view.region(-px, -py, this->width, this->height);
+    if(!region.exists()) return;
+    px = max(px, 0);
+    py = max(py, 0);
+
+    GLenum format = textureFormat(this->components);
+
+    glBindTexture(GL_TEXTURE_2D, this->texture_id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if(region.isContiguous()){
+        glTexSubImage2D(GL_TEXTURE_2D, 0, px, py, region.getWidth(), region.getHeight(), format, GL_UNSIGNED_BYTE, region.getPixels());
+    } else if(unpackSubimageSupported() && (region.getStride() % region.getComponents()) == 0){
+        // Row length is in pixels
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, region.getStride() / region.getComponents());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, px, py, region.getWidth(), region.getHeight(), format, GL_UNSIGNED_BYTE, region.getPixels());
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+    } else {
+        // Plain OpenGL ES 2.0 has no row length, one row at a time
+        for(int y = 0; y < region.getHeight(); y++){
+            glTexSubImage2D(GL_TEXTURE_2D, 0, px, py + y, region.getWidth(), 1, format, GL_UNSIGNED_BYTE, region.getRow(y));
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 RTexture::~RTexture(){
     if(this->texture_id) this->destroy();
 }
 
 int RTexture::genMipmaps(){
+    if(this->compressed){
+        Debug::error("[%s:%d]: Cannot generate mipmaps of a compressed texture!\n", __FILE__, __LINE__);
+        return 1;
+    }
+
     if(this->texture_id){
         this->attach();
         glGenerateMipmap(GL_TEXTURE_2D);
@@ -161,6 +464,18 @@ bool RTexture::isFlipped() const {
     return this->flipped;
 }
 
+bool RTexture::isCompressed() const {
+    return this->compressed;
+}
+
+bool RTexture::hasAlphaPlane() const {
+    return this->alphaPlane;
+}
+
+GLuint RTexture::getTextureId() const {
+    return this->texture_id;
+}
+
 float RTexture::Top() const {
     return this->top;
 }
@@ -195,6 +510,107 @@ static void zeroBufferElements(void* buffer){
     header->vtx_count = 0;
     header->clr_count = 0;
     header->txc_count = 0;
+    header->idx_count = 0;
+    header->flags    &= ~FLAG_QUAD_INDICES;
+}
+
+// Set draw buffer layout (offsets and strides) for a vertex format. Buffer must be empty!
+static void setBufferFormat(void* buffer, int format){
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+    uint32_t elements       = header->buffer_max_elements;
+
+    // Only the shape format has shape parameters
+    header->prm_stride = 0;
+    header->prm_offset = 0;
+
+    switch(format){
+        case VERTEX_FORMAT_PC:
+            header->vtx_stride = sizeof(vertex3_t) + sizeof(color4_t);
+            header->clr_stride = header->vtx_stride;
+            header->txc_stride = 0;
+
+            header->vtx_offset = 0;
+            header->clr_offset = sizeof(vertex3_t);
+            header->txc_offset = 0;
+            break;
+        case VERTEX_FORMAT_PCT:
+            header->vtx_stride = sizeof(vertex3_t) + sizeof(color4_t) + sizeof(texcrd2_t);
+            header->clr_stride = header->vtx_stride;
+            header->txc_stride = header->vtx_stride;
+
+            header->vtx_offset = 0;
+            header->clr_offset = sizeof(vertex3_t);
+            header->txc_offset = sizeof(vertex3_t) + sizeof(color4_t);
+            break;
+        case VERTEX_FORMAT_PCTU:
+            header->vtx_stride = sizeof(vertex3_t) + sizeof(color4_t) + sizeof(texcrd3_t);
+            header->clr_stride = header->vtx_stride;
+            header->txc_stride = header->vtx_stride;
+
+            header->vtx_offset = 0;
+            header->clr_offset = sizeof(vertex3_t);
+            header->txc_offset = sizeof(vertex3_t) + sizeof(color4_t);
+            break;
+        case VERTEX_FORMAT_PCTS:
+            header->vtx_stride = sizeof(vertex3_t) + sizeof(color4_t) + sizeof(texcrd2_t) + sizeof(shape4_t);
+            header->clr_stride = header->vtx_stride;
+            header->txc_stride = header->vtx_stride;
+            header->prm_stride = header->vtx_stride;
+
+            header->vtx_offset = 0;
+            header->clr_offset = sizeof(vertex3_t);
+            header->txc_offset = sizeof(vertex3_t) + sizeof(color4_t);
+            header->prm_offset = sizeof(vertex3_t) + sizeof(color4_t) + sizeof(texcrd2_t);
+            break;
+        default:
+            format = VERTEX_FORMAT_PLANAR;
+
+            header->vtx_stride = sizeof(vertex3_t);
+            header->clr_stride = sizeof(color4_t);
+            header->txc_stride = sizeof(texcrd2_t);
+
+            header->vtx_offset = 0;
+            header->clr_offset = (elements * sizeof(vertex3_t));
+            header->txc_offset = (header->clr_offset) + (elements * sizeof(color4_t));
+            break;
+    }
+
+    header->format = format;
+}
+
+// Fill the header of a new draw buffer (See RBUFFER_TOTAL_SIZE)
+static void initBufferHeader(void* buffer, uint32_t elements, uint32_t indices, int format, uint32_t flags){
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+
+    header->buffer_size         = RBUFFER_TOTAL_SIZE(elements, indices) - RBUFFERHEADER_SIZE;
+    header->buffer_max_elements = elements;
+    header->buffer_max_indices  = indices;
+    header->elements            = 0;
+
+    header->vtx_count           = 0;
+    header->clr_count           = 0;
+    header->txc_count           = 0;
+    header->idx_count           = 0;
+
+    // Index stream lives after the elements, whatever the vertex format is
+    header->idx_offset          = elements * RBUFFER_ELEMENT_SIZE;
+
+    header->flags               = flags;
+    header->vbo                 = 0;
+    header->ibo                 = 0;
+
+    setBufferFormat(buffer, format);
+}
+
+// Bytes used by the elements of a buffer (What has to reach the GPU)
+static size_t bufferBytesUsed(void* buffer){
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+
+    if(header->format == VERTEX_FORMAT_PLANAR){
+        return (header->elements * header->vtx_stride) + (header->elements * header->clr_stride) + (header->txc_count * header->txc_stride);
+    }
+    // Interleaved, all attributes live in the same block
+    return header->elements * header->vtx_stride;
 }
 
 // IMPLEMENTING PIPELINES!
@@ -204,7 +620,21 @@ RPipeline::~RPipeline(){
 
 }
 
-// TODO. Set texture uniforms on texture pipeline enable!
+int RPipeline::getVertexFormat() const {
+    return VERTEX_FORMAT_PLANAR;
+}
+
+void RPipeline::enableAlphaBlend(){
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void RPipeline::disableAlphaBlend(){
+    // GL default, blending pipelines without their own function get it
+    glBlendFunc(GL_ONE, GL_ZERO);
+    glDisable(GL_BLEND);
+}
+
 // Here starts RGLES2 implementation!
 
 RGLES2::RGLES2(){
@@ -215,6 +645,40 @@ RGLES2::RGLES2(){
     
     this->drawBuffer             = NULL;
     this->drawBufferSizeElements = DEFAULT_DRAW_BUFFER_SIZE_ELEMENTS;
+    this->initFlags              = INIT_FLAG_NONE;
+
+    for(int i = 0; i < VBO_RING_SIZE; i++){
+        this->streamBuffers[i]          = 0;
+        this->streamBufferSizes[i]      = 0;
+        this->streamIndexBuffers[i]     = 0;
+        this->streamIndexBufferSizes[i] = 0;
+    }
+    this->streamBufferIndex = 0;
+    this->quadIndexBuffer   = 0;
+
+    this->circle_steps    = CIRCLE_STEPS;
+    this->circleTolerance = CIRCLE_TOLERANCE;
+    for(int i = 0; i <= CIRCLE_MAX_STEPS; i++) this->circleTables[i] = NULL;
+
+    for(int i = 0; i < 4; i++){
+        this->viewportRect[i] = 0;
+        this->scissorRect[i]  = 0;
+    }
+    this->scissorEnabled = 0;
+
+    this->recordingCommands = false;
+    this->recordPipeline    = NULL;
+    this->recordTexture     = 0;
+    this->commandArena      = NULL;
+    this->commandArenaSize  = 0;
+    this->commandArenaUsed  = 0;
+    this->commands          = NULL;
+    this->commandCount      = 0;
+    this->commandCapacity   = 0;
+    this->states            = NULL;
+    this->stateCount        = 0;
+    this->stateCapacity     = 0;
+    this->stateDirty        = true;
 
     this->currentRPipeline = NULL;
 
@@ -222,6 +686,12 @@ RGLES2::RGLES2(){
     this->dotPipeline      = NULL;
     this->linePipeline     = NULL;
     this->trianglePipeline = NULL;
+    this->shapePipeline    = NULL;
+    this->particlePipeline = NULL;
+    this->texturePipeline  = NULL;
+
+    this->textureCache     = NULL;
+    this->uploadQueue      = NULL;
 }
 
 RGLES2::~RGLES2(){
@@ -275,7 +745,8 @@ void* RGLES2::genDrawBuffers(void* drawBuffer, uint32_t drawBufferElements){
         Debug::info("[%s:%d]: Generating drawBuffer for %d elements...\n", __FILE__, __LINE__, (int) drawBufferElements);
     }
 
-    size_t total_bytes = RBUFFERHEADER_SIZE + (drawBufferElements * 3 * sizeof(float)) + (drawBufferElements * 4 * sizeof(float)) + (drawBufferElements * 2 * sizeof(float));
+    uint32_t drawBufferIndices = drawBufferElements * RBUFFER_INDICES_PER_ELEMENT;
+    size_t total_bytes = RBUFFER_TOTAL_SIZE(drawBufferElements, drawBufferIndices);
     Debug::info("[%s:%d]: Total bytes to allocate: %d bytes\n", __FILE__, __LINE__, (int) total_bytes);
     
 
@@ -285,29 +756,26 @@ void* RGLES2::genDrawBuffers(void* drawBuffer, uint32_t drawBufferElements){
     } else {
         t_drawBuffer = (void*) rmalloc(total_bytes);
     }
-    // Set header!
-    rbufferheader_t* header = (rbufferheader_t*) t_drawBuffer;
+    if(t_drawBuffer == NULL) return NULL;
 
-    header->buffer_size         = total_bytes - RBUFFERHEADER_SIZE;
-    header->buffer_max_elements = drawBufferElements;
-    header->elements            = 0;
-
-    header->vtx_count           = 0;
-    header->clr_count           = 0;
-    header->txc_count           = 0;
-
-    header->vtx_offset          = 0;
-    header->clr_offset          = (drawBufferElements * 3 * sizeof(float));
-    header->txc_offset          = (header->clr_offset) + (drawBufferElements * 4 * sizeof(float));
-
-    // NO FLAGS!
-    header->flags               = FLAG_NONE;
+    // Set header! NO FLAGS! Layout for the active pipeline
+    initBufferHeader(t_drawBuffer, drawBufferElements, drawBufferIndices, this->getVertexFormat(), FLAG_NONE);
     
     return t_drawBuffer;
 }
 
+int RGLES2::getVertexFormat() const {
+    if(this->currentRPipeline) return this->currentRPipeline->getVertexFormat();
+    return VERTEX_FORMAT_PLANAR;
+}
+
 int RGLES2::init(){
+    return this->init(INIT_FLAG_NONE);
+}
+
+int RGLES2::init(uint32_t flags){
     Debug::info("[%s:%d]: Starting RGLES2 rendering backend for Enyx!\n",__FILE__,__LINE__);
+    this->initFlags = flags;
 
     if(this->baseWindow == NULL){
         Debug::error("[%s:%d]: Cannot start renderer because baseWindow is NOT set!\n", __FILE__, __LINE__);
@@ -401,8 +869,15 @@ int RGLES2::init(){
     Debug::info("[%s:%d]: Line pipeline done!\n", __FILE__, __LINE__);
     this->trianglePipeline = new RTrianglePipeline();
     Debug::info("[%s:%d]: Triangle pipeline done!\n", __FILE__, __LINE__);
-    // this->texturePipelin   = new RTexturePipeline();
-    Debug::warning("[%s:%d]: Texture pipeline NOT created! TODO!\n", __FILE__, __LINE__);
+    this->shapePipeline    = new RShapePipeline();
+    Debug::info("[%s:%d]: Shape pipeline done!\n", __FILE__, __LINE__);
+    this->particlePipeline = new RParticlePipeline();
+    Debug::info("[%s:%d]: Particle pipeline done!\n", __FILE__, __LINE__);
+    this->texturePipeline  = new RTexturePipeline(this->gles2_info.MAX_TEXTURE_IMAGE_UNITS);
+    Debug::info("[%s:%d]: Texture pipeline done!\n", __FILE__, __LINE__);
+
+    this->textureCache     = new RTextureCache(TEXTURE_CACHE_DEFAULT_BUDGET);
+    this->uploadQueue      = new RUploadQueue(TEXTURE_UPLOAD_FRAME_BUDGET);
 
     // Init buffers now!
     this->drawBuffer = this->genDrawBuffers(this->drawBuffer, this->drawBufferSizeElements);
@@ -411,10 +886,61 @@ int RGLES2::init(){
         return -3;
     }
 
-    // Default circle steps
-    this->circle_steps = CIRCLE_STEPS;
+    // VBO streaming ring. Storage is allocated (and orphaned) on every upload
+    if(this->initFlags & INIT_FLAG_VBO_STREAMING){
+        glGenBuffers(VBO_RING_SIZE, this->streamBuffers);
+        glGenBuffers(VBO_RING_SIZE, this->streamIndexBuffers);
+        for(int i = 0; i < VBO_RING_SIZE; i++){
+            this->streamBufferSizes[i]      = 0;
+            this->streamIndexBufferSizes[i] = 0;
+        }
+        this->streamBufferIndex = 0;
+        Debug::info("[%s:%d]: VBO streaming enabled (%d buffer objects)\n", __FILE__, __LINE__, VBO_RING_SIZE);
+    }
+
+    // Quads (rects, sprites) share one static index buffer
+    this->genQuadIndexBuffer();
+
+    // Deferred commands. Draw calls are recorded until render()
+    if(this->initFlags & INIT_FLAG_DEFERRED){
+        this->commandArenaSize = COMMAND_ARENA_INITIAL_SIZE;
+        this->commandArena     = rmalloc(this->commandArenaSize);
+        this->commandCapacity  = COMMAND_LIST_INITIAL_SIZE;
+        this->commands         = (rcommand_t*) rmalloc(this->commandCapacity * sizeof(rcommand_t));
+        this->stateCapacity    = COMMAND_LIST_INITIAL_SIZE;
+        this->states           = (rstate_t*) rmalloc(this->stateCapacity * sizeof(rstate_t));
+
+        if(this->commandArena == NULL || this->commands == NULL || this->states == NULL){
+            Debug::error("[%s:%d]: Cannot allocate deferred command lists! Drawing immediately\n", __FILE__, __LINE__);
+            if(this->commandArena) rfree(this->commandArena);
+            if(this->commands)     rfree(this->commands);
+            if(this->states)       rfree(this->states);
+
+            this->commandArena = NULL;
+            this->commands     = NULL;
+            this->states       = NULL;
+            this->initFlags   &= ~INIT_FLAG_DEFERRED;
+        } else {
+            this->recordingCommands = true;
+            this->discardCommands();
+            Debug::info("[%s:%d]: Deferred command mode enabled\n", __FILE__, __LINE__);
+        }
+    }
+
     // Renderer mvpMatrix
     this->tMatrix = RMatrix4::ortho(0, this->baseWindow->getWidth(), this->baseWindow->getHeight(), 0, -1, 1);
+    this->projMatrix    = this->tMatrix;
+    this->modelMatrix.loadIdentity();
+    this->modelIdentity = true;
+
+    this->viewportRect[0] = 0;
+    this->viewportRect[1] = 0;
+    this->viewportRect[2] = this->baseWindow->getWidth();
+    this->viewportRect[3] = this->baseWindow->getHeight();
+
+    this->zeroPerfstats();
+    this->framePerfstats = perfstats;
+    this->frameStartTime = System::millis();
 
     Debug::info("[%s:%d]: RGLES2 renderer init completed!\n", __FILE__, __LINE__);
     return 0;
@@ -427,10 +953,48 @@ int RGLES2::destroy(){
     if(this->dotPipeline)      delete static_cast<RDotPipeline*>(this->dotPipeline);
     if(this->linePipeline)     delete static_cast<RLinePipeline*>(this->linePipeline);
     if(this->trianglePipeline) delete static_cast<RTrianglePipeline*>(this->trianglePipeline);
+    if(this->shapePipeline)    delete static_cast<RShapePipeline*>(this->shapePipeline);
+    if(this->particlePipeline) delete static_cast<RParticlePipeline*>(this->particlePipeline);
+    if(this->texturePipeline)  delete static_cast<RTexturePipeline*>(this->texturePipeline);
 
     this->dotPipeline      = NULL;
     this->linePipeline     = NULL;
     this->trianglePipeline = NULL;
+    this->shapePipeline    = NULL;
+    this->particlePipeline = NULL;
+    this->texturePipeline  = NULL;
+
+    if(this->streamBuffers[0]){
+        glDeleteBuffers(VBO_RING_SIZE, this->streamBuffers);
+        glDeleteBuffers(VBO_RING_SIZE, this->streamIndexBuffers);
+        for(int i = 0; i < VBO_RING_SIZE; i++){
+            this->streamBuffers[i]          = 0;
+            this->streamBufferSizes[i]      = 0;
+            this->streamIndexBuffers[i]     = 0;
+            this->streamIndexBufferSizes[i] = 0;
+        }
+    }
+
+    if(this->quadIndexBuffer){
+        glDeleteBuffers(1, &this->quadIndexBuffer);
+        this->quadIndexBuffer = 0;
+    }
+
+    for(int i = 0; i <= CIRCLE_MAX_STEPS; i++){
+        if(this->circleTables[i]) rfree(this->circleTables[i]);
+        this->circleTables[i] = NULL;
+    }
+
+    if(this->commandArena) rfree(this->commandArena);
+    if(this->commands)     rfree(this->commands);
+    if(this->states)       rfree(this->states);
+
+    this->commandArena      = NULL;
+    this->commands          = NULL;
+    this->states            = NULL;
+    this->commandCount      = 0;
+    this->stateCount        = 0;
+    this->recordingCommands = false;
 
     if(this->drawBuffer){
         Debug::info("[%s:%d]: Freeing the drawBuffer...\n", __FILE__, __LINE__);
@@ -439,6 +1003,18 @@ int RGLES2::destroy(){
     }
 
     // Delete renderer's textures / OpenGL context
+    if(this->textureCache){
+        rtexturecachestats_t stats = this->textureCache->getStats();
+        Debug::info("[%s:%d]: Deleting %u cached textures (%lu bytes)\n", __FILE__, __LINE__, stats.resident, (unsigned long) stats.bytes_resident);
+
+        delete this->textureCache;
+        this->textureCache = NULL;
+    }
+
+    if(this->uploadQueue){
+        delete this->uploadQueue;
+        this->uploadQueue = NULL;
+    }
 
     if(this->gContext){
         SDL_GL_DeleteContext(this->gContext);
@@ -454,7 +1030,7 @@ void RGLES2::submit(){
     if(header->elements == 0) return;
 
     if(this->currentRPipeline){
-        this->currentRPipeline->draw(this->drawBuffer);
+        this->drawPipelineBuffer(this->drawBuffer);
         this->clearBuffers();
     } else {
         Debug::warning("[%s:%d]: submit() method called but no rendering pipeline is active!\n", __FILE__, __LINE__);
@@ -467,7 +1043,7 @@ void RGLES2::submit(void* buffer){
     if(header->elements == 0) return;
 
     if(this->currentRPipeline){
-        this->currentRPipeline->draw(buffer);
+        this->drawPipelineBuffer(buffer);
         zeroBufferElements(buffer);
     } else {
         Debug::warning("[%s:%d]: submit() method called but no rendering pipeline is active!\n", __FILE__, __LINE__);
@@ -475,98 +1051,621 @@ void RGLES2::submit(void* buffer){
 }
 
 void RGLES2::render(){
-    // Frame rendered!
+    // Frame rendered! Deferred commands are drawn now
+    if(this->recordingCommands) this->replayCommands();
     this->submit();
+    // Textures are bound again next frame, deleted ones must not keep a unit
+    if(this->texturePipeline) this->texturePipeline->clearTextures();
+    // Textures drawn this frame can be evicted again
+    if(this->textureCache)    this->textureCache->nextFrame();
     glFlush();
     glFinish();
     // Swap chain / Show changes in window
     this->baseWindow->GL_SwapWindow();
-}
 
-void RGLES2::setPipeline(RPipeline* pipeline){
-    if(this->currentRPipeline != pipeline){
-        // Pipeline change! Submit, dettach old pipeline and attach new pipeline
-        this->submit();
+    // Keep this frame stats and start counting a new frame
+    uint32_t now = System::millis();
+    perfstats.time_ms    = now - this->frameStartTime;
+    this->framePerfstats = perfstats;
+    this->frameStartTime = now;
+    this->zeroPerfstats();
 
-        if(this->currentRPipeline) this->currentRPipeline->disable();
-        this->currentRPipeline = pipeline;
-        this->currentRPipeline->enable();
+    // Next rows of queued textures, before anything of the new frame is drawn
+    if(this->uploadQueue) perfstats.bytes_transfered += this->uploadQueue->process();
+}
 
-        // Set transformation matrix uniform!!
-        this->currentRPipeline->setTransform(this->tMatrix);
-    }
+void RGLES2::zeroPerfstats(){
+    memset(&perfstats, 0, sizeof(rperfstats_t));
 }
 
+rperfstats_t RGLES2::getPerfstats() const {
+    return this->framePerfstats;
+}
 
-void RGLES2::clearBuffers(){
-    zeroBufferElements(this->drawBuffer);
+RTextureCache* RGLES2::getTextureCache(){
+    return this->textureCache;
 }
 
-void* RGLES2::allocateElements(size_t elements, rbufferptr_t* rbufferptr){
-    // Allocate "elements" elemens for drawing! (Allocates drawBuffer memory)
-    rbufferheader_t* header = (rbufferheader_t*) this->drawBuffer;
+RUploadQueue* RGLES2::getUploadQueue(){
+    return this->uploadQueue;
+}
 
-    if(elements > header->buffer_max_elements){
-        // This will create a temporal buffer
-        size_t total_bytes = RBUFFERHEADER_SIZE + (elements * 3 * sizeof(float)) + (elements * 4 * sizeof(float)) + (elements * 2 * sizeof(float));
-        void* tmp_buffer = (void*) rmalloc(total_bytes);
+void RGLES2::streamBuffer(void* buffer){
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+    intptr_t buffer_base    = (intptr_t) header + RBUFFERHEADER_SIZE;
+
+    // Next buffer object in the ring
+    this->streamBufferIndex = (this->streamBufferIndex + 1) % VBO_RING_SIZE;
+    int    index = this->streamBufferIndex;
+    GLuint vbo   = this->streamBuffers[index];
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    // Orphan the old storage, the driver can keep drawing from it while we fill the new one.
+    // Grows if a temporal buffer does not fit.
+    size_t store_size = max((size_t) header->buffer_size, this->streamBufferSizes[index]);
+    glBufferData(GL_ARRAY_BUFFER, store_size, NULL, GL_STREAM_DRAW);
+    this->streamBufferSizes[index] = store_size;
+
+    // Upload only the used sub-ranges. Buffer offsets are kept, pipelines use them as VBO offsets
+    if(header->format == VERTEX_FORMAT_PLANAR){
+        size_t vtx_bytes = header->elements  * header->vtx_stride;
+        size_t clr_bytes = header->elements  * header->clr_stride;
+        size_t txc_bytes = header->txc_count * header->txc_stride;
+
+        glBufferSubData(GL_ARRAY_BUFFER, header->vtx_offset, vtx_bytes, (void*) (buffer_base + header->vtx_offset));
+        glBufferSubData(GL_ARRAY_BUFFER, header->clr_offset, clr_bytes, (void*) (buffer_base + header->clr_offset));
+        if(txc_bytes) glBufferSubData(GL_ARRAY_BUFFER, header->txc_offset, txc_bytes, (void*) (buffer_base + header->txc_offset));
+    } else {
+        // Interleaved: one contiguous range
+        glBufferSubData(GL_ARRAY_BUFFER, 0, header->elements * header->vtx_stride, (void*) buffer_base);
+    }
 
-        if(tmp_buffer){
-            rbufferheader_t* tmp_header = (rbufferheader_t*) tmp_buffer;
+    header->vbo = vbo;
+    perfstats.bytes_uploaded += bufferBytesUsed(buffer);
 
-            tmp_header->buffer_size         = total_bytes - RBUFFERHEADER_SIZE;
-            tmp_header->buffer_max_elements = elements;
-            tmp_header->elements            = 0;
+    // Indices, unless the static quad index buffer is already bound
+    if(header->idx_count && header->ibo == 0){
+        GLuint ibo        = this->streamIndexBuffers[index];
+        size_t idx_bytes  = header->idx_count * sizeof(rindex_t);
+        size_t idx_size   = max((size_t) header->buffer_max_indices * sizeof(rindex_t), this->streamIndexBufferSizes[index]);
 
-            tmp_header->vtx_count           = 0;
-            tmp_header->clr_count           = 0;
-            tmp_header->txc_count           = 0;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx_size, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, idx_bytes, (void*) (buffer_base + header->idx_offset));
+        this->streamIndexBufferSizes[index] = idx_size;
 
-            tmp_header->vtx_offset          = 0;
-            tmp_header->clr_offset          = (elements * 3 * sizeof(float));
-            tmp_header->txc_offset          = (header->clr_offset) + (elements * 4 * sizeof(float));
+        header->ibo = ibo;
+        perfstats.bytes_uploaded += idx_bytes;
+    }
+}
 
-            // Temporal buffer flag!
-            tmp_header->flags               = FLAG_TEMPORAL;
+void RGLES2::drawPipelineBuffer(void* buffer){
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+    uint32_t element_count  = header->elements;
+    uint32_t index_count    = header->idx_count;
+    size_t   buffer_bytes   = bufferBytesUsed(buffer);
+
+    // Only quads? Use the static index buffer, nothing to transfer
+    if(index_count && (header->flags & FLAG_QUAD_INDICES) && this->quadIndexBuffer && index_count <= (QUAD_INDEX_BUFFER_QUADS * 6)){
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->quadIndexBuffer);
+        header->ibo = this->quadIndexBuffer;
+    } else {
+        buffer_bytes += index_count * sizeof(rindex_t);
+    }
 
-            // Buffer created! Return info to rbufferptr struct
-            rbufferptr->vtx_ptr = (void*) ((intptr_t) tmp_buffer + RBUFFERHEADER_SIZE + header->vtx_offset);
-            rbufferptr->nrm_ptr = (void*) NULL;
-            rbufferptr->clr_ptr = (void*) ((intptr_t) tmp_buffer + RBUFFERHEADER_SIZE + header->clr_offset);
-            rbufferptr->txc_ptr = (void*) ((intptr_t) tmp_buffer + RBUFFERHEADER_SIZE + header->txc_offset);
+    if(this->initFlags & INIT_FLAG_VBO_STREAMING){
+        this->streamBuffer(buffer);
+    }
 
-            // Set number of elements
-            tmp_header->elements = elements;
-            
-            return tmp_buffer;
-        } else {
-            Debug::error("[%s:%d]: Cannot allocate %d elements for drawing operation in auxiliary buffer!\n", __FILE__, __LINE__, (int) elements);
-            return NULL;
-        }
+    this->currentRPipeline->draw(buffer);
+
+    if(header->vbo){
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        header->vbo = 0;
+    }
+
+    if(header->ibo){
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        header->ibo = 0;
+    }
+
+    perfstats.drawcalls++;
+    perfstats.vertices_drawn           += element_count;
+    perfstats.indices_drawn            += index_count;
+    perfstats.buffer_max_elements_used  = max(perfstats.buffer_max_elements_used, element_count);
+    perfstats.bytes_transfered         += buffer_bytes;
+}
+
+void RGLES2::setPipeline(RPipeline* pipeline){
+    if(this->recordingCommands){
+        // Nothing to switch yet, the command remembers it
+        this->recordPipeline = pipeline;
+        return;
+    }
+
+    if(this->currentRPipeline != pipeline){
+        // Pipeline change! Submit, dettach old pipeline and attach new pipeline
+        this->submit();
+
+        if(this->currentRPipeline) this->currentRPipeline->disable();
+        this->currentRPipeline = pipeline;
+        this->currentRPipeline->enable();
+        perfstats.context_changes++;
+
+        // Draw buffer is empty now. Layout it for the new pipeline
+        if(((rbufferheader_t*) this->drawBuffer)->format != (uint32_t) pipeline->getVertexFormat()){
+            setBufferFormat(this->drawBuffer, pipeline->getVertexFormat());
+        }
+
+        // Set transformation matrix uniform!!
+        this->currentRPipeline->setTransform(this->shaderMatrix());
+    }
+}
+
+int RGLES2::setTexture(GLuint texture){
+    if(this->recordingCommands){
+        // The unit is known at replay
+        this->recordTexture = texture;
+        return 0;
+    }
+
+    int textures = this->texturePipeline->getTextureCount();
+    int unit     = this->texturePipeline->getTextureUnit(texture);
+
+    if(unit < 0){
+        // Every unit is taken. Draw the pending quads, then start again from unit 0
+        this->submit();
+        this->texturePipeline->clearTextures();
+        textures = 0;
+        unit     = this->texturePipeline->getTextureUnit(texture);
+    }
+
+    if(this->texturePipeline->getTextureCount() != textures) perfstats.texture_changes++;
+    return unit;
+}
+
+
+void RGLES2::clearBuffers(){
+    zeroBufferElements(this->drawBuffer);
+}
+
+void* RGLES2::allocateElements(size_t elements, rbufferptr_t* rbufferptr){
+    return this->allocateElements(elements, 0, rbufferptr);
+}
+
+void* RGLES2::allocateElements(size_t elements, size_t indices, rbufferptr_t* rbufferptr){
+    // Allocate "elements" elemens for drawing! (Allocates drawBuffer memory)
+    rbufferheader_t* header = (rbufferheader_t*) this->drawBuffer;
+    void* buffer            = this->drawBuffer;
+
+    if(this->recordingCommands){
+        // Deferred: the command gets its own buffer in the command arena
+        buffer = this->allocateCommand(elements, indices, this->recordPipeline->getVertexFormat());
+        if(buffer == NULL) return NULL;
+
+        header = (rbufferheader_t*) buffer;
+    } else if(elements > header->buffer_max_elements || indices > header->buffer_max_indices){
+        if(indices && elements > RBUFFER_MAX_INDEXED_ELEMENTS){
+            Debug::error("[%s:%d]: Cannot index %d elements with 16 bit indices!\n", __FILE__, __LINE__, (int) elements);
+            return NULL;
+        }
+
+        // This will create a temporal buffer, same vertex format as the draw buffer
+        buffer = (void*) rmalloc(RBUFFER_TOTAL_SIZE(elements, indices));
+
+        if(buffer == NULL){
+            Debug::error("[%s:%d]: Cannot allocate %d elements for drawing operation in auxiliary buffer!\n", __FILE__, __LINE__, (int) elements);
+            return NULL;
+        }
+
+        // Temporal buffer flag!
+        initBufferHeader(buffer, elements, indices, header->format, FLAG_TEMPORAL);
+        header = (rbufferheader_t*) buffer;
     } else {
-        if(elements > (header->buffer_max_elements - header->elements)){
+        // Mixing indexed and non indexed elements turns the whole buffer indexed
+        size_t need_indices = indices;
+        if(indices == 0 && header->idx_count)          need_indices = elements;
+        if(indices != 0 && header->idx_count == 0)     need_indices = indices + header->elements;
+
+        bool no_space = elements > (header->buffer_max_elements - header->elements);
+        no_space     |= need_indices > (header->buffer_max_indices - header->idx_count);
+        no_space     |= need_indices && (header->elements + elements) > RBUFFER_MAX_INDEXED_ELEMENTS;
+
+        if(no_space){
             // No free space... Submit current buffers!
             this->submit();
         }
+    }
+
+    // Allocate space for "elements" elements. Same math for planar and interleaved layouts
+    intptr_t buffer_base = (intptr_t) buffer + RBUFFERHEADER_SIZE;
+    rindex_t* idx_stream = (rindex_t*) (buffer_base + header->idx_offset);
+
+    rbufferptr->vtx_ptr    = (void*) (buffer_base + header->vtx_offset + (header->vtx_count * header->vtx_stride));
+    rbufferptr->nrm_ptr    = (void*) NULL;
+    rbufferptr->clr_ptr    = (void*) (buffer_base + header->clr_offset + (header->clr_count * header->clr_stride));
+    rbufferptr->txc_ptr    = header->txc_stride ? (void*) (buffer_base + header->txc_offset + (header->txc_count * header->txc_stride)) : NULL;
+
+    rbufferptr->vtx_stride = header->vtx_stride;
+    rbufferptr->clr_stride = header->clr_stride;
+    rbufferptr->txc_stride = header->txc_stride;
+    rbufferptr->prm_ptr    = header->prm_stride ? (void*) (buffer_base + header->prm_offset + (header->vtx_count * header->prm_stride)) : NULL;
+    rbufferptr->prm_stride = header->prm_stride;
+
+    rbufferptr->transform  = ((this->initFlags & INIT_FLAG_CPU_TRANSFORM) && !this->modelIdentity) ? this->modelMatrix.e : NULL;
+
+    rbufferptr->idx_ptr    = NULL;
+    rbufferptr->idx_base   = header->elements;
+
+    if(indices){
+        if(header->idx_count == 0){
+            // First indices of this buffer. Index the elements already there
+            for(uint32_t i = 0; i < header->elements; i++) idx_stream[i] = (rindex_t) i;
+            header->idx_count = header->elements;
+        }
+
+        rbufferptr->idx_ptr = idx_stream + header->idx_count;
+        header->idx_count  += indices;
+        // Caller writes any pattern, allocateQuads() sets it again
+        header->flags      &= ~FLAG_QUAD_INDICES;
+    } else if(header->idx_count){
+        // Non indexed elements in an indexed buffer
+        for(uint32_t i = 0; i < elements; i++) idx_stream[header->idx_count + i] = (rindex_t) (header->elements + i);
+        header->idx_count  += elements;
+        header->flags      &= ~FLAG_QUAD_INDICES;
+    }
+
+    // Set new element count
+    header->elements += elements;
+
+    return buffer;
+}
+
+void* RGLES2::allocateQuads(size_t quads, rbufferptr_t* rbufferptr){
+    // allocateElements() clears the quad flag, keep it
+    bool quads_before = (((rbufferheader_t*) this->drawBuffer)->flags & FLAG_QUAD_INDICES) != 0;
+
+    void* buffer = this->allocateElements(quads * 4, quads * 6, rbufferptr);
+    if(buffer == NULL) return NULL;
+
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+    rindex_t* indices       = rbufferptr->idx_ptr;
+    uint32_t  base          = rbufferptr->idx_base;
+
+    for(size_t i = 0; i < quads; i++){
+        uint32_t v = base + (i * 4);
+
+        indices[i*6 + 0] = (rindex_t) (v + 0);
+        indices[i*6 + 1] = (rindex_t) (v + 1);
+        indices[i*6 + 2] = (rindex_t) (v + 2);
+        indices[i*6 + 3] = (rindex_t) (v + 2);
+        indices[i*6 + 4] = (rindex_t) (v + 3);
+        indices[i*6 + 5] = (rindex_t) (v + 0);
+    }
+
+    // Still only quads since the start of the buffer? (Fresh buffers start with no elements)
+    bool quads_only = (header->idx_count == (quads * 6)) ? (base == 0) : quads_before;
+    if(quads_only) header->flags |= FLAG_QUAD_INDICES;
+
+    return buffer;
+}
+
+void RGLES2::genQuadIndexBuffer(){
+    size_t     index_count = QUAD_INDEX_BUFFER_QUADS * 6;
+    rindex_t*  indices     = (rindex_t*) rmalloc(index_count * sizeof(rindex_t));
+
+    if(indices == NULL){
+        Debug::warning("[%s:%d]: Cannot allocate the static quad index buffer! Quads will stream their indices\n", __FILE__, __LINE__);
+        return;
+    }
+
+    for(uint32_t i = 0; i < QUAD_INDEX_BUFFER_QUADS; i++){
+        uint32_t v = i * 4;
+
+        indices[i*6 + 0] = (rindex_t) (v + 0);
+        indices[i*6 + 1] = (rindex_t) (v + 1);
+        indices[i*6 + 2] = (rindex_t) (v + 2);
+        indices[i*6 + 3] = (rindex_t) (v + 2);
+        indices[i*6 + 4] = (rindex_t) (v + 3);
+        indices[i*6 + 5] = (rindex_t) (v + 0);
+    }
+
+    glGenBuffers(1, &this->quadIndexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->quadIndexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(rindex_t), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    rfree(indices);
+    Debug::info("[%s:%d]: Static quad index buffer created (%d quads)\n", __FILE__, __LINE__, (int) QUAD_INDEX_BUFFER_QUADS);
+}
+
+
+// Deferred commands
+static bool commandsOverlap(const float* a, const float* b){
+    return a[0] <= b[2] && b[0] <= a[2] && a[1] <= b[3] && b[1] <= a[3];
+}
+
+static int commandCompare(const void* a, const void* b){
+    const rcommand_t* ca = (const rcommand_t*) a;
+    const rcommand_t* cb = (const rcommand_t*) b;
+
+    // Batch first, painter's order inside the batch
+    if(ca->batch != cb->batch) return (ca->batch < cb->batch) ? -1 : 1;
+    if(ca->order != cb->order) return (ca->order < cb->order) ? -1 : 1;
+    return 0;
+}
+
+void* RGLES2::allocateCommand(size_t elements, size_t indices, int format){
+    size_t total_bytes = RBUFFER_TOTAL_SIZE(elements, indices);
+    // Keep command buffers aligned
+    size_t offset      = (this->commandArenaUsed + 15) & ~((size_t) 15);
+
+    if(offset + total_bytes > this->commandArenaSize){
+        size_t new_size = this->commandArenaSize * 2;
+        while(offset + total_bytes > new_size) new_size *= 2;
+
+        void* new_arena = rrealloc(this->commandArena, new_size);
+        if(new_arena == NULL){
+            Debug::error("[%s:%d]: Cannot grow the command arena to %d bytes!\n", __FILE__, __LINE__, (int) new_size);
+            return NULL;
+        }
 
-        // Allocate space for "elements" elements in the global draw buffer
-        intptr_t vtx_ptr_offset = (intptr_t) RBUFFERHEADER_SIZE + header->vtx_offset + (header->vtx_count * 3 * sizeof(float));
-        intptr_t clr_ptr_offset = (intptr_t) RBUFFERHEADER_SIZE + header->clr_offset + (header->clr_count * 4 * sizeof(float));
-        intptr_t txc_ptr_offset = (intptr_t) RBUFFERHEADER_SIZE + header->txc_offset + (header->txc_count * 2 * sizeof(float));
+        this->commandArena     = new_arena;
+        this->commandArenaSize = new_size;
+    }
 
-        // Set new element count
-        header->elements += elements;
+    void* buffer = (void*) ((intptr_t) this->commandArena + offset);
+    initBufferHeader(buffer, elements, indices, format, FLAG_COMMAND);
 
-        // TODO! Set bufferptr! (DONE)
-        rbufferptr->vtx_ptr = (void*) ((intptr_t) this->drawBuffer + vtx_ptr_offset);
-        rbufferptr->nrm_ptr = (void*) ((intptr_t) NULL);
-        rbufferptr->clr_ptr = (void*) ((intptr_t) this->drawBuffer + clr_ptr_offset);
-        rbufferptr->txc_ptr = (void*) ((intptr_t) this->drawBuffer + txc_ptr_offset);
+    this->commandArenaUsed = offset + total_bytes;
+    return buffer;
+}
 
-        return this->drawBuffer;
+void RGLES2::saveState(rstate_t* state){
+    // Vertices are already transformed on the CPU, the shader matrix is what matters
+    memcpy(state->matrix, this->shaderMatrix().e, sizeof(state->matrix));
+    memcpy(state->viewport, this->viewportRect, sizeof(state->viewport));
+    memcpy(state->scissor, this->scissorRect, sizeof(state->scissor));
+    state->scissor_enabled = this->scissorEnabled;
+    state->point_size      = this->particlePipeline->getPointSize();
+}
+
+uint32_t RGLES2::recordState(){
+    if(!this->stateDirty && this->stateCount) return this->stateCount - 1;
+
+    if(this->stateCount == this->stateCapacity){
+        rstate_t* new_states = (rstate_t*) rrealloc(this->states, this->stateCapacity * 2 * sizeof(rstate_t));
+        if(new_states == NULL){
+            // Overwrite the last state. Wrong, but better than crashing
+            Debug::error("[%s:%d]: Cannot grow the deferred state list!\n", __FILE__, __LINE__);
+            this->saveState(&this->states[this->stateCount - 1]);
+            return this->stateCount - 1;
+        }
+
+        this->states         = new_states;
+        this->stateCapacity *= 2;
     }
+
+    this->saveState(&this->states[this->stateCount]);
+    this->stateDirty = false;
+
+    return this->stateCount++;
 }
 
+void RGLES2::recordCommand(void* buffer){
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+
+    if(this->commandCount == this->commandCapacity){
+        rcommand_t* new_commands = (rcommand_t*) rrealloc(this->commands, this->commandCapacity * 2 * sizeof(rcommand_t));
+        if(new_commands == NULL){
+            Debug::error("[%s:%d]: Cannot grow the deferred command list! Command dropped\n", __FILE__, __LINE__);
+            return;
+        }
+
+        this->commands         = new_commands;
+        this->commandCapacity *= 2;
+    }
+
+    rcommand_t* command = &this->commands[this->commandCount];
+    command->pipeline   = this->recordPipeline;
+    command->texture    = (this->recordPipeline == this->texturePipeline) ? this->recordTexture : 0;
+    command->state      = this->recordState();
+    command->order      = this->commandCount;
+    command->batch      = 0;
+    command->offset     = (size_t) ((intptr_t) buffer - (intptr_t) this->commandArena);
+
+    // Window space bounding box, so commands with different transforms can be compared
+    const rstate_t* state = &this->states[command->state];
+    const float*    m     = state->matrix;
+    intptr_t buffer_base  = (intptr_t) buffer + RBUFFERHEADER_SIZE;
+
+    float x0 =  INFINITY, y0 =  INFINITY;
+    float x1 = -INFINITY, y1 = -INFINITY;
+    // Vertex z is zero, except for particles (Sprite size in pixels)
+    float zmax = 0.f;
+
+    for(uint32_t i = 0; i < header->elements; i++){
+        vertex3_t* vertex = (vertex3_t*) (buffer_base + header->vtx_offset + (i * header->vtx_stride));
+
+        float w  = m[3] * vertex->x + m[7] * vertex->y + m[15];
+        float nx = (m[0] * vertex->x + m[4] * vertex->y + m[12]) / w;
+        float ny = (m[1] * vertex->x + m[5] * vertex->y + m[13]) / w;
+
+        float wx = state->viewport[0] + (nx + 1.f) * 0.5f * state->viewport[2];
+        float wy = state->viewport[1] + (ny + 1.f) * 0.5f * state->viewport[3];
+
+        x0 = min(x0, wx);
+        y0 = min(y0, wy);
+        x1 = max(x1, wx);
+        y1 = max(y1, wy);
+        zmax = max(zmax, vertex->z);
+    }
+
+    // One pixel of margin: points and lines cover the pixels around their vertices
+    float margin = 1.f;
+    if(command->pipeline == this->particlePipeline) margin += zmax * 0.5f * state->point_size;
+
+    command->bbox[0] = x0 - margin;
+    command->bbox[1] = y0 - margin;
+    command->bbox[2] = x1 + margin;
+    command->bbox[3] = y1 + margin;
+
+    this->commandCount++;
+}
+
+void RGLES2::applyState(const rstate_t* state){
+    this->submit();
+
+    memcpy(this->shaderMatrix().e, state->matrix, sizeof(state->matrix));
+    memcpy(this->viewportRect, state->viewport, sizeof(state->viewport));
+    memcpy(this->scissorRect, state->scissor, sizeof(state->scissor));
+    this->scissorEnabled = state->scissor_enabled;
+    this->particlePipeline->setPointSize(state->point_size);
+
+    glViewport(state->viewport[0], state->viewport[1], state->viewport[2], state->viewport[3]);
+    if(state->scissor_enabled){
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(state->scissor[0], state->scissor[1], state->scissor[2], state->scissor[3]);
+    } else {
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    this->updateTransform();
+}
+
+void RGLES2::replayCommands(){
+    if(this->commandCount == 0){
+        this->discardCommands();
+        return;
+    }
+
+    // Merge. A command joins the earliest batch with the same key that no later batch overlaps
+    struct rbatch_t {
+        RPipeline* pipeline;
+        uint32_t   texture;
+        uint32_t   state;
+        float      bbox[4];
+    };
+
+    rbatch_t* batches    = (rbatch_t*) rmalloc(this->commandCount * sizeof(rbatch_t));
+    uint32_t batch_count = 0;
+
+    for(uint32_t i = 0; i < this->commandCount; i++){
+        rcommand_t* command = &this->commands[i];
+        int32_t     target  = -1;
+
+        if(batches){
+            int32_t last = (int32_t) batch_count - 1;
+            int32_t stop = max(0, (int32_t) batch_count - COMMAND_MERGE_LOOKBACK);
+
+            for(int32_t b = last; b >= stop; b--){
+                if(batches[b].pipeline == command->pipeline && batches[b].texture == command->texture && batches[b].state == command->state){
+                    target = b;
+                }
+                // Painter's order, cannot move before this batch
+                if(commandsOverlap(batches[b].bbox, command->bbox)) break;
+            }
+        } else {
+            // No memory for merging, every command is its own batch (Recorded order)
+            target = -1;
+        }
+
+        if(target < 0){
+            target = batch_count++;
+            if(batches){
+                batches[target].pipeline = command->pipeline;
+                batches[target].texture  = command->texture;
+                batches[target].state    = command->state;
+                memcpy(batches[target].bbox, command->bbox, sizeof(command->bbox));
+            }
+        } else {
+            batches[target].bbox[0] = min(batches[target].bbox[0], command->bbox[0]);
+            batches[target].bbox[1] = min(batches[target].bbox[1], command->bbox[1]);
+            batches[target].bbox[2] = max(batches[target].bbox[2], command->bbox[2]);
+            batches[target].bbox[3] = max(batches[target].bbox[3], command->bbox[3]);
+        }
+
+        command->batch = target;
+    }
+
+    if(batches) rfree(batches);
+
+    qsort(this->commands, this->commandCount, sizeof(rcommand_t), commandCompare);
+
+    perfstats.commands_recorded += this->commandCount;
+    perfstats.commands_batches  += batch_count;
+
+    // Replay, the normal draw path batches consecutive commands
+    rstate_t current_state;
+    this->saveState(&current_state);
+    this->recordingCommands = false;
+
+    uint32_t last_state = (uint32_t) -1;
+
+    for(uint32_t i = 0; i < this->commandCount; i++){
+        rcommand_t*      command = &this->commands[i];
+        rbufferheader_t* source  = (rbufferheader_t*) ((intptr_t) this->commandArena + command->offset);
+        intptr_t source_base     = (intptr_t) source + RBUFFERHEADER_SIZE;
+
+        if(command->state != last_state){
+            this->applyState(&this->states[command->state]);
+            last_state = command->state;
+        }
+
+        this->setPipeline(command->pipeline);
+        int unit = (command->pipeline == this->texturePipeline) ? this->setTexture(command->texture) : 0;
+
+        rbufferptr_t e_ptr;
+        void* buffer;
+
+        if(source->flags & FLAG_QUAD_INDICES){
+            buffer = this->allocateQuads(source->elements / 4, &e_ptr);
+        } else {
+            buffer = this->allocateElements(source->elements, source->idx_count, &e_ptr);
+        }
+        if(buffer == NULL) continue;
+
+        // Same vertex format on both sides
+        if(source->format == VERTEX_FORMAT_PLANAR){
+            memcpy(e_ptr.vtx_ptr, (void*) (source_base + source->vtx_offset), source->elements * source->vtx_stride);
+            memcpy(e_ptr.clr_ptr, (void*) (source_base + source->clr_offset), source->elements * source->clr_stride);
+            if(source->txc_count) memcpy(e_ptr.txc_ptr, (void*) (source_base + source->txc_offset), source->txc_count * source->txc_stride);
+        } else {
+            memcpy(e_ptr.vtx_ptr, (void*) (source_base + source->vtx_offset), source->elements * source->vtx_stride);
+        }
+
+        // Textured quads were recorded with unit 0 (Alpha plane flag kept)
+        if(unit){
+            for(uint32_t j = 0; j < source->elements; j++){
+                texcrd3_t* texcoord = (texcrd3_t*) ((intptr_t) e_ptr.txc_ptr + (j * e_ptr.txc_stride));
+                texcoord->u += (float) unit;
+            }
+        }
+
+        if(source->idx_count && !(source->flags & FLAG_QUAD_INDICES)){
+            rindex_t* source_indices = (rindex_t*) (source_base + source->idx_offset);
+            for(uint32_t j = 0; j < source->idx_count; j++){
+                e_ptr.idx_ptr[j] = (rindex_t) (source_indices[j] + e_ptr.idx_base);
+            }
+        }
+
+        this->updateBuffer(buffer, source->vtx_count, 0, source->clr_count, source->txc_count);
+    }
+
+    // Back to the state the user left
+    this->applyState(&current_state);
+    this->recordingCommands = true;
+
+    this->discardCommands();
+}
+
+void RGLES2::discardCommands(){
+    this->commandCount     = 0;
+    this->commandArenaUsed = 0;
+    this->stateCount       = 0;
+    this->stateDirty       = true;
+}
 
 void RGLES2::updateBuffer(void* buffer, size_t vtx, size_t nrm, size_t clr, size_t txc){
     rbufferheader_t* header = (rbufferheader_t*) buffer;
@@ -579,30 +1678,65 @@ void RGLES2::updateBuffer(void* buffer, size_t vtx, size_t nrm, size_t clr, size
     header->vtx_count += vtx;
     header->clr_count += clr;
     header->txc_count += txc;
+
+    if(header->flags & FLAG_COMMAND){
+        // Command written, record it
+        this->recordCommand(buffer);
+    }
 }
 
 void RGLES2::updateTransform(){
+    if(this->recordingCommands){
+        // New state for the next commands
+        this->stateDirty = true;
+        return;
+    }
+
     if(this->currentRPipeline){
-        this->currentRPipeline->setTransform(this->tMatrix);
+        this->currentRPipeline->setTransform(this->shaderMatrix());
     }
 }
 
+RMatrix4& RGLES2::shaderMatrix(){
+    if(this->initFlags & INIT_FLAG_CPU_TRANSFORM) return this->projMatrix;
+    return this->tMatrix;
+}
+
 // Viewport settings
 void RGLES2::viewport(int x, int y, int w, int h){
     this->submit();
 
+    this->viewportRect[0] = x;
+    this->viewportRect[1] = y;
+    this->viewportRect[2] = w;
+    this->viewportRect[3] = h;
+
+    if(this->recordingCommands){
+        this->stateDirty = true;
+        return;
+    }
+
     glViewport(x, y, w, h);
 }
 
 void RGLES2::viewport(){
-    this->submit();
-
-    glViewport(0, 0, this->baseWindow->getWidth(), this->baseWindow->getHeight());
+    this->viewport(0, 0, this->baseWindow->getWidth(), this->baseWindow->getHeight());
 }
 
 void RGLES2::scissor(int x, int y, int w, int h){
     this->submit();
 
+    this->scissorEnabled = 1;
+    this->scissorRect[0] = x;
+    this->scissorRect[1] = y;
+    this->scissorRect[2] = w;
+    this->scissorRect[3] = h;
+
+    if(this->recordingCommands){
+        this->stateDirty = true;
+        return;
+    }
+
     glEnable(GL_SCISSOR_TEST);
     glScissor(x, y, w, h);
 }
@@ -610,17 +1744,47 @@ void RGLES2::scissor(int x, int y, int w, int h){
 void RGLES2::scissor(){
     this->submit();
 
+    this->scissorEnabled = 0;
+
+    if(this->recordingCommands){
+        this->stateDirty = true;
+        return;
+    }
+
     glDisable(GL_SCISSOR_TEST);
 }
 
 void RGLES2::origin(){
-    this->submit();
     // PLEASE Brais of the future, put this in a method!
-    this->tMatrix = RMatrix4::ortho(0, this->baseWindow->getWidth(), this->baseWindow->getHeight(), 0, -1, 1);
+    RMatrix4 projection = RMatrix4::ortho(0, this->baseWindow->getWidth(), this->baseWindow->getHeight(), 0, -1, 1);
+
+    if(this->initFlags & INIT_FLAG_CPU_TRANSFORM){
+        this->tMatrix = projection;
+        this->modelMatrix.loadIdentity();
+        this->modelIdentity = true;
+
+        // Only a new projection (Window resized) touches the uniform
+        if(memcmp(this->projMatrix.e, projection.e, sizeof(projection.e)) != 0){
+            this->submit();
+            this->projMatrix = projection;
+            this->updateTransform();
+        }
+        return;
+    }
+
+    this->submit();
+    this->tMatrix = projection;
     this->updateTransform();
 }
 
 void RGLES2::translate(float tx, float ty){
+    if(this->initFlags & INIT_FLAG_CPU_TRANSFORM){
+        this->tMatrix       *= RMatrix4::translation(tx, ty);
+        this->modelMatrix   *= RMatrix3::translation(tx, ty);
+        this->modelIdentity  = false;
+        return;
+    }
+
     this->submit();
     this->tMatrix *= RMatrix4::translation(tx, ty);
     this->updateTransform();
@@ -631,12 +1795,26 @@ void RGLES2::translate(int tx, int ty){
 }
 
 void RGLES2::rotate(float angle){
+    if(this->initFlags & INIT_FLAG_CPU_TRANSFORM){
+        this->tMatrix       *= RMatrix4::rotation(angle);
+        this->modelMatrix   *= RMatrix3::rotation(angle);
+        this->modelIdentity  = false;
+        return;
+    }
+
     this->submit();
     this->tMatrix *= RMatrix4::rotation(angle);
     this->updateTransform();
 }
 
 void RGLES2::scale(float x, float y){
+    if(this->initFlags & INIT_FLAG_CPU_TRANSFORM){
+        this->tMatrix       *= RMatrix4::scaling(x, y);
+        this->modelMatrix   *= RMatrix3::scaling(x, y);
+        this->modelIdentity  = false;
+        return;
+    }
+
     this->submit();
     this->tMatrix *= RMatrix4::scaling(x, y);
     this->updateTransform();
@@ -651,7 +1829,77 @@ RMatrix4 RGLES2::getTransformationMatrix() const {
 }
 
 void RGLES2::setTransfomationMatrix(const RMatrix4& tmatrix){
-    this->tMatrix = tmatrix;
+    if(this->initFlags & INIT_FLAG_CPU_TRANSFORM){
+        // Any 4x4 matrix, can't be split. Becomes the projection
+        this->submit();
+        this->tMatrix    = tmatrix;
+        this->projMatrix = tmatrix;
+        this->modelMatrix.loadIdentity();
+        this->modelIdentity = true;
+        this->updateTransform();
+        return;
+    }
+
+    this->tMatrix    = tmatrix;
+    this->stateDirty = true;
+}
+
+void RGLES2::setCircleSteps(int steps){
+    if(steps < 3)                steps = 3;
+    if(steps > CIRCLE_MAX_STEPS) steps = CIRCLE_MAX_STEPS;
+
+    this->circle_steps = steps;
+}
+
+void RGLES2::setCircleTolerance(float tolerance){
+    this->circleTolerance = tolerance;
+}
+
+float RGLES2::transformScale() const {
+    // NDC to pixels, then the length of the transformed unit axes
+    float half_w = this->viewportRect[2] * 0.5f;
+    float half_h = this->viewportRect[3] * 0.5f;
+
+    float sx = hypotf(this->tMatrix.e[0] * half_w, this->tMatrix.e[1] * half_h);
+    float sy = hypotf(this->tMatrix.e[4] * half_w, this->tMatrix.e[5] * half_h);
+
+    return max(sx, sy);
+}
+
+int RGLES2::circleSteps(int r) const {
+    if(this->circleTolerance <= 0.f) return this->circle_steps;
+
+    float radius = fabsf((float) r) * this->transformScale();
+    if(radius <= this->circleTolerance) return CIRCLE_MIN_STEPS;
+
+    // Rim to segment distance (sagitta) is r * (1 - cos(pi / steps))
+    int steps = (int) ceilf(M_PI / acosf(1.f - (this->circleTolerance / radius)));
+    // Multiples of 4, fewer tables
+    steps = (steps + 3) & ~3;
+
+    if(steps < CIRCLE_MIN_STEPS) steps = CIRCLE_MIN_STEPS;
+    if(steps > CIRCLE_MAX_STEPS) steps = CIRCLE_MAX_STEPS;
+    return steps;
+}
+
+const float* RGLES2::circleTable(int steps){
+    if(this->circleTables[steps]) return this->circleTables[steps];
+
+    float* table = (float*) rmalloc(steps * 2 * sizeof(float));
+    if(table == NULL){
+        Debug::error("[%s:%d]: Cannot allocate circle table for %d steps!\n", __FILE__, __LINE__, steps);
+        return NULL;
+    }
+
+    for(int i = 0; i < steps; i++){
+        double angle = (2.0 * M_PI * i) / (double) steps;
+
+        table[i*2 + 0] = (float) cos(angle);
+        table[i*2 + 1] = (float) sin(angle);
+    }
+
+    this->circleTables[steps] = table;
+    return table;
 }
 
 // RENDERING METHODS!
@@ -668,24 +1916,71 @@ void RGLES2::clearColor(color_t color){
 void RGLES2::clear(){
     glClear(GL_COLOR_BUFFER_BIT);
     this->clearBuffers();
+
+    // Commands recorded before a clear would be cleared anyway
+    if(this->recordingCommands) this->discardCommands();
 }
 
 inline void color2rcolor(color4_t* rcolor, color_t color){
-    rcolor->r = R(color) / 255.f;
-    rcolor->g = G(color) / 255.f;
-    rcolor->b = B(color) / 255.f;
-    rcolor->a = A(color) / 255.f;
+    rcolor->r = R(color);
+    rcolor->g = G(color);
+    rcolor->b = B(color);
+    rcolor->a = A(color);
+}
+
+// Buffer writers. Elements can be planar or interleaved, always go through the strides!
+inline void putvertex(rbufferptr_t* e_ptr, size_t i, float x, float y){
+    vertex3_t* vertex = (vertex3_t*) ((intptr_t) e_ptr->vtx_ptr + (i * e_ptr->vtx_stride));
+
+    if(e_ptr->transform){
+        // CPU transform, 2D affine (RMatrix3, column major)
+        const float* m = e_ptr->transform;
+
+        vertex->x = m[0] * x + m[3] * y + m[6];
+        vertex->y = m[1] * x + m[4] * y + m[7];
+    } else {
+        vertex->x = x;
+        vertex->y = y;
+    }
+    vertex->z = 0.f;
+}
+
+inline void putcolor(rbufferptr_t* e_ptr, size_t i, const color4_t* rcolor){
+    color4_t* dest = (color4_t*) ((intptr_t) e_ptr->clr_ptr + (i * e_ptr->clr_stride));
+    *dest = *rcolor;
+}
+
+inline void putcolor(rbufferptr_t* e_ptr, size_t i, color_t color){
+    color4_t rcolor;
+    color2rcolor(&rcolor, color);
+    putcolor(e_ptr, i, &rcolor);
+}
+
+// Shape pipeline: local position (Pixels from the shape center) and shape parameters
+inline void putshape(rbufferptr_t* e_ptr, size_t i, float lx, float ly, const shape4_t* params){
+    texcrd2_t* local = (texcrd2_t*) ((intptr_t) e_ptr->txc_ptr + (i * e_ptr->txc_stride));
+    shape4_t*  dest  = (shape4_t*)  ((intptr_t) e_ptr->prm_ptr + (i * e_ptr->prm_stride));
+
+    local->s = lx;
+    local->t = ly;
+    *dest    = *params;
 }
 
-inline void copycolor(color4_t* dest, color_t src, size_t count){
+// Texture pipeline: texture coordinates and texture unit
+inline void puttexcrd(rbufferptr_t* e_ptr, size_t i, float s, float t, int unit){
+    texcrd3_t* dest = (texcrd3_t*) ((intptr_t) e_ptr->txc_ptr + (i * e_ptr->txc_stride));
+
+    dest->s = s;
+    dest->t = t;
+    dest->u = (float) unit;
+}
+
+inline void copycolor(rbufferptr_t* e_ptr, size_t first, color_t src, size_t count){
     color4_t src_color;
     color2rcolor(&src_color, src);
 
-    for(size_t i = 0; i < count; i++){
-        dest[i].r = src_color.r;
-        dest[i].g = src_color.g;
-        dest[i].b = src_color.b;
-        dest[i].a = src_color.a;
+    for(size_t i = first; i < (first + count); i++){
+        putcolor(e_ptr, i, &src_color);
     }
 }
 
@@ -695,15 +1990,10 @@ void RGLES2::drawPixel(int x, int y, color_t color){
 
     this->setPipeline(this->dotPipeline);
     buffer = this->allocateElements(1, &e_ptr);
-    
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*)  e_ptr.clr_ptr;
-
-    vertices[0].x = (float) x;
-    vertices[0].y = (float) y;
-    vertices[0].z = (float) 0.f;
+    if(buffer == NULL) return;
 
-    color2rcolor(&colors[0], color);
+    putvertex(&e_ptr, 0, (float) x, (float) y);
+    putcolor(&e_ptr, 0, color);
 
     this->updateBuffer(buffer, 1, 0, 1, 0);
 }
@@ -714,18 +2004,12 @@ void RGLES2::drawLine(int x0, int y0, int x1, int y1, color_t color){
 
     this->setPipeline(linePipeline);
     buffer = this->allocateElements(2, &e_ptr);
+    if(buffer == NULL) return;
 
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
+    putvertex(&e_ptr, 0, (float) x0, (float) y0);
+    putvertex(&e_ptr, 1, (float) x1, (float) y1);
 
-    vertices[0].x = (float) x0;
-    vertices[0].y = (float) y0;
-    vertices[0].z = (float) 0.f;
-    vertices[1].x = (float) x1;
-    vertices[1].y = (float) y1;
-    vertices[1].z = (float) 0.f;
-
-    copycolor(&colors[0], color, 2);
+    copycolor(&e_ptr, 0, color, 2);
 
     this->updateBuffer(buffer, 2, 0, 2, 0);
 }
@@ -736,19 +2020,13 @@ void RGLES2::drawLine(int x0, int y0, int x1, int y1, color_t color1, color_t co
 
     this->setPipeline(linePipeline);
     buffer = this->allocateElements(2, &e_ptr);
+    if(buffer == NULL) return;
 
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
-
-    vertices[0].x = (float) x0;
-    vertices[0].y = (float) y0;
-    vertices[0].z = (float) 0.f;
-    vertices[1].x = (float) x1;
-    vertices[1].y = (float) y1;
-    vertices[1].z = (float) 0.f;
+    putvertex(&e_ptr, 0, (float) x0, (float) y0);
+    putvertex(&e_ptr, 1, (float) x1, (float) y1);
 
-    color2rcolor(&colors[0], color1);
-    color2rcolor(&colors[1], color2);
+    putcolor(&e_ptr, 0, color1);
+    putcolor(&e_ptr, 1, color2);
 
     this->updateBuffer(buffer, 2, 0, 2, 0);
 }
@@ -766,46 +2044,22 @@ void RGLES2::drawRect(int x, int y, int w, int h, color_t color){
     void* buffer;
 
     this->setPipeline(linePipeline);
-    buffer = this->allocateElements(8, &e_ptr);
-
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
+    buffer = this->allocateElements(4, 8, &e_ptr);
+    if(buffer == NULL) return;
 
-    vertices[0].x = (float) x;
-    vertices[0].y = (float) y;
-    vertices[0].z = 0.f;
-
-    vertices[1].x = (float) x;
-    vertices[1].y = (float) y + h;
-    vertices[1].z = 0.f;
-    
-    vertices[2].x = (float) x;
-    vertices[2].y = (float) y + h;
-    vertices[2].z = 0.f;
-    
-    vertices[3].x = (float) x + w;
-    vertices[3].y = (float) y + h;
-    vertices[3].z = 0.f;
+    putvertex(&e_ptr, 0, (float) x,     (float) y);
+    putvertex(&e_ptr, 1, (float) x,     (float) y + h);
+    putvertex(&e_ptr, 2, (float) x + w, (float) y + h);
+    putvertex(&e_ptr, 3, (float) x + w, (float) y);
 
-    vertices[4].x = (float) x + w;
-    vertices[4].y = (float) y + h;
-    vertices[4].z = 0.f;
-    
-    vertices[5].x = (float) x + w;
-    vertices[5].y = (float) y;
-    vertices[5].z = 0.f;
-    
-    vertices[6].x = (float) x + w;
-    vertices[6].y = (float) y;
-    vertices[6].z = 0.f;
-
-    vertices[7].x = (float) x;
-    vertices[7].y = (float) y;
-    vertices[7].z = 0.f;
+    for(int i = 0; i < 4; i++){
+        e_ptr.idx_ptr[i*2 + 0] = e_ptr.idx_base + i;
+        e_ptr.idx_ptr[i*2 + 1] = e_ptr.idx_base + ((i + 1) % 4);
+    }
 
-    copycolor(&colors[0], color, 8);
+    copycolor(&e_ptr, 0, color, 4);
 
-    this->updateBuffer(buffer, 8, 0, 8, 0);
+    this->updateBuffer(buffer, 4, 0, 4, 0);
 }
 
 void RGLES2::drawFillRect(int x, int y, int w, int h, color_t color){
@@ -813,38 +2067,17 @@ void RGLES2::drawFillRect(int x, int y, int w, int h, color_t color){
     void* buffer;
 
     this->setPipeline(trianglePipeline);
-    buffer = this->allocateElements(6, &e_ptr);
-
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
+    buffer = this->allocateQuads(1, &e_ptr);
+    if(buffer == NULL) return;
 
-    vertices[0].x = (float) x;
-    vertices[0].y = (float) y;
-    vertices[0].z = 0.f;
+    putvertex(&e_ptr, 0, (float) x,     (float) y);
+    putvertex(&e_ptr, 1, (float) x,     (float) y + h);
+    putvertex(&e_ptr, 2, (float) x + w, (float) y + h);
+    putvertex(&e_ptr, 3, (float) x + w, (float) y);
 
-    vertices[1].x = (float) x;
-    vertices[1].y = (float) y + h;
-    vertices[1].z = 0.f;
-    
-    vertices[2].x = (float) x + w;
-    vertices[2].y = (float) y + h;
-    vertices[2].z = 0.f;
-    
-    vertices[3].x = (float) x + w;
-    vertices[3].y = (float) y + h;
-    vertices[3].z = 0.f;
-
-    vertices[4].x = (float) x + w;
-    vertices[4].y = (float) y;
-    vertices[4].z = 0.f;
-    
-    vertices[5].x = (float) x;
-    vertices[5].y = (float) y;
-    vertices[5].z = 0.f;
-
-    copycolor(&colors[0], color, 6);
+    copycolor(&e_ptr, 0, color, 4);
 
-    this->updateBuffer(buffer, 6, 0, 6, 0);
+    this->updateBuffer(buffer, 4, 0, 4, 0);
 }
 
 
@@ -852,37 +2085,36 @@ void RGLES2::drawCircle(int x, int y, int r, color_t color){
     rbufferptr_t e_ptr;
     void* buffer;
 
-    size_t need_elements = this->circle_steps * 2;
-
-    this->setPipeline(linePipeline);
-    buffer = this->allocateElements(need_elements, &e_ptr);
-
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
+    if(this->initFlags & INIT_FLAG_SHAPE_CIRCLES){
+        // One pixel stroke centered on the radius, like the line pipeline
+        float half_pixel = 0.5f / this->transformScale();
+        this->drawShape((float) x, (float) y, r + half_pixel, r + half_pixel, r + half_pixel, 1.f, color);
+        return;
+    }
 
-    float angle_step = (2.f * M_PI) / (float) this->circle_steps;
-    float angle_now  = 0.f;
+    int          steps = this->circleSteps(r);
+    const float* table = this->circleTable(steps);
+    if(table == NULL) return;
 
-    for(int i = 0; i < this->circle_steps; i++){
-        float px1 = (float) x + (float) r * cos(angle_now);
-        float py1 = (float) y + (float) r * sin(angle_now);
+    size_t need_elements = steps;
 
-        float px2 = (float) x + (float) r * cos(angle_now + angle_step);
-        float py2 = (float) y + (float) r * sin(angle_now + angle_step);
+    this->setPipeline(linePipeline);
+    buffer = this->allocateElements(need_elements, steps * 2, &e_ptr);
+    if(buffer == NULL) return;
 
-        vertices[i*2 + 0].x = px1;
-        vertices[i*2 + 0].y = py1;
-        vertices[i*2 + 0].z = 0.f;
+    // Rim vertices are shared by two segments
+    for(int i = 0; i < steps; i++){
+        float px = (float) x + (float) r * table[i*2 + 0];
+        float py = (float) y + (float) r * table[i*2 + 1];
 
-        vertices[i*2 + 1].x = px2;
-        vertices[i*2 + 1].y = py2;
-        vertices[i*2 + 1].z = 0.f;
+        putvertex(&e_ptr, i, px, py);
 
-        angle_now += angle_step;
+        e_ptr.idx_ptr[i*2 + 0] = e_ptr.idx_base + i;
+        e_ptr.idx_ptr[i*2 + 1] = e_ptr.idx_base + ((i + 1) % steps);
     }
 
 
-    copycolor(&colors[0], color, need_elements);
+    copycolor(&e_ptr, 0, color, need_elements);
     this->updateBuffer(buffer, need_elements, 0, need_elements, 0);
 }
 
@@ -890,198 +2122,357 @@ void RGLES2::drawFillCircle(int x, int y, int r, color_t color){
     rbufferptr_t e_ptr;
     void* buffer;
 
-    size_t need_elements = this->circle_steps * 3;
+    if(this->initFlags & INIT_FLAG_SHAPE_CIRCLES){
+        this->drawShape((float) x, (float) y, (float) r, (float) r, (float) r, 0.f, color);
+        return;
+    }
+
+    int          steps = this->circleSteps(r);
+    const float* table = this->circleTable(steps);
+    if(table == NULL) return;
+
+    // Rim + center
+    size_t need_elements = steps + 1;
 
     this->setPipeline(trianglePipeline);
-    buffer = this->allocateElements(need_elements, &e_ptr);
+    buffer = this->allocateElements(need_elements, steps * 3, &e_ptr);
+    if(buffer == NULL) return;
 
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
+    // Center is the last element, triangle fan as indexed triangles
+    putvertex(&e_ptr, steps, (float) x, (float) y);
 
-    float angle_step = (2.f * M_PI) / (float) this->circle_steps;
-    float angle_now  = 0.f;
+    for(int i = 0; i < steps; i++){
+        float px = (float) x + (float) r * table[i*2 + 0];
+        float py = (float) y + (float) r * table[i*2 + 1];
 
-    for(int i = 0; i < this->circle_steps; i++){
-        float px1 = (float) x + (float) r * cos(angle_now);
-        float py1 = (float) y + (float) r * sin(angle_now);
+        putvertex(&e_ptr, i, px, py);
+
+        e_ptr.idx_ptr[i*3 + 0] = e_ptr.idx_base + i;
+        e_ptr.idx_ptr[i*3 + 1] = e_ptr.idx_base + ((i + 1) % steps);
+        e_ptr.idx_ptr[i*3 + 2] = e_ptr.idx_base + steps;
+    }
 
-        float px2 = (float) x + (float) r * cos(angle_now + angle_step);
-        float py2 = (float) y + (float) r * sin(angle_now + angle_step);
 
-        vertices[i*3 + 0].x = px1;
-        vertices[i*3 + 0].y = py1;
-        vertices[i*3 + 0].z = 0.f;
+    copycolor(&e_ptr, 0, color, need_elements);
+    this->updateBuffer(buffer, need_elements, 0, need_elements, 0);
+}
+
+void RGLES2::drawFillCircle(int x, int y, int r, color_t color1, color_t color2){
+    rbufferptr_t e_ptr;
+    void* buffer;
 
-        vertices[i*3 + 1].x = px2;
-        vertices[i*3 + 1].y = py2;
-        vertices[i*3 + 1].z = 0.f;
+    int          steps = this->circleSteps(r);
+    const float* table = this->circleTable(steps);
+    if(table == NULL) return;
 
-        vertices[i*3 + 2].x = (float) x;
-        vertices[i*3 + 2].y = (float) y;
-        vertices[i*3 + 2].z = 0.f;
+    // Rim + center
+    size_t need_elements = steps + 1;
 
-        angle_now += angle_step;
+    this->setPipeline(trianglePipeline);
+    buffer = this->allocateElements(need_elements, steps * 3, &e_ptr);
+    if(buffer == NULL) return;
+
+    // Center is the last element, triangle fan as indexed triangles
+    putvertex(&e_ptr, steps, (float) x, (float) y);
+    putcolor (&e_ptr, steps, color2);
+
+    for(int i = 0; i < steps; i++){
+        float px = (float) x + (float) r * table[i*2 + 0];
+        float py = (float) y + (float) r * table[i*2 + 1];
+
+        putvertex(&e_ptr, i, px, py);
+
+        e_ptr.idx_ptr[i*3 + 0] = e_ptr.idx_base + i;
+        e_ptr.idx_ptr[i*3 + 1] = e_ptr.idx_base + ((i + 1) % steps);
+        e_ptr.idx_ptr[i*3 + 2] = e_ptr.idx_base + steps;
     }
 
 
-    copycolor(&colors[0], color, need_elements);
+    copycolor(&e_ptr, 0, color1, steps);
     this->updateBuffer(buffer, need_elements, 0, need_elements, 0);
 }
 
-void RGLES2::drawFillCircle(int x, int y, int r, color_t color1, color_t color2){
+void RGLES2::drawShape(float cx, float cy, float hw, float hh, float radius, float stroke, color_t color){
     rbufferptr_t e_ptr;
     void* buffer;
 
-    size_t need_elements = this->circle_steps * 3;
+    // Quad corners, same winding as drawFillRect
+    static const float corners[8] = {
+        -1.f, -1.f,
+        -1.f,  1.f,
+         1.f,  1.f,
+         1.f, -1.f
+    };
+
+    // The fragment shader works in pixels
+    float scale = this->transformScale();
+    if(scale <= 0.f) return;
+
+    hw = fabsf(hw);
+    hh = fabsf(hh);
+
+    shape4_t params;
+    params.hw     = hw * scale;
+    params.hh     = hh * scale;
+    params.radius = (radius < 0.f) ? -1.f : min(radius, min(hw, hh)) * scale;
+    params.stroke = stroke;
+
+    // One more pixel around the shape for the antialiasing ramp
+    float qw = hw + (1.f / scale);
+    float qh = hh + (1.f / scale);
+
+    this->setPipeline(this->shapePipeline);
+    buffer = this->allocateQuads(1, &e_ptr);
+    if(buffer == NULL) return;
+
+    for(int i = 0; i < 4; i++){
+        float dx = corners[i*2 + 0];
+        float dy = corners[i*2 + 1];
+
+        putvertex(&e_ptr, i, cx + dx * qw, cy + dy * qh);
+        putshape (&e_ptr, i, dx * qw * scale, dy * qh * scale, &params);
+    }
 
-    this->setPipeline(trianglePipeline);
-    buffer = this->allocateElements(need_elements, &e_ptr);
+    copycolor(&e_ptr, 0, color, 4);
+    this->updateBuffer(buffer, 4, 0, 4, 4);
+}
+
+void RGLES2::drawRing(int x, int y, int r, int thickness, color_t color){
+    float stroke = thickness * this->transformScale();
+    this->drawShape((float) x, (float) y, (float) r, (float) r, (float) r, max(stroke, 1.f), color);
+}
 
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
+void RGLES2::drawEllipse(int x, int y, int rx, int ry, color_t color){
+    // One pixel stroke centered on the border
+    float half_pixel = 0.5f / this->transformScale();
+    this->drawShape((float) x, (float) y, rx + half_pixel, ry + half_pixel, -1.f, 1.f, color);
+}
 
-    color4_t rcolor1;
-    color4_t rcolor2;
+void RGLES2::drawFillEllipse(int x, int y, int rx, int ry, color_t color){
+    this->drawShape((float) x, (float) y, (float) rx, (float) ry, -1.f, 0.f, color);
+}
 
-    color2rcolor(&rcolor1, color1);
-    color2rcolor(&rcolor2, color2);
+void RGLES2::drawRoundRect(int x, int y, int w, int h, int r, color_t color){
+    // Same outline as drawRect, one pixel stroke centered on the border
+    float half_pixel = 0.5f / this->transformScale();
+    float hw = (w * 0.5f) + half_pixel;
+    float hh = (h * 0.5f) + half_pixel;
 
-    float angle_step = (2.f * M_PI) / (float) this->circle_steps;
-    float angle_now  = 0.f;
+    this->drawShape(x + (w * 0.5f), y + (h * 0.5f), hw, hh, r + half_pixel, 1.f, color);
+}
 
-    for(int i = 0; i < this->circle_steps; i++){
-        float px1 = (float) x + (float) r * cos(angle_now);
-        float py1 = (float) y + (float) r * sin(angle_now);
+void RGLES2::drawFillRoundRect(int x, int y, int w, int h, int r, color_t color){
+    this->drawShape(x + (w * 0.5f), y + (h * 0.5f), w * 0.5f, h * 0.5f, (float) r, 0.f, color);
+}
 
-        float px2 = (float) x + (float) r * cos(angle_now + angle_step);
-        float py2 = (float) y + (float) r * sin(angle_now + angle_step);
+void RGLES2::drawParticle(float x, float y, float size, color_t color){
+    this->drawParticles(&x, &y, &size, &color, 1);
+}
 
-        vertices[i*3 + 0].x = px1;
-        vertices[i*3 + 0].y = py1;
-        vertices[i*3 + 0].z = 0.f;
+void RGLES2::drawParticles(const float* x, const float* y, const float* size, const color_t* colors, size_t count){
+    rbufferptr_t e_ptr;
+    void* buffer;
+
+    // Sizes go to the shader in pixels
+    float scale = this->transformScale();
+
+    this->setPipeline(this->particlePipeline);
 
-        vertices[i*3 + 1].x = px2;
-        vertices[i*3 + 1].y = py2;
-        vertices[i*3 + 1].z = 0.f;
+    // Chunks of at most one draw buffer, no huge temporal buffers
+    size_t first = 0;
+    while(first < count){
+        size_t chunk = min(count - first, (size_t) this->drawBufferSizeElements);
 
-        vertices[i*3 + 2].x = (float) x;
-        vertices[i*3 + 2].y = (float) y;
-        vertices[i*3 + 2].z = 0.f;
+        buffer = this->allocateElements(chunk, &e_ptr);
+        if(buffer == NULL) return;
 
-        // This can be a source of cache misses! Tune for performance
-        // with for example, another for loop with colors
-        colors[i*3 + 0].r = rcolor1.r;
-        colors[i*3 + 0].g = rcolor1.g;
-        colors[i*3 + 0].b = rcolor1.b;
-        colors[i*3 + 0].a = rcolor1.a;
+        intptr_t     vtx_ptr = (intptr_t) e_ptr.vtx_ptr;
+        intptr_t     clr_ptr = (intptr_t) e_ptr.clr_ptr;
+        const float* m       = e_ptr.transform;
 
-        colors[i*3 + 1].r = rcolor1.r;
-        colors[i*3 + 1].g = rcolor1.g;
-        colors[i*3 + 1].b = rcolor1.b;
-        colors[i*3 + 1].a = rcolor1.a;
+        for(size_t i = first; i < (first + chunk); i++){
+            vertex3_t* vertex = (vertex3_t*) vtx_ptr;
+            color4_t*  rcolor = (color4_t*)  clr_ptr;
+            color_t    color  = colors[i];
+
+            if(m){
+                vertex->x = m[0] * x[i] + m[3] * y[i] + m[6];
+                vertex->y = m[1] * x[i] + m[4] * y[i] + m[7];
+            } else {
+                vertex->x = x[i];
+                vertex->y = y[i];
+            }
+            vertex->z = (size ? size[i] : 1.f) * scale;
 
-        colors[i*3 + 2].r = rcolor2.r;
-        colors[i*3 + 2].g = rcolor2.g;
-        colors[i*3 + 2].b = rcolor2.b;
-        colors[i*3 + 2].a = rcolor2.a;
+            rcolor->r = R(color);
+            rcolor->g = G(color);
+            rcolor->b = B(color);
+            rcolor->a = A(color);
 
-        angle_now += angle_step;
+            vtx_ptr += e_ptr.vtx_stride;
+            clr_ptr += e_ptr.clr_stride;
+        }
+
+        this->updateBuffer(buffer, chunk, 0, chunk, 0);
+        first += chunk;
     }
+}
 
+void RGLES2::setPointSize(float size){
+    // Particles already in the draw buffer keep their size
+    if(this->currentRPipeline == this->particlePipeline) this->submit();
 
-    this->updateBuffer(buffer, need_elements, 0, need_elements, 0);
+    this->particlePipeline->setPointSize(size);
+
+    if(this->recordingCommands){
+        // Replayed with the size of its state
+        this->stateDirty = true;
+    }
 }
 
-void RGLES2::drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, color_t color){
+void RGLES2::drawTextureQuad(const RTexture& texture, int sx, int sy, int sw, int sh, float x, float y, float w, float h, color_t color){
     rbufferptr_t e_ptr;
     void* buffer;
 
-    this->setPipeline(linePipeline);
-    buffer = this->allocateElements(6, &e_ptr);
+    if(texture.getTextureId() == 0 || texture.getWidth() <= 0 || texture.getHeight() <= 0){
+        Debug::warning("[%s:%d]: Drawing a texture not initialized!\n", __FILE__, __LINE__);
+        return;
+    }
+
+    // Texel rectangle to texture space. Row 0 is the first row uploaded
+    float s0 = (float) sx / texture.getWidth();
+    float s1 = (float) (sx + sw) / texture.getWidth();
+    float t0 = (float) sy / texture.getHeight();
+    float t1 = (float) (sy + sh) / texture.getHeight();
 
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
+    // Render targets are upside down
+    if(texture.isFlipped()){
+        t0 = 1.f - t0;
+        t1 = 1.f - t1;
+    }
 
-    vertices[0].x = (float) x0;
-    vertices[0].y = (float) y0;
-    vertices[0].z = 0.f;
+    // The image is the top of an alpha plane texture
+    if(texture.hasAlphaPlane()){
+        t0 *= texture.getTBorder();
+        t1 *= texture.getTBorder();
+    }
 
-    vertices[1].x = (float) x1;
-    vertices[1].y = (float) y1;
-    vertices[1].z = 0.f;
+    this->setPipeline(this->texturePipeline);
+    int unit = this->setTexture(texture.getTextureId());
+    // Units from TEXTURE_MAX_UNITS up also sample the alpha plane
+    if(texture.hasAlphaPlane()) unit += TEXTURE_MAX_UNITS;
+    buffer   = this->allocateQuads(1, &e_ptr);
+    if(buffer == NULL) return;
+
+    // Same winding as drawFillRect
+    putvertex(&e_ptr, 0, x,     y);
+    putvertex(&e_ptr, 1, x,     y + h);
+    putvertex(&e_ptr, 2, x + w, y + h);
+    putvertex(&e_ptr, 3, x + w, y);
+
+    puttexcrd(&e_ptr, 0, s0, t0, unit);
+    puttexcrd(&e_ptr, 1, s0, t1, unit);
+    puttexcrd(&e_ptr, 2, s1, t1, unit);
+    puttexcrd(&e_ptr, 3, s1, t0, unit);
+
+    copycolor(&e_ptr, 0, color, 4);
+    this->updateBuffer(buffer, 4, 0, 4, 4);
+}
 
-    vertices[2].x = (float) x1;
-    vertices[2].y = (float) y1;
-    vertices[2].z = 0.f;
+void RGLES2::drawTexture(const RTexture& texture, int x, int y){
+    this->drawTextureQuad(texture, 0, 0, texture.getWidth(), texture.getHeight(), x, y, texture.getWidth(), texture.getHeight(), WHITE);
+}
 
-    vertices[3].x = (float) x2;
-    vertices[3].y = (float) y2;
-    vertices[3].z = 0.f;
+void RGLES2::drawTexture(const RTexture& texture, int x, int y, int w, int h){
+    this->drawTextureQuad(texture, 0, 0, texture.getWidth(), texture.getHeight(), x, y, w, h, WHITE);
+}
 
-    vertices[4].x = (float) x2;
-    vertices[4].y = (float) y2;
-    vertices[4].z = 0.f;
+void RGLES2::drawTexture(const RTexture& texture, int x, int y, int w, int h, color_t color){
+    this->drawTextureQuad(texture, 0, 0, texture.getWidth(), texture.getHeight(), x, y, w, h, color);
+}
 
-    vertices[5].x = (float) x0;
-    vertices[5].y = (float) y0;
-    vertices[5].z = 0.f;
+void RGLES2::drawTexture(const char* name, int x, int y){
+    RTexture* texture = this->textureCache ? this->textureCache->get(name) : NULL;
+    if(texture == NULL) return;
 
-    copycolor(&colors[0], color, 6);
+    this->drawTextureQuad(*texture, 0, 0, texture->getWidth(), texture->getHeight(), x, y, texture->getWidth(), texture->getHeight(), WHITE);
+}
 
-    this->updateBuffer(buffer, 6, 0, 6, 0);
+void RGLES2::drawSubTexture(const RTexture& texture, int sx, int sy, int sw, int sh, int x, int y, int w, int h){
+    this->drawTextureQuad(texture, sx, sy, sw, sh, x, y, w, h, WHITE);
 }
 
-void RGLES2::drawFillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, color_t color){
+void RGLES2::drawSubTexture(const RTexture& texture, int sx, int sy, int sw, int sh, int x, int y, int w, int h, color_t color){
+    this->drawTextureQuad(texture, sx, sy, sw, sh, x, y, w, h, color);
+}
+
+void RGLES2::drawAtlas(const RAtlas& atlas, int region, int x, int y){
+    const ratlasregion_t* r = atlas.getRegion(region);
+    if(r == NULL) return;
+
+    this->drawTextureQuad(*atlas.getPage(r->page), r->x, r->y, r->width, r->height, x, y, r->width, r->height, WHITE);
+}
+
+void RGLES2::drawAtlas(const RAtlas& atlas, int region, int x, int y, int w, int h, color_t color){
+    const ratlasregion_t* r = atlas.getRegion(region);
+    if(r == NULL) return;
+
+    this->drawTextureQuad(*atlas.getPage(r->page), r->x, r->y, r->width, r->height, x, y, w, h, color);
+}
+
+void RGLES2::drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, color_t color){
     rbufferptr_t e_ptr;
     void* buffer;
 
-    this->setPipeline(trianglePipeline);
-    buffer = this->allocateElements(3, &e_ptr);
-
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
+    this->setPipeline(linePipeline);
+    buffer = this->allocateElements(3, 6, &e_ptr);
+    if(buffer == NULL) return;
 
-    vertices[0].x = (float) x0;
-    vertices[0].y = (float) y0;
-    vertices[0].z = 0.f;
+    putvertex(&e_ptr, 0, (float) x0, (float) y0);
+    putvertex(&e_ptr, 1, (float) x1, (float) y1);
+    putvertex(&e_ptr, 2, (float) x2, (float) y2);
 
-    vertices[1].x = (float) x1;
-    vertices[1].y = (float) y1;
-    vertices[1].z = 0.f;
+    for(int i = 0; i < 3; i++){
+        e_ptr.idx_ptr[i*2 + 0] = e_ptr.idx_base + i;
+        e_ptr.idx_ptr[i*2 + 1] = e_ptr.idx_base + ((i + 1) % 3);
+    }
 
-    vertices[2].x = (float) x2;
-    vertices[2].y = (float) y2;
-    vertices[2].z = 0.f;
+    copycolor(&e_ptr, 0, color, 3);
 
-    copycolor(&colors[0], color, 3);
     this->updateBuffer(buffer, 3, 0, 3, 0);
 }
 
-void RGLES2::drawFillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, color_t color1, color_t color2, color_t color3){
+void RGLES2::drawFillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, color_t color){
     rbufferptr_t e_ptr;
     void* buffer;
 
     this->setPipeline(trianglePipeline);
     buffer = this->allocateElements(3, &e_ptr);
+    if(buffer == NULL) return;
 
-    vertex3_t* vertices = (vertex3_t*) e_ptr.vtx_ptr;
-    color4_t*  colors   = (color4_t*) e_ptr.clr_ptr;
+    putvertex(&e_ptr, 0, (float) x0, (float) y0);
+    putvertex(&e_ptr, 1, (float) x1, (float) y1);
+    putvertex(&e_ptr, 2, (float) x2, (float) y2);
 
-    vertices[0].x = (float) x0;
-    vertices[0].y = (float) y0;
-    vertices[0].z = 0.f;
+    copycolor(&e_ptr, 0, color, 3);
+    this->updateBuffer(buffer, 3, 0, 3, 0);
+}
 
-    vertices[1].x = (float) x1;
-    vertices[1].y = (float) y1;
-    vertices[1].z = 0.f;
+void RGLES2::drawFillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, color_t color1, color_t color2, color_t color3){
+    rbufferptr_t e_ptr;
+    void* buffer;
 
-    vertices[2].x = (float) x2;
-    vertices[2].y = (float) y2;
-    vertices[2].z = 0.f;
+    this->setPipeline(trianglePipeline);
+    buffer = this->allocateElements(3, &e_ptr);
+    if(buffer == NULL) return;
 
-    color2rcolor(&colors[0], color1);
-    color2rcolor(&colors[1], color2);
-    color2rcolor(&colors[2], color3);
+    putvertex(&e_ptr, 0, (float) x0, (float) y0);
+    putvertex(&e_ptr, 1, (float) x1, (float) y1);
+    putvertex(&e_ptr, 2, (float) x2, (float) y2);
+
+    putcolor(&e_ptr, 0, color1);
+    putcolor(&e_ptr, 1, color2);
+    putcolor(&e_ptr, 2, color3);
 
     this->updateBuffer(buffer, 3, 0, 3, 0);
-}
\ No newline at end of file
+}
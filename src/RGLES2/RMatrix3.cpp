@@ -11,10 +11,59 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
+#include "SIMD.h"
 #include "RGLES2/RMatrix3.h"
 
+// Multiply kernel, r = a * b (column major). r must not alias a or b
+static inline void mat3Multiply(const float* a, const float* b, float* r){
+#if defined(ENYX_SIMD_SSE2) || defined(ENYX_SIMD_NEON)
+    // Columns padded to 4 lanes. Results go to an aligned temporal, overlapping 4 lane
+    // loads and stores on 3 float columns stall store forwarding (Slower than scalar code)
+    float temp[12] __attribute__((aligned(16)));
+
+#if defined(ENYX_SIMD_SSE2)
+    __m128 c0 = _mm_setr_ps(a[0], a[1], a[2], 0.f);
+    __m128 c1 = _mm_setr_ps(a[3], a[4], a[5], 0.f);
+    __m128 c2 = _mm_setr_ps(a[6], a[7], a[8], 0.f);
+
+    for(int j = 0; j < 3; j++){
+        __m128 v = _mm_mul_ps(c0, _mm_set1_ps(b[j*3 + 0]));
+        v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_set1_ps(b[j*3 + 1])));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_set1_ps(b[j*3 + 2])));
+
+        _mm_store_ps(temp + (j * 4), v);
+    }
+#else
+    float32x4_t c0 = vsetq_lane_f32(0.f, vld1q_f32(a + 0), 3);
+    float32x4_t c1 = vsetq_lane_f32(0.f, vld1q_f32(a + 3), 3);
+    float32x4_t c2 = vcombine_f32(vld1_f32(a + 6), vset_lane_f32(a[8], vdup_n_f32(0.f), 0));
+
+    for(int j = 0; j < 3; j++){
+        float32x4_t v = vmulq_n_f32(c0, b[j*3 + 0]);
+        v = vmlaq_n_f32(v, c1, b[j*3 + 1]);
+        v = vmlaq_n_f32(v, c2, b[j*3 + 2]);
+
+        vst1q_f32(temp + (j * 4), v);
+    }
+#endif
+
+    for(int j = 0; j < 3; j++){
+        r[j*3 + 0] = temp[j*4 + 0];
+        r[j*3 + 1] = temp[j*4 + 1];
+        r[j*3 + 2] = temp[j*4 + 2];
+    }
+#else
+    for(int j = 0; j < 3; j++){
+        for(int i = 0; i < 3; i++){
+            r[j*3 + i] = a[i] * b[j*3 + 0] + a[3 + i] * b[j*3 + 1] + a[6 + i] * b[j*3 + 2];
+        }
+    }
+#endif
+}
+
 RMatrix3::RMatrix3(){
     this->e[0] = 0.f;
     this->e[1] = 0.f;
@@ -73,18 +122,7 @@ RMatrix3 RMatrix3::operator-(const RMatrix3& other) const {
 
 RMatrix3 RMatrix3::operator*(const RMatrix3& other) const {
     RMatrix3 ret = RMatrix3();
-
-    ret.e[0] = this->e[0] * other.e[0] + this->e[3] * other.e[1] + this->e[6] * other.e[2];
-    ret.e[1] = this->e[1] * other.e[0] + this->e[4] * other.e[1] + this->e[7] * other.e[2];
-    ret.e[2] = this->e[2] * other.e[0] + this->e[5] * other.e[1] + this->e[8] * other.e[2];
-
-    ret.e[3] = this->e[0] * other.e[3] + this->e[3] * other.e[4] + this->e[6] * other.e[5];
-    ret.e[4] = this->e[1] * other.e[3] + this->e[4] * other.e[4] + this->e[7] * other.e[5];
-    ret.e[5] = this->e[2] * other.e[3] + this->e[5] * other.e[4] + this->e[8] * other.e[5];
-
-    ret.e[6] = this->e[0] * other.e[6] + this->e[3] * other.e[7] + this->e[6] * other.e[8];
-    ret.e[7] = this->e[1] * other.e[6] + this->e[4] * other.e[7] + this->e[7] * other.e[8];
-    ret.e[8] = this->e[2] * other.e[6] + this->e[5] * other.e[7] + this->e[8] * other.e[8];
+    mat3Multiply(this->e, other.e, ret.e);
 
     return ret;
 }
@@ -134,21 +172,10 @@ RMatrix3& RMatrix3::operator-=(const RMatrix3& other){
 }
 
 RMatrix3& RMatrix3::operator*=(const RMatrix3& other){
-    RMatrix3 temp = RMatrix3();
+    float temp[9];
+    mat3Multiply(this->e, other.e, temp);
 
-    temp.e[0] = this->e[0] * other.e[0] + this->e[3] * other.e[1] + this->e[6] * other.e[2];
-    temp.e[1] = this->e[1] * other.e[0] + this->e[4] * other.e[1] + this->e[7] * other.e[2];
-    temp.e[2] = this->e[2] * other.e[0] + this->e[5] * other.e[1] + this->e[8] * other.e[2];
-
-    temp.e[3] = this->e[0] * other.e[3] + this->e[3] * other.e[4] + this->e[6] * other.e[5];
-    temp.e[4] = this->e[1] * other.e[3] + this->e[4] * other.e[4] + this->e[7] * other.e[5];
-    temp.e[5] = this->e[2] * other.e[3] + this->e[5] * other.e[4] + this->e[8] * other.e[5];
-
-    temp.e[6] = this->e[0] * other.e[6] + this->e[3] * other.e[7] + this->e[6] * other.e[8];
-    temp.e[7] = this->e[1] * other.e[6] + this->e[4] * other.e[7] + this->e[7] * other.e[8];
-    temp.e[8] = this->e[2] * other.e[6] + this->e[5] * other.e[7] + this->e[8] * other.e[8];
-
-    *this = temp;
+    memcpy(this->e, temp, sizeof(temp));
     return *this;
 }
 
@@ -186,6 +213,60 @@ float* RMatrix3::getArray(){
     return this->e;
 }
 
+void RMatrix3::transformPoints(const float* in, float* out, size_t n) const {
+    // Affine 2D transform
+    const float a  = this->e[0];
+    const float b  = this->e[1];
+    const float c  = this->e[3];
+    const float d  = this->e[4];
+    const float tx = this->e[6];
+    const float ty = this->e[7];
+
+    size_t i = 0;
+
+#if defined(ENYX_SIMD_SSE2)
+    // Two points per register: x0 y0 x1 y1
+    const __m128 m_ab = _mm_setr_ps(a, b, a, b);
+    const __m128 m_cd = _mm_setr_ps(c, d, c, d);
+    const __m128 m_t  = _mm_setr_ps(tx, ty, tx, ty);
+
+    for(; i + 4 <= n; i += 4){
+        __m128 p0 = _mm_loadu_ps(in + (i * 2));
+        __m128 p1 = _mm_loadu_ps(in + (i * 2) + 4);
+
+        __m128 x0 = _mm_shuffle_ps(p0, p0, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 y0 = _mm_shuffle_ps(p0, p0, _MM_SHUFFLE(3, 3, 1, 1));
+        __m128 x1 = _mm_shuffle_ps(p1, p1, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 y1 = _mm_shuffle_ps(p1, p1, _MM_SHUFFLE(3, 3, 1, 1));
+
+        __m128 r0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, m_ab), _mm_mul_ps(y0, m_cd)), m_t);
+        __m128 r1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x1, m_ab), _mm_mul_ps(y1, m_cd)), m_t);
+
+        _mm_storeu_ps(out + (i * 2),     r0);
+        _mm_storeu_ps(out + (i * 2) + 4, r1);
+    }
+#elif defined(ENYX_SIMD_NEON)
+    // Four points per iteration, deinterleaved
+    for(; i + 4 <= n; i += 4){
+        float32x4x2_t p = vld2q_f32(in + (i * 2));
+        float32x4x2_t r;
+
+        r.val[0] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(tx), p.val[0], a), p.val[1], c);
+        r.val[1] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(ty), p.val[0], b), p.val[1], d);
+
+        vst2q_f32(out + (i * 2), r);
+    }
+#endif
+
+    for(; i < n; i++){
+        float x = in[i*2 + 0];
+        float y = in[i*2 + 1];
+
+        out[i*2 + 0] = a * x + c * y + tx;
+        out[i*2 + 1] = b * x + d * y + ty;
+    }
+}
+
 void RMatrix3::loadIdentity(){
     this->e[0] = 1.f;
     this->e[1] = 0.f;
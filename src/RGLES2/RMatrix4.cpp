@@ -12,10 +12,55 @@
 #include <stdio.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
+#include "SIMD.h"
 #include "RGLES2/RMatrix4.h"
 
+// Multiply kernel, r = a * b (column major). r must not alias a or b
+static inline void mat4Multiply(const float* a, const float* b, float* r){
+#if defined(ENYX_SIMD_SSE2)
+    __m128 c0 = _mm_loadu_ps(a + 0);
+    __m128 c1 = _mm_loadu_ps(a + 4);
+    __m128 c2 = _mm_loadu_ps(a + 8);
+    __m128 c3 = _mm_loadu_ps(a + 12);
+
+    for(int j = 0; j < 4; j++){
+        const float* bc = b + (j * 4);
+
+        __m128 v = _mm_mul_ps(c0, _mm_set1_ps(bc[0]));
+        v = _mm_add_ps(v, _mm_mul_ps(c1, _mm_set1_ps(bc[1])));
+        v = _mm_add_ps(v, _mm_mul_ps(c2, _mm_set1_ps(bc[2])));
+        v = _mm_add_ps(v, _mm_mul_ps(c3, _mm_set1_ps(bc[3])));
+
+        _mm_storeu_ps(r + (j * 4), v);
+    }
+#elif defined(ENYX_SIMD_NEON)
+    float32x4_t c0 = vld1q_f32(a + 0);
+    float32x4_t c1 = vld1q_f32(a + 4);
+    float32x4_t c2 = vld1q_f32(a + 8);
+    float32x4_t c3 = vld1q_f32(a + 12);
+
+    for(int j = 0; j < 4; j++){
+        const float* bc = b + (j * 4);
+
+        float32x4_t v = vmulq_n_f32(c0, bc[0]);
+        v = vmlaq_n_f32(v, c1, bc[1]);
+        v = vmlaq_n_f32(v, c2, bc[2]);
+        v = vmlaq_n_f32(v, c3, bc[3]);
+
+        vst1q_f32(r + (j * 4), v);
+    }
+#else
+    for(int j = 0; j < 4; j++){
+        for(int i = 0; i < 4; i++){
+            r[j*4 + i] = a[i] * b[j*4 + 0] + a[4 + i] * b[j*4 + 1] + a[8 + i] * b[j*4 + 2] + a[12 + i] * b[j*4 + 3];
+        }
+    }
+#endif
+}
+
 // RMatrix4 implementation
 RMatrix4::RMatrix4(){
     this->e[0]  = 0.f;
@@ -103,26 +148,7 @@ RMatrix4 RMatrix4::operator-(const RMatrix4& other) const {
 
 RMatrix4 RMatrix4::operator*(const RMatrix4& other) const {
     RMatrix4 ret = RMatrix4();
-
-    ret.e[0]  = this->e[0] * other.e[0] + this->e[4] * other.e[1] + this->e[8]  * other.e[2] + this->e[12] * other.e[3];
-    ret.e[1]  = this->e[1] * other.e[0] + this->e[5] * other.e[1] + this->e[9]  * other.e[2] + this->e[13] * other.e[3];
-    ret.e[2]  = this->e[2] * other.e[0] + this->e[6] * other.e[1] + this->e[10] * other.e[2] + this->e[14] * other.e[3];
-    ret.e[3]  = this->e[3] * other.e[0] + this->e[7] * other.e[1] + this->e[11] * other.e[2] + this->e[15] * other.e[3];
-
-    ret.e[4]  = this->e[0] * other.e[4] + this->e[4] * other.e[5] + this->e[8]  * other.e[6] + this->e[12] * other.e[7];
-    ret.e[5]  = this->e[1] * other.e[4] + this->e[5] * other.e[5] + this->e[9]  * other.e[6] + this->e[13] * other.e[7];
-    ret.e[6]  = this->e[2] * other.e[4] + this->e[6] * other.e[5] + this->e[10] * other.e[6] + this->e[14] * other.e[7];
-    ret.e[7]  = this->e[3] * other.e[4] + this->e[7] * other.e[5] + this->e[11] * other.e[6] + this->e[15] * other.e[7];
-
-    ret.e[8]  = this->e[0] * other.e[8] + this->e[4] * other.e[9] + this->e[8]  * other.e[10] + this->e[12] * other.e[11];
-    ret.e[9]  = this->e[1] * other.e[8] + this->e[5] * other.e[9] + this->e[9]  * other.e[10] + this->e[13] * other.e[11];
-    ret.e[10] = this->e[2] * other.e[8] + this->e[6] * other.e[9] + this->e[10] * other.e[10] + this->e[14] * other.e[11];
-    ret.e[11] = this->e[3] * other.e[8] + this->e[7] * other.e[9] + this->e[11] * other.e[10] + this->e[15] * other.e[11];
-
-    ret.e[12] = this->e[0] * other.e[12] + this->e[4] * other.e[13] + this->e[8]  * other.e[14] + this->e[12] * other.e[15];
-    ret.e[13] = this->e[1] * other.e[12] + this->e[5] * other.e[13] + this->e[9]  * other.e[14] + this->e[13] * other.e[15];
-    ret.e[14] = this->e[2] * other.e[12] + this->e[6] * other.e[13] + this->e[10] * other.e[14] + this->e[14] * other.e[15];
-    ret.e[15] = this->e[3] * other.e[12] + this->e[7] * other.e[13] + this->e[11] * other.e[14] + this->e[15] * other.e[15];
+    mat4Multiply(this->e, other.e, ret.e);
 
     return ret;
 }
@@ -193,29 +219,10 @@ RMatrix4& RMatrix4::operator-=(const RMatrix4& other){
 }
 
 RMatrix4& RMatrix4::operator*=(const RMatrix4& other){
-    RMatrix4 temp = RMatrix4();
+    float temp[16];
+    mat4Multiply(this->e, other.e, temp);
 
-    temp.e[0]  = this->e[0] * other.e[0] + this->e[4] * other.e[1] + this->e[8]  * other.e[2] + this->e[12] * other.e[3];
-    temp.e[1]  = this->e[1] * other.e[0] + this->e[5] * other.e[1] + this->e[9]  * other.e[2] + this->e[13] * other.e[3];
-    temp.e[2]  = this->e[2] * other.e[0] + this->e[6] * other.e[1] + this->e[10] * other.e[2] + this->e[14] * other.e[3];
-    temp.e[3]  = this->e[3] * other.e[0] + this->e[7] * other.e[1] + this->e[11] * other.e[2] + this->e[15] * other.e[3];
-
-    temp.e[4]  = this->e[0] * other.e[4] + this->e[4] * other.e[5] + this->e[8]  * other.e[6] + this->e[12] * other.e[7];
-    temp.e[5]  = this->e[1] * other.e[4] + this->e[5] * other.e[5] + this->e[9]  * other.e[6] + this->e[13] * other.e[7];
-    temp.e[6]  = this->e[2] * other.e[4] + this->e[6] * other.e[5] + this->e[10] * other.e[6] + this->e[14] * other.e[7];
-    temp.e[7]  = this->e[3] * other.e[4] + this->e[7] * other.e[5] + this->e[11] * other.e[6] + this->e[15] * other.e[7];
-
-    temp.e[8]  = this->e[0] * other.e[8] + this->e[4] * other.e[9] + this->e[8]  * other.e[10] + this->e[12] * other.e[11];
-    temp.e[9]  = this->e[1] * other.e[8] + this->e[5] * other.e[9] + this->e[9]  * other.e[10] + this->e[13] * other.e[11];
-    temp.e[10] = this->e[2] * other.e[8] + this->e[6] * other.e[9] + this->e[10] * other.e[10] + this->e[14] * other.e[11];
-    temp.e[11] = this->e[3] * other.e[8] + this->e[7] * other.e[9] + this->e[11] * other.e[10] + this->e[15] * other.e[11];
-
-    temp.e[12] = this->e[0] * other.e[12] + this->e[4] * other.e[13] + this->e[8]  * other.e[14] + this->e[12] * other.e[15];
-    temp.e[13] = this->e[1] * other.e[12] + this->e[5] * other.e[13] + this->e[9]  * other.e[14] + this->e[13] * other.e[15];
-    temp.e[14] = this->e[2] * other.e[12] + this->e[6] * other.e[13] + this->e[10] * other.e[14] + this->e[14] * other.e[15];
-    temp.e[15] = this->e[3] * other.e[12] + this->e[7] * other.e[13] + this->e[11] * other.e[14] + this->e[15] * other.e[15];
-
-    *this = temp;
+    memcpy(this->e, temp, sizeof(temp));
     return *this;
 }
 
@@ -265,6 +272,60 @@ float* RMatrix4::getArray(){
     return this->e;
 }
 
+void RMatrix4::transformPoints(const float* in, float* out, size_t n) const {
+    // 2D points: z = 0, w = 1. Affine part of the matrix
+    const float a  = this->e[0];
+    const float b  = this->e[1];
+    const float c  = this->e[4];
+    const float d  = this->e[5];
+    const float tx = this->e[12];
+    const float ty = this->e[13];
+
+    size_t i = 0;
+
+#if defined(ENYX_SIMD_SSE2)
+    // Two points per register: x0 y0 x1 y1
+    const __m128 m_ab = _mm_setr_ps(a, b, a, b);
+    const __m128 m_cd = _mm_setr_ps(c, d, c, d);
+    const __m128 m_t  = _mm_setr_ps(tx, ty, tx, ty);
+
+    for(; i + 4 <= n; i += 4){
+        __m128 p0 = _mm_loadu_ps(in + (i * 2));
+        __m128 p1 = _mm_loadu_ps(in + (i * 2) + 4);
+
+        __m128 x0 = _mm_shuffle_ps(p0, p0, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 y0 = _mm_shuffle_ps(p0, p0, _MM_SHUFFLE(3, 3, 1, 1));
+        __m128 x1 = _mm_shuffle_ps(p1, p1, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 y1 = _mm_shuffle_ps(p1, p1, _MM_SHUFFLE(3, 3, 1, 1));
+
+        __m128 r0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, m_ab), _mm_mul_ps(y0, m_cd)), m_t);
+        __m128 r1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x1, m_ab), _mm_mul_ps(y1, m_cd)), m_t);
+
+        _mm_storeu_ps(out + (i * 2),     r0);
+        _mm_storeu_ps(out + (i * 2) + 4, r1);
+    }
+#elif defined(ENYX_SIMD_NEON)
+    // Four points per iteration, deinterleaved
+    for(; i + 4 <= n; i += 4){
+        float32x4x2_t p = vld2q_f32(in + (i * 2));
+        float32x4x2_t r;
+
+        r.val[0] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(tx), p.val[0], a), p.val[1], c);
+        r.val[1] = vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(ty), p.val[0], b), p.val[1], d);
+
+        vst2q_f32(out + (i * 2), r);
+    }
+#endif
+
+    for(; i < n; i++){
+        float x = in[i*2 + 0];
+        float y = in[i*2 + 1];
+
+        out[i*2 + 0] = a * x + c * y + tx;
+        out[i*2 + 1] = b * x + d * y + ty;
+    }
+}
+
 void RMatrix4::loadIdentity(){
     this->e[0]  = 1.f;
     this->e[1]  = 0.f;
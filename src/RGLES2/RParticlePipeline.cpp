@@ -0,0 +1,91 @@
+/**
+ * @file RParticlePipeline.cpp
+ * @author Brais Solla González
+ * @brief RParticlePipeline implementation
+ * @version 0.1
+ * @date 2021-12-03
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Debug.h"
+#include "RGLES2/RGLES2.h"
+#include "RGLES2/RShader.h"
+#include "RGLES2/RPipeline.h"
+#include "RGLES2/RParticlePipeline.h"
+#include "RGLES2/shaders/particle.h"
+
+
+// Particle (Point sprites) pipeline
+RParticlePipeline::RParticlePipeline(){
+    Debug::info("[%s:%d]: Creating particle pipeline...\n", __FILE__, __LINE__);
+    this->internalShader = new RShader(particle_vert, particle_frag);
+    this->pointSize      = 1.f;
+    this->enabled        = false;
+
+    if(this->internalShader->getPointSizeUniform() == -1){
+        Debug::warning("[%s:%d]: Particle shader is missing the point size uniform!\n", __FILE__, __LINE__);
+    }
+}
+
+RParticlePipeline::~RParticlePipeline(){
+    delete this->internalShader;
+}
+
+void RParticlePipeline::enable(){
+    this->internalShader->attach();
+    this->enabled = true;
+
+    glUniform1f(this->internalShader->getPointSizeUniform(), this->pointSize);
+
+    // Sprite borders are antialiased, blend them
+    RPipeline::enableAlphaBlend();
+}
+
+void RParticlePipeline::disable(){
+    this->internalShader->dettach();
+    this->enabled = false;
+
+    RPipeline::disableAlphaBlend();
+}
+
+void RParticlePipeline::setTransform(RMatrix4& matrix){
+    glUniformMatrix4fv(this->internalShader->getTransformMatrixUniform(), 1, GL_FALSE, matrix.getArray());
+}
+
+int RParticlePipeline::getVertexFormat() const {
+    // Position (z = size) + color, interleaved
+    return VERTEX_FORMAT_PC;
+}
+
+void RParticlePipeline::setPointSize(float pointSize){
+    this->pointSize = pointSize;
+
+    // Uniforms can only be set while the program is in use
+    if(this->enabled){
+        glUniform1f(this->internalShader->getPointSizeUniform(), this->pointSize);
+    }
+}
+
+float RParticlePipeline::getPointSize() const {
+    return this->pointSize;
+}
+
+void RParticlePipeline::draw(void* buffer){
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+    // Offsets are relative to the bound buffer object when streaming through VBOs
+    intptr_t buffer_base    = header->vbo ? 0 : (intptr_t) header + RBUFFERHEADER_SIZE;
+
+    void* vtxaddr = (void*) (buffer_base + header->vtx_offset);
+    void* clraddr = (void*) (buffer_base + header->clr_offset);
+
+    glVertexAttribPointer(this->internalShader->getVertexAttrib(), 3, GL_FLOAT, GL_FALSE, header->vtx_stride, vtxaddr);
+    glVertexAttribPointer(this->internalShader->getColorAttrib(),  4, GL_UNSIGNED_BYTE, GL_TRUE, header->clr_stride, clraddr);
+
+    // One point per particle, never indexed
+    glDrawArrays(GL_POINTS, 0, header->elements);
+}
@@ -22,6 +22,7 @@ RShader::RShader(){
     this->color_attrib    = -1;
     this->texcoord_attrib = -1;
     this->normal_attrib   = -1;
+    this->params_attrib   = -1;
 
 
     this->txMatrix_uniform    = -1;
@@ -48,6 +49,7 @@ RShader::RShader(const char* vertexSource, const char* fragSource){
     this->color_attrib    = -1;
     this->texcoord_attrib = -1;
     this->normal_attrib   = -1;
+    this->params_attrib   = -1;
 
 
     this->txMatrix_uniform    = -1;
@@ -120,6 +122,8 @@ int RShader::init(const char* vertexSource, const char* fragSource){
     glBindAttribLocation(this->programId, 1, "a_color");
     glBindAttribLocation(this->programId, 2, "a_vtxcoord");
     glBindAttribLocation(this->programId, 3, "a_normal");
+    // Generic per vertex parameters (Shape pipeline)
+    glBindAttribLocation(this->programId, 4, "a_params");
 
     // Attach and link shader
     glAttachShader(this->programId, vert);
@@ -145,6 +149,7 @@ int RShader::init(const char* vertexSource, const char* fragSource){
     this->color_attrib         = this->getAttribLocation("a_color");
     this->texcoord_attrib      = this->getAttribLocation("a_vtxcoord");
     this->normal_attrib        = this->getAttribLocation("a_normal");
+    this->params_attrib        = this->getAttribLocation("a_params");
 
     this->txMatrix_uniform     = this->getUniformLocation("u_tmtrx");
     this->texUnit_uniform      = this->getUniformLocation("u_textureunit");
@@ -188,6 +193,10 @@ GLint RShader::getNormalAttrib() const {
     return this->normal_attrib;
 }
 
+GLint RShader::getParamsAttrib() const {
+    return this->params_attrib;
+}
+
 GLint RShader::getTransformMatrixUniform() const {
     return this->txMatrix_uniform;
 }
@@ -211,6 +220,7 @@ void RShader::attach() const {
     if(this->color_attrib    != -1)   glEnableVertexAttribArray(this->color_attrib);
     if(this->texcoord_attrib != -1)   glEnableVertexAttribArray(this->texcoord_attrib);
     if(this->normal_attrib   != -1)   glEnableVertexAttribArray(this->normal_attrib);
+    if(this->params_attrib   != -1)   glEnableVertexAttribArray(this->params_attrib);
 }
 
 void RShader::dettach() const {
@@ -218,6 +228,7 @@ void RShader::dettach() const {
     if(this->color_attrib    != -1) glDisableVertexAttribArray(this->color_attrib);
     if(this->texcoord_attrib != -1) glDisableVertexAttribArray(this->texcoord_attrib);
     if(this->normal_attrib   != -1) glDisableVertexAttribArray(this->normal_attrib);
+    if(this->params_attrib   != -1) glDisableVertexAttribArray(this->params_attrib);
 }
 
 void RShader::destroy(){
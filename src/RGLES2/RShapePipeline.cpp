@@ -0,0 +1,77 @@
+/**
+ * @file RShapePipeline.cpp
+ * @author Brais Solla González
+ * @brief RShapePipeline implementation
+ * @version 0.1
+ * @date 2021-12-03
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Debug.h"
+#include "RGLES2/RGLES2.h"
+#include "RGLES2/RShader.h"
+#include "RGLES2/RPipeline.h"
+#include "RGLES2/RShapePipeline.h"
+#include "RGLES2/shaders/shape.h"
+
+
+// Shape (SDF quads) pipeline
+RShapePipeline::RShapePipeline(){
+    Debug::info("[%s:%d]: Creating shape pipeline...\n", __FILE__, __LINE__);
+    this->internalShader = new RShader(shape_vert, shape_frag);
+}
+
+RShapePipeline::~RShapePipeline(){
+    delete this->internalShader;
+}
+
+void RShapePipeline::enable(){
+    this->internalShader->attach();
+
+    // Antialiased edges need real alpha blending
+    RPipeline::enableAlphaBlend();
+}
+
+void RShapePipeline::disable(){
+    this->internalShader->dettach();
+
+    RPipeline::disableAlphaBlend();
+}
+
+void RShapePipeline::setTransform(RMatrix4& matrix){
+    glUniformMatrix4fv(this->internalShader->getTransformMatrixUniform(), 1, GL_FALSE, matrix.getArray());
+}
+
+int RShapePipeline::getVertexFormat() const {
+    // Position + color + local position + shape parameters, interleaved
+    return VERTEX_FORMAT_PCTS;
+}
+
+void RShapePipeline::draw(void* buffer){
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+    // Offsets are relative to the bound buffer object when streaming through VBOs
+    intptr_t buffer_base    = header->vbo ? 0 : (intptr_t) header + RBUFFERHEADER_SIZE;
+
+    void* vtxaddr = (void*) (buffer_base + header->vtx_offset);
+    void* clraddr = (void*) (buffer_base + header->clr_offset);
+    void* txcaddr = (void*) (buffer_base + header->txc_offset);
+    void* prmaddr = (void*) (buffer_base + header->prm_offset);
+
+    glVertexAttribPointer(this->internalShader->getVertexAttrib(),   3, GL_FLOAT, GL_FALSE, header->vtx_stride, vtxaddr);
+    glVertexAttribPointer(this->internalShader->getColorAttrib(),    4, GL_UNSIGNED_BYTE, GL_TRUE, header->clr_stride, clraddr);
+    glVertexAttribPointer(this->internalShader->getTexcoordAttrib(), 2, GL_FLOAT, GL_FALSE, header->txc_stride, txcaddr);
+    glVertexAttribPointer(this->internalShader->getParamsAttrib(),   4, GL_FLOAT, GL_FALSE, header->prm_stride, prmaddr);
+
+    if(header->idx_count){
+        // Shapes are always quads
+        intptr_t index_base = header->ibo ? 0 : (intptr_t) header + RBUFFERHEADER_SIZE + header->idx_offset;
+        glDrawElements(GL_TRIANGLES, header->idx_count, GL_UNSIGNED_SHORT, (void*) index_base);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, header->elements);
+    }
+}
@@ -0,0 +1,402 @@
+/**
+ * @file RTextureCache.cpp
+ * @author Brais Solla González
+ * @brief RTextureCache implementation
+ * @version 0.1
+ * @date 2021-12-09
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Debug.h"
+#include "RGLES2/RGLES2.h"
+#include "RGLES2/RTextureCache.h"
+
+#define TEXTURECACHE_INITIAL_ENTRIES 64
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME        1099511628211ULL
+
+static bool isPowerOf2(int value){
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+
+RTextureCache::RTextureCache(uint64_t budget){
+    this->entries       = NULL;
+    this->entryCount    = 0;
+    this->entryCapacity = 0;
+    this->slots         = NULL;
+    this->slotCount     = 0;
+
+    this->head  = -1;
+    this->tail  = -1;
+    // Entries start at frame 0, never the current one
+    this->frame = 1;
+
+    this->retired         = NULL;
+    this->retiredCount    = 0;
+    this->retiredCapacity = 0;
+    this->retiredBytes    = 0;
+
+    memset(&this->stats, 0, sizeof(rtexturecachestats_t));
+    this->stats.budget = budget;
+}
+
+RTextureCache::~RTextureCache(){
+    this->clear();
+}
+
+uint64_t RTextureCache::hash(const char* name){
+    uint64_t value = FNV_OFFSET_BASIS;
+    for(const uint8_t* p = (const uint8_t*) name; *p; p++){
+        value ^= *p;
+        value *= FNV_PRIME;
+    }
+    return value;
+}
+
+size_t RTextureCache::textureBytes(int width, int height, int components, bool mipmaps){
+    size_t bytes = (size_t) width * height * components;
+
+    while(mipmaps && (width > 1 || height > 1)){
+        width  = (width  > 1) ? width  / 2 : 1;
+        height = (height > 1) ? height / 2 : 1;
+        bytes += (size_t) width * height * components;
+    }
+    return bytes;
+}
+
+int32_t RTextureCache::find(uint64_t hash, const char* name) const {
+    if(this->slotCount == 0) return -1;
+
+    uint32_t mask = this->slotCount - 1;
+    for(uint32_t i = (uint32_t) hash & mask; this->slots[i] >= 0; i = (i + 1) & mask){
+        const rtexturecacheentry_t* entry = &this->entries[this->slots[i]];
+        if(entry->hash == hash && (name == NULL || strcmp(entry->name, name) == 0)) return this->slots[i];
+    }
+    return -1;
+}
+
+bool RTextureCache::growSlots(){
+    uint32_t new_count = this->slotCount ? this->slotCount * 2 : TEXTURECACHE_INITIAL_ENTRIES * 2;
+    int32_t* new_slots = (int32_t*) rmalloc(new_count * sizeof(int32_t));
+    if(new_slots == NULL) return false;
+
+    for(uint32_t i = 0; i < new_count; i++) new_slots[i] = -1;
+
+    uint32_t mask = new_count - 1;
+    for(uint32_t e = 0; e < this->entryCount; e++){
+        uint32_t i = (uint32_t) this->entries[e].hash & mask;
+        while(new_slots[i] >= 0) i = (i + 1) & mask;
+        new_slots[i] = (int32_t) e;
+    }
+
+    if(this->slots) rfree(this->slots);
+    this->slots     = new_slots;
+    this->slotCount = new_count;
+    return true;
+}
+
+int32_t RTextureCache::insert(uint64_t hash, const char* name, Pixmap* source, uint32_t flags){
+    // Table kept at most half full
+    if((this->entryCount + 1) * 2 > this->slotCount && !this->growSlots()){
+        Debug::error("[%s:%d]: Cannot grow the texture cache table!\n", __FILE__, __LINE__);
+        return -1;
+    }
+
+    if(this->entryCount == this->entryCapacity){
+        uint32_t new_capacity = this->entryCapacity ? this->entryCapacity * 2 : TEXTURECACHE_INITIAL_ENTRIES;
+        rtexturecacheentry_t* new_entries = (rtexturecacheentry_t*) rrealloc(this->entries, new_capacity * sizeof(rtexturecacheentry_t));
+        if(new_entries == NULL){
+            Debug::error("[%s:%d]: Cannot grow the texture cache entries!\n", __FILE__, __LINE__);
+            return -1;
+        }
+
+        this->entries       = new_entries;
+        this->entryCapacity = new_capacity;
+    }
+
+    char* name_copy = (char*) rmalloc(strlen(name) + 1);
+    if(name_copy == NULL) return -1;
+    strcpy(name_copy, name);
+
+    int32_t index = (int32_t) this->entryCount++;
+    rtexturecacheentry_t* entry = &this->entries[index];
+    entry->hash    = hash;
+    entry->name    = name_copy;
+    entry->source  = source;
+    entry->texture = NULL;
+    entry->bytes   = 0;
+    entry->flags   = flags;
+    entry->frame   = 0;
+    entry->prev    = -1;
+    entry->next    = -1;
+
+    uint32_t mask = this->slotCount - 1;
+    uint32_t i    = (uint32_t) hash & mask;
+    while(this->slots[i] >= 0) i = (i + 1) & mask;
+    this->slots[i] = index;
+
+    this->stats.entries = this->entryCount;
+    return index;
+}
+
+int RTextureCache::add(const char* fileName, uint32_t flags){
+    uint64_t hash  = RTextureCache::hash(fileName);
+    int32_t  index = this->find(hash, fileName);
+    if(index >= 0) return 0;
+
+    return (this->insert(hash, fileName, NULL, flags) >= 0) ? 0 : 1;
+}
+
+int RTextureCache::add(const char* name, const Pixmap& pixmap, uint32_t flags){
+    if(!pixmap.exists()){
+        Debug::error("[%s:%d]: Cannot add %s to the texture cache, empty pixmap!\n", __FILE__, __LINE__, name);
+        return 1;
+    }
+
+    uint64_t hash  = RTextureCache::hash(name);
+    int32_t  index = this->find(hash, name);
+    if(index >= 0){
+        // New contents for the asset, uploaded on the next use
+        rtexturecacheentry_t* entry = &this->entries[index];
+        if(entry->texture) this->evict(index);
+        if(entry->source)  *entry->source = pixmap;
+        else               entry->source  = new Pixmap(pixmap);
+        entry->flags = flags;
+        return 0;
+    }
+
+    return (this->insert(hash, name, new Pixmap(pixmap), flags) >= 0) ? 0 : 1;
+}
+
+void RTextureCache::unlink(int32_t index){
+    rtexturecacheentry_t* entry = &this->entries[index];
+
+    if(entry->prev >= 0) this->entries[entry->prev].next = entry->next;
+    else                 this->head = entry->next;
+    if(entry->next >= 0) this->entries[entry->next].prev = entry->prev;
+    else                 this->tail = entry->prev;
+
+    entry->prev = -1;
+    entry->next = -1;
+}
+
+void RTextureCache::pushFront(int32_t index){
+    rtexturecacheentry_t* entry = &this->entries[index];
+
+    entry->prev = -1;
+    entry->next = this->head;
+    if(this->head >= 0) this->entries[this->head].prev = index;
+    this->head = index;
+    if(this->tail < 0) this->tail = index;
+}
+
+void RTextureCache::evict(int32_t index){
+    rtexturecacheentry_t* entry = &this->entries[index];
+    if(entry->texture == NULL) return;
+
+    this->unlink(index);
+    this->stats.resident--;
+    this->stats.evictions++;
+
+    // Quads batched or recorded this frame still use its texture id
+    if(entry->frame == this->frame){
+        if(this->retiredCount == this->retiredCapacity){
+            uint32_t   capacity = this->retiredCapacity ? this->retiredCapacity * 2 : 16;
+            RTexture** retired  = (RTexture**) rrealloc(this->retired, capacity * sizeof(RTexture*));
+            if(retired){
+                this->retired         = retired;
+                this->retiredCapacity = capacity;
+            }
+        }
+
+        if(this->retiredCount < this->retiredCapacity){
+            this->retired[this->retiredCount++] = entry->texture;
+            this->retiredBytes += entry->bytes;
+            entry->texture = NULL;
+            return;
+        }
+        Debug::warning("[%s:%d]: Cannot defer deleting texture %s, deleted while in use!\n", __FILE__, __LINE__, entry->name);
+    }
+
+    delete entry->texture;
+    entry->texture = NULL;
+    this->stats.bytes_resident -= entry->bytes;
+}
+
+void RTextureCache::deleteRetired(){
+    for(uint32_t i = 0; i < this->retiredCount; i++) delete this->retired[i];
+
+    this->stats.bytes_resident -= this->retiredBytes;
+    this->retiredCount = 0;
+    this->retiredBytes = 0;
+}
+
+void RTextureCache::makeRoom(size_t bytes){
+    // Used textures are moved to the front, the ones used this frame are all at the front
+    while(this->tail >= 0 && this->stats.bytes_resident + bytes > this->stats.budget){
+        if(this->entries[this->tail].frame == this->frame) break;
+        this->evict(this->tail);
+    }
+}
+
+bool RTextureCache::load(int32_t index){
+    rtexturecacheentry_t* entry = &this->entries[index];
+
+    // Decoded again from the file, or the pixmap kept
+    Pixmap  file_pixmap;
+    Pixmap* pixmap = entry->source;
+    if(pixmap == NULL){
+        file_pixmap = Pixmap(entry->name);
+        pixmap      = &file_pixmap;
+    }
+
+    if(!pixmap->exists()){
+        Debug::error("[%s:%d]: Cannot load texture %s!\n", __FILE__, __LINE__, entry->name);
+        this->stats.failures++;
+        return false;
+    }
+
+    bool   mipmaps = (entry->flags & TEXTURECACHE_MIPMAPS) && isPowerOf2(pixmap->getWidth()) && isPowerOf2(pixmap->getHeight());
+    size_t bytes   = RTextureCache::textureBytes(pixmap->getWidth(), pixmap->getHeight(), pixmap->getComponents(), mipmaps);
+
+    this->makeRoom(bytes);
+    if(this->stats.bytes_resident + bytes > this->stats.budget){
+        Debug::warning("[%s:%d]: Texture cache over budget (%lu + %lu bytes of %s > %lu)\n", __FILE__, __LINE__,
+            (unsigned long) this->stats.bytes_resident, (unsigned long) bytes, entry->name, (unsigned long) this->stats.budget);
+    }
+
+    RTexture* texture = new RTexture(*pixmap);
+    if(texture->getTextureId() == 0){
+        delete texture;
+        this->stats.failures++;
+        return false;
+    }
+
+    if(mipmaps){
+        texture->genMipmaps();
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        texture->dettach();
+    }
+
+    entry->texture = texture;
+    entry->bytes   = bytes;
+    this->pushFront(index);
+
+    this->stats.bytes_resident += bytes;
+    this->stats.resident++;
+    return true;
+}
+
+RTexture* RTextureCache::use(int32_t index){
+    rtexturecacheentry_t* entry = &this->entries[index];
+
+    if(entry->texture){
+        this->stats.hits++;
+        if(this->head != index){
+            this->unlink(index);
+            this->pushFront(index);
+        }
+    } else {
+        this->stats.misses++;
+        if(!this->load(index)) return NULL;
+    }
+
+    entry->frame = this->frame;
+    return entry->texture;
+}
+
+RTexture* RTextureCache::get(uint64_t hash){
+    int32_t index = this->find(hash, NULL);
+    if(index < 0) return NULL;
+
+    return this->use(index);
+}
+
+RTexture* RTextureCache::get(const char* name){
+    uint64_t hash  = RTextureCache::hash(name);
+    int32_t  index = this->find(hash, name);
+
+    if(index < 0){
+        index = this->insert(hash, name, NULL, TEXTURECACHE_NONE);
+        if(index < 0) return NULL;
+    }
+
+    return this->use(index);
+}
+
+bool RTextureCache::contains(const char* name) const {
+    return this->find(RTextureCache::hash(name), name) >= 0;
+}
+
+bool RTextureCache::isResident(const char* name) const {
+    int32_t index = this->find(RTextureCache::hash(name), name);
+    return index >= 0 && this->entries[index].texture != NULL;
+}
+
+void RTextureCache::release(const char* name){
+    int32_t index = this->find(RTextureCache::hash(name), name);
+    if(index >= 0) this->evict(index);
+}
+
+void RTextureCache::setBudget(uint64_t budget){
+    this->stats.budget = budget;
+    this->makeRoom(0);
+}
+
+uint64_t RTextureCache::getBudget() const {
+    return this->stats.budget;
+}
+
+rtexturecachestats_t RTextureCache::getStats() const {
+    return this->stats;
+}
+
+void RTextureCache::resetStats(){
+    this->stats.hits      = 0;
+    this->stats.misses    = 0;
+    this->stats.evictions = 0;
+    this->stats.failures  = 0;
+}
+
+void RTextureCache::nextFrame(){
+    this->deleteRetired();
+    this->frame++;
+}
+
+void RTextureCache::clear(){
+    this->deleteRetired();
+    if(this->retired) rfree(this->retired);
+    this->retired         = NULL;
+    this->retiredCapacity = 0;
+
+    for(uint32_t i = 0; i < this->entryCount; i++){
+        rtexturecacheentry_t* entry = &this->entries[i];
+        if(entry->texture) delete entry->texture;
+        if(entry->source)  delete entry->source;
+        rfree(entry->name);
+    }
+
+    if(this->entries) rfree(this->entries);
+    if(this->slots)   rfree(this->slots);
+
+    this->entries       = NULL;
+    this->entryCount    = 0;
+    this->entryCapacity = 0;
+    this->slots         = NULL;
+    this->slotCount     = 0;
+    this->head          = -1;
+    this->tail          = -1;
+
+    this->stats.bytes_resident = 0;
+    this->stats.resident       = 0;
+    this->stats.entries        = 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file RTexturePipeline.cpp
+ * @author Brais Solla González
+ * @brief RTexturePipeline implementation
+ * @version 0.1
+ * @date 2021-12-08
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Debug.h"
+#include "RGLES2/RGLES2.h"
+#include "RGLES2/RShader.h"
+#include "RGLES2/RPipeline.h"
+#include "RGLES2/RTexturePipeline.h"
+#include "RGLES2/shaders/texture_multi.h"
+
+
+// Texture (Sprites) pipeline
+RTexturePipeline::RTexturePipeline(int units){
+    if(units < 1)                 units = 1;
+    if(units > TEXTURE_MAX_UNITS) units = TEXTURE_MAX_UNITS;
+
+    Debug::info("[%s:%d]: Creating texture pipeline (%d texture units)...\n", __FILE__, __LINE__, units);
+
+    // The fragment shader is built for the number of samplers
+    char fragSource[sizeof(texture_multi_frag) + 64];
+    snprintf(fragSource, sizeof(fragSource), "#define TEXTURE_UNITS %d\n%s", units, texture_multi_frag);
+
+    this->internalShader = new RShader(texture_multi_vert, fragSource);
+    this->textureCount   = 0;
+    this->units          = units;
+
+    for(int i = 0; i < TEXTURE_MAX_UNITS; i++) this->textures[i] = 0;
+
+    if(this->internalShader->getUniformLocation("u_textures") == -1){
+        Debug::warning("[%s:%d]: Texture shader is missing the texture units uniform!\n", __FILE__, __LINE__);
+    }
+}
+
+RTexturePipeline::~RTexturePipeline(){
+    delete this->internalShader;
+}
+
+void RTexturePipeline::enable(){
+    this->internalShader->attach();
+
+    // Sampler i reads unit i
+    GLint samplers[TEXTURE_MAX_UNITS];
+    for(int i = 0; i < this->units; i++) samplers[i] = i;
+    glUniform1iv(this->internalShader->getUniformLocation("u_textures"), this->units, samplers);
+
+    // Sprites have transparent texels
+    RPipeline::enableAlphaBlend();
+}
+
+void RTexturePipeline::disable(){
+    this->internalShader->dettach();
+
+    for(int i = this->textureCount - 1; i >= 0; i--){
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    RPipeline::disableAlphaBlend();
+}
+
+void RTexturePipeline::setTransform(RMatrix4& matrix){
+    glUniformMatrix4fv(this->internalShader->getTransformMatrixUniform(), 1, GL_FALSE, matrix.getArray());
+}
+
+int RTexturePipeline::getVertexFormat() const {
+    // Position + color + texcoord and unit, interleaved
+    return VERTEX_FORMAT_PCTU;
+}
+
+int RTexturePipeline::getTextureUnit(GLuint texture){
+    for(int i = 0; i < this->textureCount; i++){
+        if(this->textures[i] == texture) return i;
+    }
+
+    if(this->textureCount == this->units) return -1;
+
+    this->textures[this->textureCount] = texture;
+    return this->textureCount++;
+}
+
+void RTexturePipeline::clearTextures(){
+    this->textureCount = 0;
+}
+
+int RTexturePipeline::getUnits() const {
+    return this->units;
+}
+
+int RTexturePipeline::getTextureCount() const {
+    return this->textureCount;
+}
+
+void RTexturePipeline::draw(void* buffer){
+    rbufferheader_t* header = (rbufferheader_t*) buffer;
+    // Offsets are relative to the bound buffer object when streaming through VBOs
+    intptr_t buffer_base    = header->vbo ? 0 : (intptr_t) header + RBUFFERHEADER_SIZE;
+
+    void* vtxaddr = (void*) (buffer_base + header->vtx_offset);
+    void* clraddr = (void*) (buffer_base + header->clr_offset);
+    void* txcaddr = (void*) (buffer_base + header->txc_offset);
+
+    // Bound on every draw: creating or uploading a texture between draws changes the bindings.
+    // Unit 0 last, textures are created and uploaded on it
+    for(int i = this->textureCount - 1; i >= 0; i--){
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, this->textures[i]);
+    }
+
+    glVertexAttribPointer(this->internalShader->getVertexAttrib(),   3, GL_FLOAT, GL_FALSE, header->vtx_stride, vtxaddr);
+    glVertexAttribPointer(this->internalShader->getColorAttrib(),    4, GL_UNSIGNED_BYTE, GL_TRUE, header->clr_stride, clraddr);
+    glVertexAttribPointer(this->internalShader->getTexcoordAttrib(), 3, GL_FLOAT, GL_FALSE, header->txc_stride, txcaddr);
+
+    if(header->idx_count){
+        // Sprites are always quads
+        intptr_t index_base = header->ibo ? 0 : (intptr_t) header + RBUFFERHEADER_SIZE + header->idx_offset;
+        glDrawElements(GL_TRIANGLES, header->idx_count, GL_UNSIGNED_SHORT, (void*) index_base);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, header->elements);
+    }
+}
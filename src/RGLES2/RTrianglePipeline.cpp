@@ -49,9 +49,15 @@ void RTrianglePipeline::setTransform(RMatrix4& matrix){
     glUniformMatrix4fv(this->internalShader->getTransformMatrixUniform(), 1, GL_FALSE, matrix.getArray());
 }
 
+int RTrianglePipeline::getVertexFormat() const {
+    // Position + color, interleaved
+    return VERTEX_FORMAT_PC;
+}
+
 void RTrianglePipeline::draw(void* buffer){
     rbufferheader_t* header = (rbufferheader_t*) buffer;
-    intptr_t buffer_base    = (intptr_t) header + RBUFFERHEADER_SIZE;
+    // Offsets are relative to the bound buffer object when streaming through VBOs
+    intptr_t buffer_base    = header->vbo ? 0 : (intptr_t) header + RBUFFERHEADER_SIZE;
 
     void* vtxaddr = (void*) (buffer_base + header->vtx_offset);
     void* clraddr = (void*) (buffer_base + header->clr_offset);
@@ -59,11 +65,17 @@ void RTrianglePipeline::draw(void* buffer){
     uint32_t element_count = header->elements;
 
     // Set OpenGL ES attrib pointers
-    glVertexAttribPointer(this->internalShader->getVertexAttrib(), 3, GL_FLOAT, GL_FALSE, 0, vtxaddr);
-    glVertexAttribPointer(this->internalShader->getColorAttrib(),  4, GL_FLOAT, GL_FALSE, 0, clraddr);
-
-    // Draw arrays!
-    glDrawArrays(GL_TRIANGLES, 0, element_count);
+    glVertexAttribPointer(this->internalShader->getVertexAttrib(), 3, GL_FLOAT, GL_FALSE, header->vtx_stride, vtxaddr);
+    glVertexAttribPointer(this->internalShader->getColorAttrib(),  4, GL_UNSIGNED_BYTE, GL_TRUE, header->clr_stride, clraddr);
+
+    if(header->idx_count){
+        // Indexed batch. Indices are relative to the bound index buffer object when there's one
+        intptr_t index_base = header->ibo ? 0 : (intptr_t) header + RBUFFERHEADER_SIZE + header->idx_offset;
+        glDrawElements(GL_TRIANGLES, header->idx_count, GL_UNSIGNED_SHORT, (void*) index_base);
+    } else {
+        // Draw arrays!
+        glDrawArrays(GL_TRIANGLES, 0, element_count);
+    }
 
     // Update performance counter struct and reset current elements in header
     // perfstats.drawcalls++;
@@ -0,0 +1,237 @@
+/**
+ * @file RUploadQueue.cpp
+ * @author Brais Solla González
+ * @brief RUploadQueue implementation
+ * @version 0.1
+ * @date 2021-12-09
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "Debug.h"
+#include "RGLES2/RGLES2.h"
+#include "RGLES2/RUploadQueue.h"
+
+#define UPLOADQUEUE_INITIAL_JOBS 16
+
+// Neutral gray, opaque
+#define UPLOADQUEUE_PLACEHOLDER_COLOR RGB(127,127,127)
+
+
+RUploadQueue::RUploadQueue(size_t frameBudget){
+    this->jobs        = NULL;
+    this->jobCount    = 0;
+    this->jobCapacity = 0;
+    this->nextHandle  = 1;
+
+    this->frameBudget = frameBudget;
+
+    this->placeholder = new RTexture(1, 1, 4);
+    this->setPlaceholderColor(UPLOADQUEUE_PLACEHOLDER_COLOR);
+}
+
+RUploadQueue::~RUploadQueue(){
+    if(this->jobCount > 0){
+        Debug::warning("[%s:%d]: Dropping %u texture uploads not done yet\n", __FILE__, __LINE__, this->jobCount);
+    }
+
+    for(uint32_t i = 0; i < this->jobCount; i++){
+        delete this->jobs[i].pixmap;
+    }
+    if(this->jobs) rfree(this->jobs);
+    this->jobs     = NULL;
+    this->jobCount = 0;
+
+    delete this->placeholder;
+}
+
+rupload_t RUploadQueue::queue(RTexture* texture, int px, int py, Pixmap* pixmap, rupload_callback_t callback, void* userdata){
+    if(texture == NULL || !pixmap->exists()){
+        Debug::error("[%s:%d]: Nothing to upload!\n", __FILE__, __LINE__);
+        delete pixmap;
+        return 0;
+    }
+
+    if(this->jobCount == this->jobCapacity){
+        uint32_t      capacity = this->jobCapacity ? this->jobCapacity * 2 : UPLOADQUEUE_INITIAL_JOBS;
+        ruploadjob_t* jobs     = (ruploadjob_t*) rrealloc(this->jobs, capacity * sizeof(ruploadjob_t));
+        if(jobs == NULL){
+            Debug::error("[%s:%d]: Cannot grow the upload queue to %u uploads!\n", __FILE__, __LINE__, capacity);
+            delete pixmap;
+            return 0;
+        }
+        this->jobs        = jobs;
+        this->jobCapacity = capacity;
+    }
+
+    ruploadjob_t* job = &this->jobs[this->jobCount++];
+    job->handle   = this->nextHandle++;
+    job->texture  = texture;
+    job->px       = px;
+    job->py       = py;
+    job->pixmap   = pixmap;
+    job->rows     = 0;
+    job->callback = callback;
+    job->userdata = userdata;
+
+    // Never 0
+    if(this->nextHandle == 0) this->nextHandle = 1;
+    return job->handle;
+}
+
+RTexture* RUploadQueue::createTexture(const Pixmap& pixmap, rupload_callback_t callback, void* userdata, rupload_t* handle){
+    return this->createTexture(Pixmap(pixmap), callback, userdata, handle);
+}
+
+RTexture* RUploadQueue::createTexture(Pixmap&& pixmap, rupload_callback_t callback, void* userdata, rupload_t* handle){
+    if(handle) *handle = 0;
+    if(!pixmap.exists()){
+        Debug::error("[%s:%d]: Cannot create a texture from an empty pixmap!\n", __FILE__, __LINE__);
+        return NULL;
+    }
+
+    RTexture* texture = new RTexture(pixmap.getWidth(), pixmap.getHeight(), pixmap.getComponents());
+    rupload_t upload  = this->upload(texture, 0, 0, static_cast<Pixmap&&>(pixmap), callback, userdata);
+    if(upload == 0){
+        delete texture;
+        return NULL;
+    }
+
+    if(handle) *handle = upload;
+    return texture;
+}
+
+rupload_t RUploadQueue::upload(RTexture* texture, int px, int py, const Pixmap& pixmap, rupload_callback_t callback, void* userdata){
+    return this->queue(texture, px, py, new Pixmap(pixmap), callback, userdata);
+}
+
+rupload_t RUploadQueue::upload(RTexture* texture, int px, int py, Pixmap&& pixmap, rupload_callback_t callback, void* userdata){
+    return this->queue(texture, px, py, new Pixmap(static_cast<Pixmap&&>(pixmap)), callback, userdata);
+}
+
+void RUploadQueue::cancel(rupload_t upload){
+    for(uint32_t i = 0; i < this->jobCount; i++){
+        if(this->jobs[i].handle != upload) continue;
+
+        delete this->jobs[i].pixmap;
+        memmove(&this->jobs[i], &this->jobs[i + 1], (this->jobCount - i - 1) * sizeof(ruploadjob_t));
+        this->jobCount--;
+        return;
+    }
+}
+
+bool RUploadQueue::isPending(rupload_t upload) const {
+    for(uint32_t i = 0; i < this->jobCount; i++){
+        if(this->jobs[i].handle == upload) return true;
+    }
+    return false;
+}
+
+bool RUploadQueue::isPending(const RTexture* texture) const {
+    for(uint32_t i = 0; i < this->jobCount; i++){
+        if(this->jobs[i].texture == texture) return true;
+    }
+    return false;
+}
+
+const RTexture& RUploadQueue::ready(const RTexture& texture) const {
+    return this->isPending(&texture) ? *this->placeholder : texture;
+}
+
+const RTexture& RUploadQueue::getPlaceholder() const {
+    return *this->placeholder;
+}
+
+void RUploadQueue::setPlaceholderColor(color_t color){
+    uint8_t texel[4] = {(uint8_t) R(color), (uint8_t) G(color), (uint8_t) B(color), (uint8_t) A(color)};
+    this->placeholder->uploadPixels(0, 0, 1, 1, 4, texel);
+}
+
+size_t RUploadQueue::uploadRows(ruploadjob_t* job, size_t budget){
+    const Pixmap* pixmap = job->pixmap;
+
+    int    width    = pixmap->getWidth();
+    int    height   = pixmap->getHeight();
+    int    comp     = pixmap->getComponents();
+    size_t rowBytes = (size_t) width * comp;
+
+    // At least one row, so every upload ends even with a tiny budget
+    int rows = height - job->rows;
+    if(budget > 0 && (size_t) rows * rowBytes > budget){
+        rows = (int) (budget / rowBytes);
+        if(rows < 1) rows = 1;
+    }
+
+    // Read only view of the band, a shared pixmap is not copied
+    const uint8_t* band = (const uint8_t*) pixmap->getPixels() + (size_t) job->rows * rowBytes;
+    job->texture->uploadPixels(job->px, job->py + job->rows, PixmapView(band, width, rows, comp, (int) rowBytes));
+
+    job->rows += rows;
+    return (size_t) rows * rowBytes;
+}
+
+void RUploadQueue::finish(uint32_t index){
+    // Off the queue before the callback, it may queue or cancel uploads
+    ruploadjob_t job = this->jobs[index];
+    memmove(&this->jobs[index], &this->jobs[index + 1], (this->jobCount - index - 1) * sizeof(ruploadjob_t));
+    this->jobCount--;
+
+    delete job.pixmap;
+    if(job.callback) job.callback(job.handle, job.texture, job.userdata);
+}
+
+size_t RUploadQueue::process(){
+    size_t uploaded = 0;
+
+    // Oldest first, one texture finished before the next one starts
+    while(this->jobCount > 0){
+        size_t budget = 0;
+        if(this->frameBudget > 0){
+            if(uploaded >= this->frameBudget) break;
+            budget = this->frameBudget - uploaded;
+        }
+
+        ruploadjob_t* job = &this->jobs[0];
+        uploaded += this->uploadRows(job, budget);
+
+        if(job->rows >= job->pixmap->getHeight()) this->finish(0);
+    }
+
+    return uploaded;
+}
+
+size_t RUploadQueue::flush(){
+    size_t budget   = this->frameBudget;
+    this->frameBudget = 0;
+
+    size_t uploaded = this->process();
+    this->frameBudget = budget;
+    return uploaded;
+}
+
+void RUploadQueue::setFrameBudget(size_t bytes){
+    this->frameBudget = bytes;
+}
+
+size_t RUploadQueue::getFrameBudget() const {
+    return this->frameBudget;
+}
+
+uint32_t RUploadQueue::getPending() const {
+    return this->jobCount;
+}
+
+size_t RUploadQueue::getPendingBytes() const {
+    size_t bytes = 0;
+    for(uint32_t i = 0; i < this->jobCount; i++){
+        const Pixmap* pixmap = this->jobs[i].pixmap;
+        bytes += (size_t) (pixmap->getHeight() - this->jobs[i].rows) * pixmap->getWidth() * pixmap->getComponents();
+    }
+    return bytes;
+}
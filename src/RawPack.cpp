@@ -0,0 +1,432 @@
+/**
+ * @file RawPack.cpp
+ * @author Brais Solla González
+ * @brief Raw image pack loader, writer and LZ4 block codec for Enyx
+ * @version 0.1
+ * @date 2021-12-06
+ *
+ * @copyright Copyright (c) 2021
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RawPack.h"
+#include "ImageDriver.h"
+#include "ETC1.h"
+#include "Debug.h"
+
+// LZ4 block format limits
+#define LZ4_MIN_MATCH     4
+// Last match must start 12 bytes before the end, last 5 bytes are always literals
+#define LZ4_MF_LIMIT      12
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MAX_OFFSET    65535
+#define LZ4_HASH_BITS     12
+
+
+RawPack::RawPack(){
+    this->mapping.data   = NULL;
+    this->mapping.size   = 0;
+    this->mapping.mapped = false;
+    this->header  = NULL;
+    this->entries = NULL;
+}
+
+RawPack::RawPack(const char* fileName){
+    this->mapping.data   = NULL;
+    this->mapping.size   = 0;
+    this->mapping.mapped = false;
+    this->header  = NULL;
+    this->entries = NULL;
+
+    this->open(fileName);
+}
+
+RawPack::~RawPack(){
+    this->close();
+}
+
+int RawPack::open(const char* fileName){
+    this->close();
+
+    if(ImageDriver::mapFile(fileName, &this->mapping) != 0){
+        Debug::error("[%s:%d]: Cannot open raw pack %s!\n", __FILE__, __LINE__, fileName);
+        return 1;
+    }
+
+    const uint8_t* data = this->mapping.data;
+    uint64_t       size = this->mapping.size;
+
+    const rawpack_header_t* header = (const rawpack_header_t*) data;
+    if(size < sizeof(rawpack_header_t) || memcmp(header->magic, RAWPACK_MAGIC, 4) != 0 || header->version != RAWPACK_VERSION){
+        Debug::error("[%s:%d]: %s is not a raw pack (Or not version %d)!\n", __FILE__, __LINE__, fileName, RAWPACK_VERSION);
+        ImageDriver::unmapFile(&this->mapping);
+        return 2;
+    }
+
+    if(header->directory > size || (size - header->directory) / sizeof(rawpack_entry_t) < header->count || (header->directory % 8) != 0){
+        Debug::error("[%s:%d]: Raw pack %s has a broken directory!\n", __FILE__, __LINE__, fileName);
+        ImageDriver::unmapFile(&this->mapping);
+        return 3;
+    }
+
+    // Everything read later is checked here once
+    const rawpack_entry_t* entries = (const rawpack_entry_t*) (data + header->directory);
+    for(uint32_t i = 0; i < header->count; i++){
+        const rawpack_entry_t* entry = &entries[i];
+
+        bool valid = memchr(entry->name, 0, RAWPACK_NAME_SIZE) != NULL;
+        valid = valid && entry->width > 0 && entry->width <= 65536 && entry->height > 0 && entry->height <= 65536;
+        valid = valid && entry->components >= 1 && entry->components <= 4;
+        valid = valid && entry->mips >= 1 && entry->mips <= 32;
+        valid = valid && entry->offset <= size && entry->size <= size - entry->offset;
+        // ETC1 is RGB, alpha in a plane of level 0
+        if(entry->flags & RAWPACK_FLAG_ETC1){
+            valid = valid && (entry->components == 3 || (entry->components == 4 && entry->mips == 1));
+        }
+        if(valid){
+            uint64_t raw_size = RawPack::levelOffset(entry, entry->mips);
+            valid = (entry->raw_size == raw_size) && ((entry->flags & RAWPACK_FLAG_LZ4) || entry->size == raw_size);
+        }
+
+        if(!valid){
+            Debug::error("[%s:%d]: Raw pack %s: image %u is broken!\n", __FILE__, __LINE__, fileName, i);
+            ImageDriver::unmapFile(&this->mapping);
+            return 4;
+        }
+    }
+
+    this->header  = header;
+    this->entries = entries;
+
+    Debug::info("[%s:%d]: Opened raw pack %s (%u images, %lu bytes)\n", __FILE__, __LINE__, fileName, header->count, (unsigned long) size);
+    return 0;
+}
+
+void RawPack::close(){
+    if(this->mapping.data) ImageDriver::unmapFile(&this->mapping);
+    this->header  = NULL;
+    this->entries = NULL;
+}
+
+bool RawPack::isOpen() const {
+    return (this->header != NULL);
+}
+
+int RawPack::getCount() const {
+    return this->header ? (int) this->header->count : 0;
+}
+
+int RawPack::find(const char* name) const {
+    if(this->header == NULL || name == NULL) return -1;
+
+    for(uint32_t i = 0; i < this->header->count; i++){
+        if(strcmp(this->entries[i].name, name) == 0) return (int) i;
+    }
+    return -1;
+}
+
+const rawpack_entry_t* RawPack::getEntry(int index) const {
+    if(this->header == NULL || index < 0 || (uint32_t) index >= this->header->count) return NULL;
+    return &this->entries[index];
+}
+
+const uint8_t* RawPack::acquirePixels(int index) const {
+    const rawpack_entry_t* entry = this->getEntry(index);
+    if(entry == NULL) return NULL;
+
+    const uint8_t* data = this->mapping.data + entry->offset;
+    if(!(entry->flags & RAWPACK_FLAG_LZ4)) return data;
+
+    uint8_t* pixels = (uint8_t*) malloc(entry->raw_size);
+    if(pixels == NULL){
+        Debug::error("[%s:%d]: Cannot allocate memory to decompress %s (%lu bytes)!\n", __FILE__, __LINE__, entry->name, (unsigned long) entry->raw_size);
+        return NULL;
+    }
+
+    if(!RawPack::decompress(data, entry->size, pixels, entry->raw_size)){
+        Debug::error("[%s:%d]: Cannot decompress %s, the pack is broken!\n", __FILE__, __LINE__, entry->name);
+        free(pixels);
+        return NULL;
+    }
+    return pixels;
+}
+
+void RawPack::releasePixels(int index, const uint8_t* pixels) const {
+    const rawpack_entry_t* entry = this->getEntry(index);
+    if(entry == NULL || pixels == NULL) return;
+
+    // Uncompressed pixels belong to the mapping
+    if(entry->flags & RAWPACK_FLAG_LZ4) free((void*) pixels);
+}
+
+size_t RawPack::levelSize(const rawpack_entry_t* entry, int level){
+    size_t width  = entry->width  >> level;
+    size_t height = entry->height >> level;
+    if(width  == 0) width  = 1;
+    if(height == 0) height = 1;
+
+    if(entry->flags & RAWPACK_FLAG_ETC1) return ETC1::imageSize((int) width, (int) height, entry->components);
+    return width * height * entry->components;
+}
+
+size_t RawPack::levelOffset(const rawpack_entry_t* entry, int level){
+    size_t offset = 0;
+    for(int i = 0; i < level; i++) offset += RawPack::levelSize(entry, i);
+    return offset;
+}
+
+bool RawPack::setName(rawpack_entry_t* entry, const char* path){
+    // File name without folders
+    const char* name = path;
+    for(const char* p = path; *p; p++){
+        if(*p == '/' || *p == '\\') name = p + 1;
+    }
+
+    if(strlen(name) >= RAWPACK_NAME_SIZE){
+        Debug::error("[%s:%d]: Image name %s is too long (Max %d characters)!\n", __FILE__, __LINE__, name, RAWPACK_NAME_SIZE - 1);
+        return false;
+    }
+
+    memset(entry->name, 0, RAWPACK_NAME_SIZE);
+    strcpy(entry->name, name);
+    return true;
+}
+
+void RawPack::compressImage(rawpack_image_t* image){
+    rawpack_entry_t* entry = &image->entry;
+
+    size_t   capacity   = RawPack::compressBound(entry->size);
+    uint8_t* compressed = (uint8_t*) malloc(capacity);
+    size_t   size       = compressed ? RawPack::compress(image->data, entry->size, compressed, capacity) : 0;
+
+    if(size > 0 && size < entry->size){
+        free(image->data);
+        image->data   = compressed;
+        entry->size   = size;
+        entry->flags |= RAWPACK_FLAG_LZ4;
+    } else {
+        free(compressed);
+    }
+}
+
+static bool writePadding(FILE* file, uint64_t bytes){
+    static const uint8_t zeros[64] = {0};
+    while(bytes > 0){
+        size_t chunk = bytes > sizeof(zeros) ? sizeof(zeros) : (size_t) bytes;
+        if(fwrite(zeros, 1, chunk, file) != chunk) return false;
+        bytes -= chunk;
+    }
+    return true;
+}
+
+int RawPack::write(rawpack_image_t* images, int count, uint32_t alignment, FILE* file){
+    if(alignment < 8 || (alignment & (alignment - 1)) != 0){
+        Debug::error("[%s:%d]: Raw pack alignment must be a power of 2 (8 or more), not %u!\n", __FILE__, __LINE__, alignment);
+        return 1;
+    }
+
+    for(int i = 0; i < count; i++){
+        for(int j = 0; j < i; j++){
+            if(strcmp(images[j].entry.name, images[i].entry.name) == 0){
+                Debug::error("[%s:%d]: Two images named %s in a raw pack!\n", __FILE__, __LINE__, images[i].entry.name);
+                return 2;
+            }
+        }
+    }
+
+    // Header, directory, then the image data
+    rawpack_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RAWPACK_MAGIC, 4);
+    header.version   = RAWPACK_VERSION;
+    header.count     = count;
+    header.alignment = alignment;
+    header.directory = sizeof(rawpack_header_t);
+
+    uint64_t data   = header.directory + (uint64_t) count * sizeof(rawpack_entry_t);
+    uint64_t offset = data;
+    for(int i = 0; i < count; i++){
+        offset = (offset + alignment - 1) & ~((uint64_t) alignment - 1);
+        images[i].entry.offset = offset;
+        offset += images[i].entry.size;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for(int i = 0; i < count && ok; i++){
+        ok = fwrite(&images[i].entry, sizeof(rawpack_entry_t), 1, file) == 1;
+    }
+
+    uint64_t position = data;
+    for(int i = 0; i < count && ok; i++){
+        ok = writePadding(file, images[i].entry.offset - position);
+        ok = ok && fwrite(images[i].data, 1, images[i].entry.size, file) == images[i].entry.size;
+        position = images[i].entry.offset + images[i].entry.size;
+    }
+
+    if(!ok){
+        Debug::error("[%s:%d]: Cannot write raw pack!\n", __FILE__, __LINE__);
+        return 3;
+    }
+    return 0;
+}
+
+
+// LZ4 block codec (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md). Greedy, one hash table
+static inline uint32_t read32(const uint8_t* p){
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t lz4_hash(uint32_t sequence){
+    return (sequence * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+// Length bytes after a token nibble of 15
+static inline uint8_t* lz4_put_length(uint8_t* op, size_t length){
+    while(length >= 255){
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t) length;
+    return op;
+}
+
+size_t RawPack::compressBound(size_t size){
+    return size + (size / 255) + 16;
+}
+
+size_t RawPack::compress(const void* src, size_t size, void* dest, size_t capacity){
+    const uint8_t* in  = (const uint8_t*) src;
+    uint8_t*       op  = (uint8_t*) dest;
+    uint8_t*       end = op + capacity;
+
+    // Positions are 32 bit
+    if(size >= UINT32_MAX) return 0;
+
+    // Position + 1 of the last sequence with a hash (0 = empty)
+    uint32_t* table = (uint32_t*) calloc(1 << LZ4_HASH_BITS, sizeof(uint32_t));
+    if(table == NULL) return 0;
+
+    size_t ip     = 0;
+    size_t anchor = 0;
+
+    if(size > LZ4_MF_LIMIT){
+        size_t match_start_limit = size - LZ4_MF_LIMIT;
+        size_t match_end_limit   = size - LZ4_LAST_LITERALS;
+
+        while(ip < match_start_limit){
+            uint32_t sequence = read32(in + ip);
+            uint32_t hash     = lz4_hash(sequence);
+            size_t   ref      = table[hash];
+            table[hash] = (uint32_t) (ip + 1);
+
+            if(ref == 0 || ip - (ref - 1) > LZ4_MAX_OFFSET || read32(in + ref - 1) != sequence){
+                ip++;
+                continue;
+            }
+            ref--;
+
+            size_t length = LZ4_MIN_MATCH;
+            while(ip + length < match_end_limit && in[ref + length] == in[ip + length]) length++;
+
+            // Token, literals, offset, match length
+            size_t literals = ip - anchor;
+            if((size_t) (end - op) < 1 + literals + (literals / 255) + 1 + 2 + ((length - LZ4_MIN_MATCH) / 255) + 1){
+                free(table);
+                return 0;
+            }
+
+            uint8_t* token = op++;
+            *token = (uint8_t) ((literals >= 15 ? 15 : literals) << 4);
+            if(literals >= 15) op = lz4_put_length(op, literals - 15);
+            memcpy(op, in + anchor, literals);
+            op += literals;
+
+            uint16_t offset = (uint16_t) (ip - ref);
+            *op++ = (uint8_t) (offset & 0xff);
+            *op++ = (uint8_t) (offset >> 8);
+
+            size_t match = length - LZ4_MIN_MATCH;
+            *token |= (uint8_t) (match >= 15 ? 15 : match);
+            if(match >= 15) op = lz4_put_length(op, match - 15);
+
+            ip    += length;
+            anchor = ip;
+        }
+    }
+    free(table);
+
+    // Last literals
+    size_t literals = size - anchor;
+    if((size_t) (end - op) < 1 + literals + (literals / 255) + 1) return 0;
+
+    *op++ = (uint8_t) ((literals >= 15 ? 15 : literals) << 4);
+    if(literals >= 15) op = lz4_put_length(op, literals - 15);
+    memcpy(op, in + anchor, literals);
+    op += literals;
+
+    return (size_t) (op - (uint8_t*) dest);
+}
+
+bool RawPack::decompress(const void* src, size_t src_size, void* dest, size_t size){
+    const uint8_t* ip     = (const uint8_t*) src;
+    const uint8_t* ip_end = ip + src_size;
+    uint8_t*       op     = (uint8_t*) dest;
+    uint8_t*       op_end = op + size;
+
+    while(ip < ip_end){
+        uint8_t token = *ip++;
+
+        // Literals
+        size_t literals = token >> 4;
+        if(literals == 15){
+            uint8_t b;
+            do {
+                if(ip >= ip_end) return false;
+                b = *ip++;
+                literals += b;
+            } while(b == 255);
+        }
+        if(literals > (size_t) (ip_end - ip) || literals > (size_t) (op_end - op)) return false;
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        // The last sequence has no match
+        if(ip == ip_end) break;
+
+        if(ip_end - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if(offset == 0 || offset > (size_t) (op - (uint8_t*) dest)) return false;
+
+        size_t length = token & 0x0f;
+        if(length == 15){
+            uint8_t b;
+            do {
+                if(ip >= ip_end) return false;
+                b = *ip++;
+                length += b;
+            } while(b == 255);
+        }
+        length += LZ4_MIN_MATCH;
+        if(length > (size_t) (op_end - op)) return false;
+
+        // May overlap (Repeated pattern), byte by byte
+        const uint8_t* match = op - offset;
+        if(offset >= length){
+            memcpy(op, match, length);
+            op += length;
+        } else {
+            for(size_t i = 0; i < length; i++) *op++ = *match++;
+        }
+    }
+
+    return op == op_end;
+}
@@ -72,13 +72,13 @@ int main(){
     Pixmap test = Pixmap::loadImage("pixmaptest.png");
     printf("Resolution!\n");
     printf("%dx%dx%d\n", test.getWidth(), test.getHeight(), test.getComponents());
-    for(int y = 0; y < test.getHeight(); y++){
-        for(int x = 0; x < test.getWidth(); x++){
-            color_t px = test.getPixel(x,y);
-            px = (px ^ 0xffffff00) | 0xff;
-            test.setPixel(x,y, px);
-        }
-    }
+    test.convert(4);
+    test.forEach<RGBA8>([](RGBA8& px){
+        px.r ^= 0xff;
+        px.g ^= 0xff;
+        px.b ^= 0xff;
+        px.a  = 0xff;
+    });
 
     printf("Saving...\n");
     Pixmap::saveImage("pixmapout.jpg", test);
@@ -19,10 +19,10 @@
 typedef uint16_t color_t;
 typedef uint32_t rgba_t;
 
-#define R(x) ((color >> 10) & 0x1f)
-#define G(x) ((color >> 5)  & 0x1f)
-#define B(x) ((color >> 0)  & 0x1f)
-#define A(x) ((color >> 15) & 0x01)
+#define R(x) (((x) >> 10) & 0x1f)
+#define G(x) (((x) >> 5)  & 0x1f)
+#define B(x) (((x) >> 0)  & 0x1f)
+#define A(x) (((x) >> 15) & 0x01)
 
 // 8 bit RGB to system color
 #define RGB(r,g,b)      
@@ -31,13 +31,13 @@ typedef uint32_t rgba_t;
 typedef uint32_t color_t;
 typedef uint32_t rgba_t;
 
-#define R(x) ((color >> 24) & 0xff)
-#define G(x) ((color >> 16) & 0xff)
-#define B(x) ((color >> 8)  & 0xff)
-#define A(x) ((color >> 0)  & 0xff)
+#define R(x) (((x) >> 24) & 0xff)
+#define G(x) (((x) >> 16) & 0xff)
+#define B(x) (((x) >> 8)  & 0xff)
+#define A(x) (((x) >> 0)  & 0xff)
 
-#define RGB(r,g,b)     (((r & 0xff) << 24) | ((g & 0xff) << 16) | ((b & 0xff) << 8) | 0xff)
-#define RGBA(r,g,b,a)  (((r & 0xff) << 24) | ((g & 0xff) << 16) | ((b & 0xff) << 8) | (a & 0xff))
+#define RGB(r,g,b)     ((((r) & 0xff) << 24) | (((g) & 0xff) << 16) | (((b) & 0xff) << 8) | 0xff)
+#define RGBA(r,g,b,a)  ((((r) & 0xff) << 24) | (((g) & 0xff) << 16) | (((b) & 0xff) << 8) | ((a) & 0xff))
 #endif
 
 // Some colors
@@ -114,9 +114,9 @@ class AGL {
         virtual void drawCircle(int x, int y, int r, color_t color) = 0;
         virtual void drawFillCircle(int x, int y, int r, color_t color) = 0;
 
-        // Not for now boy, not for now. (Maybe next AGL revision?)
-        //virtual void drawRoundRect(int x, int y, int w, int h, int r, color_t color) = 0;
-        //virtual void drawFillRoundRect(int x, int y, int w, int h, int r, color_t color) = 0;
+        // Renderers without round rects draw square corners
+        virtual void drawRoundRect(int x, int y, int w, int h, int, color_t color){ this->drawRect(x, y, w, h, color); }
+        virtual void drawFillRoundRect(int x, int y, int w, int h, int, color_t color){ this->drawFillRect(x, y, w, h, color); }
 
         virtual void drawTriangle(int x0, int y0, int x1, int y1, int x2, int y2, color_t color) = 0;
         virtual void drawFillTriangle(int x0, int y0, int x1, int y1, int x2, int y2, color_t color) = 0;
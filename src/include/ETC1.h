@@ -0,0 +1,57 @@
+/**
+ * @file ETC1.h
+ * @author Brais Solla González
+ * @brief ETC1 texture compression (Encoder and CPU decoder) for Enyx
+ * @version 0.1
+ * @date 2021-12-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * ETC1 (OES_compressed_ETC1_RGB8_texture) stores 4x4 RGB texels in 8 bytes, 6x smaller than RGB and
+ * 8x smaller than RGBA in GPU memory. It has no alpha, so images with alpha get an alpha plane:
+ * the image is encoded twice height, color on top and alpha (Gray) in the bottom half:
+ *   rows [0, planeHeight)                  Color, last rows repeated
+ *   rows [planeHeight, 2 * planeHeight)    Alpha, last rows repeated
+ * Alpha is sampled 0.5 below the color in texture space. Both planes have guard rows (The last
+ * block row of the color plane repeats the first alpha row), so bilinear filtering never mixes the planes.
+ * Images are encoded by tools/Image2ETC1, decoded on the CPU when the GPU cannot sample ETC1.
+ */
+
+#ifndef _ETC1_INCLUDED
+#define _ETC1_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Bytes of a 4x4 block
+#define ETC1_BLOCK_SIZE 8
+
+enum ETC1_QUALITY {
+    // Base colors from the texel average
+    ETC1_QUALITY_FAST = 0,
+    // Every rounding of the average tried (Around 8x slower)
+    ETC1_QUALITY_HIGH = 1
+};
+
+namespace ETC1 {
+    // Bytes of width x height RGB texels
+    size_t encodedSize(int width, int height);
+    // Rows of each plane of an image with alpha plane (Multiple of 4, with the guard rows)
+    int    planeHeight(int height);
+    // Components of the decoded image: 3, or 4 with an alpha plane (1 and 2 component images are gray)
+    int    storedComponents(int components);
+    // Bytes of an encoded image of 1 to 4 components (Alpha plane included)
+    size_t imageSize(int width, int height, int components);
+
+    // rgb: 4x4 texels, row by row (48 bytes). block: 8 bytes
+    void encodeBlock(const uint8_t* rgb, uint8_t* block, int quality);
+    void decodeBlock(const uint8_t* block, uint8_t* rgb);
+
+    // Encode an image of 1 to 4 components (Rows stride bytes apart, 0 = tightly packed)
+    // to imageSize() bytes. false if there is not enough memory
+    bool encode(const uint8_t* pixels, int width, int height, int components, int stride, uint8_t* dest, int quality);
+    // Decode an image of storedComponents() components to width * height * components bytes
+    void decode(const uint8_t* data, int width, int height, int components, uint8_t* pixels);
+};
+
+#endif
@@ -12,6 +12,8 @@
 #include "AGL.h"
 #include "Pixmap.h"
 #include "ImageDriver.h"
+#include "ImageLoader.h"
+#include "ImageWriter.h"
 #include "Platform_SDL2.h"
 // #include "Renderer_SDL2_GLES2.h"
 
@@ -15,25 +15,97 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 
 typedef void (*progress_callback_t)(float);
+// Progress of one resize (0 to 1), called on the thread that asked for it
+typedef void (*resize_progress_t)(float progress, void* userdata);
+// Receives the encoded bytes of an image, in order (stbi_write_func)
+typedef void (*imagewrite_func_t)(void* context, void* data, int size);
+
+// Encoded image formats
+enum IMAGE_FORMAT {
+    IMAGE_FORMAT_UNKNOWN = 0,
+    IMAGE_FORMAT_PNG     = 1,
+    IMAGE_FORMAT_JPG     = 2,
+    IMAGE_FORMAT_BMP     = 3,
+    IMAGE_FORMAT_TGA     = 4
+};
+
+// Read only view of a whole file. Memory mapped where the platform allows it, read to memory otherwise
+struct imagemapping_t {
+    const uint8_t* data;
+    size_t         size;
+    // data is a mapping (munmap) or a malloc'd copy (free)
+    bool           mapped;
+};
+
+enum IMAGE_RESIZE_FLAGS {
+    // Colour channels are sRGB, filtered in linear space
+    IMAGE_RESIZE_SRGB          = (1 << 0),
+    // Colour is already multiplied by alpha (Not weighted again)
+    IMAGE_RESIZE_PREMULTIPLIED = (1 << 1)
+};
+
+// Resize request, see ImageDriver::resizeOptions() for the defaults
+struct imageresize_t {
+    // IMAGE_RESIZE_FLAGS
+    int   flags;
+    // Channel holding alpha, -1 = none. Colour is weighted by alpha when filtering
+    int   alpha_channel;
+    // Threads used, each resizes a band of rows (0 = one per CPU, 1 = only the caller)
+    int   threads;
+    resize_progress_t progress;
+    void* userdata;
+};
+
 namespace ImageDriver {
-    static progress_callback_t callback_fnc = NULL;
+    // SIMD code path of the image decoder ("SSE2", "NEON" or "Scalar")
+    const char* getDecoderSIMD();
 
     int      infoImage (const char* fileName, int* sx, int* sy, int* n);
     uint8_t* loadImage (const char* fileName, int* sx, int* sy, int* n);
     float*   loadImageF(const char* fileName, int* sx, int* sy, int* n);
-    // TODO: Load from memory
+
+    // Decode an encoded image (PNG, JPG, BMP...) already in memory, like a file inside a pack
+    int      infoImageFromMemory(const void* data, size_t size, int* sx, int* sy, int* n);
+    uint8_t* loadImageFromMemory(const void* data, size_t size, int* sx, int* sy, int* n);
+
+    // Map a file read only. 0 on success, the mapping is released with unmapFile
+    int      mapFile  (const char* fileName, imagemapping_t* mapping);
+    void     unmapFile(imagemapping_t* mapping);
+    // Decode straight from a mapping of the file (No stdio reads)
+    uint8_t* loadImageMapped(const char* fileName, int* sx, int* sy, int* n);
 
     void     freeImage(void* image_ptr);
 
+    // IMAGE_FORMAT of a file name, from its extension (Case insensitive)
+    int      getImageFormat(const char* fileName);
+
     // STBI_write
     int      writeImage(const char* fileName, int w, int h, int n, void* data);
     // JPG ONLY!
     int      writeImage(const char* fileName, int w, int h, int n, void* data, int q);
+    // Encode to a function instead of a file (Tightly packed rows). q is the JPG quality. 0 on success
+    int      writeImageToFunc(imagewrite_func_t func, void* context, int format, int w, int h, int n, const void* data, int q);
 
+    // Progress of the resizes started by the calling thread (Per thread)
     void     resizingCallback(progress_callback_t callback);
     int      resizeImage(void* input, int in_w, int in_h, void* output, int out_w, int out_h, int n);
+    // Row strides in bytes (0 = tightly packed rows). Works on PixmapView regions
+    int      resizeImage(const void* input, int in_w, int in_h, int in_stride, void* output, int out_w, int out_h, int out_stride, int n);
+
+    // Default request for n components: alpha channel of RGBA / grey + alpha, linear colour, one thread per CPU
+    imageresize_t resizeOptions(int n);
+    // Band parallel resize. options NULL = resizeOptions(n)
+    int      resizeImage(const void* input, int in_w, int in_h, int in_stride, void* output, int out_w, int out_h, int out_stride, int n, const imageresize_t* options);
+
+    // Mip levels of a w x h image down to 1x1, and the offset of a level in a mip chain
+    int      getMipLevels(int w, int h);
+    size_t   getMipOffset(int w, int h, int n, int level);
+    // Every mip level, level 0 (A copy of input) first, tightly packed rows. Each level is resized from the one
+    // before. Freed with freeImage(). levels gets the level count
+    uint8_t* buildMipChain(const void* input, int w, int h, int n, int* levels, const imageresize_t* options);
 };
 
 
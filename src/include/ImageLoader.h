@@ -0,0 +1,67 @@
+/**
+ * @file ImageLoader.h
+ * @author Brais Solla González
+ * @brief Asynchronous image loading (Worker pool) for Enyx
+ * @version 0.1
+ * @date 2021-12-05
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Images are decoded by a pool of worker threads (One per CPU by default).
+ * load() returns a handle right away. The pixmap is collected later with take() / wait(),
+ * or given to a callback from dispatch(), called once per frame on the render thread
+ * so the callback can upload the image to the GPU.
+ */
+
+#ifndef _IMAGELOADER_INCLUDED
+#define _IMAGELOADER_INCLUDED
+
+#include <stdint.h>
+#include "Pixmap.h"
+
+// Max worker threads
+#define IMAGELOADER_MAX_WORKERS 16
+
+// Handle of a load request. 0 is never a valid handle
+typedef uint32_t imagehandle_t;
+
+// Called from dispatch() (Render thread). pixmap is empty if the image could not be loaded, move it to keep it
+typedef void (*imageloader_callback_t)(imagehandle_t handle, Pixmap& pixmap, void* userdata);
+
+enum IMAGELOADER_STATE {
+    IMAGELOADER_INVALID = 0, // Unknown, taken or cancelled handle
+    IMAGELOADER_QUEUED  = 1,
+    IMAGELOADER_LOADING = 2,
+    IMAGELOADER_DONE    = 3,
+    IMAGELOADER_FAILED  = 4
+};
+
+namespace ImageLoader {
+    // Start the worker pool. workers 0 = System::getCPUCount(). Without workers images are loaded in load()
+    int  init(int workers);
+    // Stop the workers (The images being decoded are finished first) and free everything not taken
+    void destroy();
+
+    imagehandle_t load(const char* fileName);
+    // callback is called by dispatch() when the image is ready. The image is released after the callback
+    imagehandle_t load(const char* fileName, imageloader_callback_t callback, void* userdata);
+
+    int  getState(imagehandle_t handle);
+    bool isReady (imagehandle_t handle);
+
+    // Get the image (Empty pixmap if not ready or failed). Releases the handle unless the image is still loading
+    Pixmap take(imagehandle_t handle);
+    // Block until the image is loaded, then take() it
+    Pixmap wait(imagehandle_t handle);
+    // Forget a request. Queued images are never decoded
+    void   cancel(imagehandle_t handle);
+
+    // Render thread: call the callbacks of up to max finished images (0 = all). Returns the callbacks called
+    int  dispatch(int max);
+
+    // Images queued or being decoded
+    int  getPending();
+    int  getWorkers();
+};
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @file ImageWriter.h
+ * @author Brais Solla González
+ * @brief Background image encoding (Screenshots, frame dumps) for Enyx
+ * @version 0.1
+ * @date 2021-12-07
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Images are encoded and written to disk by an encoder thread, so saving a large
+ * framebuffer does not stall the render loop. The pixels are given as:
+ *   - A pixmap, moved to the writer (Nothing copied) or copied / shared
+ *   - Chunks of rows (begin() + writeRows()), i.e. framebuffer readbacks over several frames
+ *   - A row callback called on the encoder thread
+ * stbi_write_* encodes from a whole image in memory, so every way of giving the pixels ends in
+ * one full-size buffer. Row callbacks and writeRows() only move that copy off the render thread.
+ * The format is taken from the file name once, when the image is queued.
+ */
+
+#ifndef _IMAGEWRITER_INCLUDED
+#define _IMAGEWRITER_INCLUDED
+
+#include <stdint.h>
+#include "Pixmap.h"
+
+// JPG quality when none is given (0)
+#define IMAGEWRITER_DEFAULT_QUALITY 100
+
+// Handle of a write request. 0 is never a valid handle
+typedef uint32_t imagewrite_t;
+
+// Fill row y (width * components bytes) of the image. Called on the encoder thread, top to bottom,
+// into a buffer of the whole image (Allocated by the encoder). false cancels the write
+typedef bool (*imagewriter_row_t)(int y, uint8_t* row, void* userdata);
+
+enum IMAGEWRITER_STATE {
+    IMAGEWRITER_INVALID = 0, // Unknown, cancelled or forgotten handle
+    IMAGEWRITER_FILLING = 1, // Waiting for writeRows()
+    IMAGEWRITER_QUEUED  = 2,
+    IMAGEWRITER_WRITING = 3,
+    IMAGEWRITER_DONE    = 4,
+    IMAGEWRITER_FAILED  = 5
+};
+
+enum IMAGEWRITER_FLAGS {
+    // Rows are given bottom to top (glReadPixels)
+    IMAGEWRITER_FLIP_Y = (1 << 0)
+};
+
+namespace ImageWriter {
+    // Start the encoder thread. Without it images are written when queued
+    int  init();
+    // Write everything queued, then stop the thread. Images still waiting for rows are dropped
+    void destroy();
+
+    // quality: JPG quality 1-100, 0 = IMAGEWRITER_DEFAULT_QUALITY. Returns 0 on error
+    imagewrite_t save(const char* fileName, Pixmap&& pixmap, int quality);
+    // The pixmap is copied (Shared if it is in shared mode)
+    imagewrite_t save(const char* fileName, const Pixmap& pixmap, int quality);
+    imagewrite_t save(const char* fileName, int width, int height, int components, imagewriter_row_t callback, void* userdata, int quality);
+
+    // Image given in chunks of rows, top to bottom (Or bottom to top with IMAGEWRITER_FLIP_Y).
+    // It is queued when the last row arrives. A handle is filled from one thread
+    imagewrite_t begin(const char* fileName, int width, int height, int components, int flags, int quality);
+    // stride in bytes (0 = tightly packed rows). Returns the rows still missing, -1 on error
+    int  writeRows(imagewrite_t handle, const void* pixels, int rows, int stride);
+
+    int  getState(imagewrite_t handle);
+    // Block until the image is written. true if it was written. Results are kept until
+    // the handle slot is reused, so wait soon after saving
+    bool wait(imagewrite_t handle);
+    // Drop an image not written yet
+    void cancel(imagewrite_t handle);
+    // Block until every queued image is written
+    void flush();
+
+    // Images queued or being written
+    int  getPending();
+};
+
+#endif
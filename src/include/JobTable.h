@@ -0,0 +1,133 @@
+/**
+ * @file JobTable.h
+ * @author Brais Solla González
+ * @brief Job table with generation handles and handle FIFO (ImageLoader / ImageWriter internals)
+ * @version 0.1
+ * @date 2021-12-07
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Internal header, not part of Enyx.h. Jobs are plain structs kept in a growing array,
+ * with a uint16_t generation member (0 = free slot). A handle is (generation << 16) | (slot + 1),
+ * so the handle of a freed or reused slot is not valid anymore. Nothing here locks,
+ * the owner calls everything with its own mutex locked.
+ */
+
+#ifndef _JOBTABLE_INCLUDED
+#define _JOBTABLE_INCLUDED
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Initial size of job tables and FIFOs (Grown when needed)
+#define JOBTABLE_INITIAL_JOBS 64
+// Slots fit in the low 16 bits of a handle
+#define JOBTABLE_MAX_JOBS     65535
+
+// 0 is never a valid handle
+typedef uint32_t jobhandle_t;
+
+template<typename Job>
+struct JobTable {
+    Job*     jobs;
+    int      size;
+    uint16_t generation;
+
+    // Job of a handle, NULL if the handle is not valid anymore
+    inline Job* get(jobhandle_t handle) const {
+        int      slot       = (int) (handle & 0xffff) - 1;
+        uint16_t generation = (uint16_t) (handle >> 16);
+
+        if(slot < 0 || slot >= this->size || generation == 0) return NULL;
+        if(this->jobs[slot].generation != generation) return NULL;
+        return &this->jobs[slot];
+    }
+
+    // First free slot, -1 if every slot is used
+    inline int findFree() const {
+        for(int i = 0; i < this->size; i++){
+            if(this->jobs[i].generation == 0) return i;
+        }
+        return -1;
+    }
+
+    // Grow the table (New slots zeroed). Returns the first new slot, -1 if full or out of memory
+    inline int grow(){
+        if(this->size >= JOBTABLE_MAX_JOBS) return -1;
+
+        int size = this->size ? this->size * 2 : JOBTABLE_INITIAL_JOBS;
+        if(size > JOBTABLE_MAX_JOBS) size = JOBTABLE_MAX_JOBS;
+
+        Job* jobs = (Job*) realloc(this->jobs, size * sizeof(Job));
+        if(jobs == NULL) return -1;
+        memset(jobs + this->size, 0, (size - this->size) * sizeof(Job));
+
+        int slot   = this->size;
+        this->jobs = jobs;
+        this->size = size;
+        return slot;
+    }
+
+    // Give a free slot a new generation. The caller fills the rest of the job
+    inline jobhandle_t claim(int slot){
+        // Skip 0, free slots
+        if(++this->generation == 0) this->generation = 1;
+
+        this->jobs[slot].generation = this->generation;
+        return ((jobhandle_t) this->generation << 16) | (jobhandle_t) (slot + 1);
+    }
+
+    // Free the array. Jobs must have been released by the owner first
+    inline void release(){
+        ::free(this->jobs);
+        this->jobs = NULL;
+        this->size = 0;
+    }
+};
+
+// Ring FIFO of handles
+struct JobFifo {
+    jobhandle_t* handles;
+    int head, count, size;
+
+    inline bool push(jobhandle_t handle){
+        if(this->count == this->size){
+            int size = this->size ? this->size * 2 : JOBTABLE_INITIAL_JOBS;
+            jobhandle_t* handles = (jobhandle_t*) malloc(size * sizeof(jobhandle_t));
+            if(handles == NULL) return false;
+
+            // Unwrap the ring
+            for(int i = 0; i < this->count; i++) handles[i] = this->handles[(this->head + i) % this->size];
+            ::free(this->handles);
+
+            this->handles = handles;
+            this->head    = 0;
+            this->size    = size;
+        }
+
+        this->handles[(this->head + this->count) % this->size] = handle;
+        this->count++;
+        return true;
+    }
+
+    // 0 if empty
+    inline jobhandle_t pop(){
+        if(this->count == 0) return 0;
+
+        jobhandle_t handle = this->handles[this->head];
+        this->head = (this->head + 1) % this->size;
+        this->count--;
+        return handle;
+    }
+
+    inline void release(){
+        ::free(this->handles);
+        this->handles = NULL;
+        this->head    = 0;
+        this->count   = 0;
+        this->size    = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file PixelFormat.h
+ * @author Brais Solla González
+ * @brief Compile time pixel formats and typed pixel spans for Enyx
+ * @version 0.1
+ * @date 2021-12-05
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * getPixel / setPixel switch on the components and go through color_t for every pixel.
+ * A PixelSpan<Format> knows the layout at compile time, so loops over it are plain loads and stores:
+ *
+ *   pixmap.forEach<RGBA8>([](RGBA8& px){ px.r = 255 - px.r; });
+ *
+ * The format is checked once per span (Pixmap::span / PixmapView::span), never per pixel.
+ */
+
+#ifndef _PIXELFORMAT_INCLUDED
+#define _PIXELFORMAT_INCLUDED
+#include <stdint.h>
+#include <stddef.h>
+#include "AGL.h"
+
+// 8 bit per component pixels, stb_image byte order. sizeof(Format) == Format::components
+struct Grey8 {
+    enum { components = 1 };
+    uint8_t g;
+
+    inline color_t toColor() const { return RGB(g, 0, 0); }
+    static inline Grey8 fromColor(color_t color){ Grey8 px = {(uint8_t) R(color)}; return px; }
+};
+
+struct GreyAlpha8 {
+    enum { components = 2 };
+    uint8_t g, a;
+
+    inline color_t toColor() const { return RGB(g, a, 0); }
+    static inline GreyAlpha8 fromColor(color_t color){ GreyAlpha8 px = {(uint8_t) R(color), (uint8_t) G(color)}; return px; }
+};
+
+struct RGB8 {
+    enum { components = 3 };
+    uint8_t r, g, b;
+
+    inline color_t toColor() const { return RGB(r, g, b); }
+    static inline RGB8 fromColor(color_t color){ RGB8 px = {(uint8_t) R(color), (uint8_t) G(color), (uint8_t) B(color)}; return px; }
+};
+
+struct RGBA8 {
+    enum { components = 4 };
+    uint8_t r, g, b, a;
+
+    inline color_t toColor() const { return RGBA(r, g, b, a); }
+    static inline RGBA8 fromColor(color_t color){ RGBA8 px = {(uint8_t) R(color), (uint8_t) G(color), (uint8_t) B(color), (uint8_t) A(color)}; return px; }
+};
+
+// Pixels are read in place, no padding allowed
+static_assert(sizeof(Grey8)      == 1, "Grey8 must be 1 byte");
+static_assert(sizeof(GreyAlpha8) == 2, "GreyAlpha8 must be 2 bytes");
+static_assert(sizeof(RGB8)       == 3, "RGB8 must be 3 bytes");
+static_assert(sizeof(RGBA8)      == 4, "RGBA8 must be 4 bytes");
+
+
+// Typed rectangle of pixels with a row stride. Format can be const (Read only span).
+// Like PixmapView it borrows the pixels, and is valid as long as its storage is
+template<typename Format>
+class PixelSpan {
+    private:
+        uint8_t* px;
+        int width, height;
+        // Bytes between the start of two rows
+        int stride;
+    public:
+        PixelSpan(){
+            this->px     = NULL;
+            this->width  = 0;
+            this->height = 0;
+            this->stride = 0;
+        }
+
+        // stride 0 = tightly packed rows
+        PixelSpan(Format* px, int width, int height, int stride){
+            this->px     = (uint8_t*) px;
+            this->width  = width;
+            this->height = height;
+            this->stride = stride ? stride : (width * (int) sizeof(Format));
+        }
+
+        inline bool exists() const { return this->px != NULL; }
+        inline bool onImage(int px, int py) const { return px >= 0 && px < this->width && py >= 0 && py < this->height; }
+
+        // No bounds checks, use onImage first
+        inline Format* getRow(int py)      const { return (Format*) (this->px + ((size_t) this->stride * py)); }
+        inline Format& at(int px, int py)  const { return this->getRow(py)[px]; }
+
+        // fn(Format& px) for every pixel, row by row. Tightly packed spans run one loop
+        template<typename Function>
+        inline void forEach(Function fn) const {
+            if(this->px == NULL) return;
+
+            if(this->stride == this->width * (int) sizeof(Format)){
+                Format* pixels = (Format*) this->px;
+                size_t  count  = (size_t) this->width * this->height;
+                for(size_t i = 0; i < count; i++) fn(pixels[i]);
+                return;
+            }
+
+            for(int y = 0; y < this->height; y++){
+                Format* row = this->getRow(y);
+                for(int x = 0; x < this->width; x++) fn(row[x]);
+            }
+        }
+
+        // fn(Format& px, int x, int y) for every pixel
+        template<typename Function>
+        inline void forEachXY(Function fn) const {
+            if(this->px == NULL) return;
+
+            for(int y = 0; y < this->height; y++){
+                Format* row = this->getRow(y);
+                for(int x = 0; x < this->width; x++) fn(row[x], x, y);
+            }
+        }
+
+        inline int getWidth()  const { return this->width;  }
+        inline int getHeight() const { return this->height; }
+        inline int getStride() const { return this->stride; }
+};
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * @file PixelOps.h
+ * @author Brais Solla González
+ * @brief Bulk pixel operations (SIMD kernels) for Enyx
+ * @version 0.1
+ * @date 2021-12-04
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ * Row kernels used by Pixmap and PixmapView. Pixels are 8 bit per component,
+ * stb_image layouts: 1 grey, 2 grey + alpha, 3 RGB, 4 RGBA.
+ * Every SIMD path has a scalar fallback (See SIMD.h)
+ */
+
+#ifndef _PIXELOPS_INCLUDED
+#define _PIXELOPS_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace PixelOps {
+    // Fill count pixels with pixel (components bytes)
+    void fill(void* dest, const uint8_t* pixel, int components, size_t count);
+
+    // Swap the contents of two rows (Not overlapping)
+    void swapRows(void* a, void* b, size_t bytes);
+
+    // Reverse the order of count pixels, in place
+    void mirrorRow(void* row, int components, size_t count);
+
+    // Alpha blend count RGBA pixels over dest (RGB or RGBA). Not premultiplied, like glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+    void blendRow(void* dest, int dest_components, const void* src, size_t count);
+
+    // Convert count pixels between layouts. Grey is the luma of RGB, missing alpha is 255
+    void convertRow(void* dest, int dest_components, const void* src, int src_components, size_t count);
+};
+
+#endif
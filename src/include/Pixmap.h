@@ -13,7 +13,9 @@
 #define _PIXMAP_INCLUDED
 #include <stdint.h>
 #include "AGL.h"
+#include "PixmapView.h"
 
+class RawPack;
 
 enum PIXMAP_LOADER {
     PIXMAP_LOADER_NONE        = 0,
@@ -21,10 +23,28 @@ enum PIXMAP_LOADER {
     PIXMAP_LOADER_IMAGEDRIVER = 2
 };
 
+// Reference counted pixel storage. Shared by Pixmap copies, copied on write
+struct pixmap_shared_t {
+    uint8_t* px;
+    // Loader of px (PIXMAP_LOADER)
+    int      loader;
+    // Pixmaps using this storage (Atomic)
+    int      references;
+};
+
 class Pixmap {
     private:
         uint8_t* px;
         int width, height, components, loader;
+        // Shared storage (NULL, this pixmap owns px)
+        pixmap_shared_t* shared;
+
+        // Copy the pixels of a shared storage before writing them. The copy stays shared
+        bool unshare();
+        // Take the contents of other, leaving it empty
+        void take(Pixmap& other);
+        // Deep copy or share the contents of other
+        void copy(const Pixmap& other);
     public:
         Pixmap();
         // Constructor for static array! Do not use
@@ -32,16 +52,33 @@ class Pixmap {
         // Load from image (ImageDriver)
         Pixmap(const char* fileName);
         Pixmap(const Pixmap& other);
+        // Move constructor, pixels are not copied
+        Pixmap(Pixmap&& other);
         ~Pixmap();
 
+        Pixmap& operator=(const Pixmap& other);
+        Pixmap& operator=(Pixmap&& other);
+
         bool onImage(int px, int py) const;
         bool isModifiable()          const;
         
         bool exists() const;
 
+        // Shared storage mode. Copies share the pixels until one of them is modified,
+        // the modified one gets its own shared storage (Shared mode is kept)
+        void share();
+        bool isShared() const;
+        // Pixmaps using the pixels of this one (1 if not shared)
+        int  getReferences() const;
+
         // Get pixel array
         void* getPixels() const;
 
+        // View of a region, no pixels copied. Valid until the pixmap is freed or reallocated.
+        // A shared pixmap gets its own pixels first, copies made while the view is in use see its writes.
+        // Static pixmaps give read only views
+        PixmapView view(int x, int y, int width, int height);
+
         // Copy pixels to array
         void copyPixels(void* from, size_t size);
 
@@ -58,9 +95,23 @@ class Pixmap {
         void fill(color_t color);
 
         // Only allowed with dynamic storage.
+        // flipHorizontally swaps top and bottom rows, flipVertically mirrors every row
         void flipHorizontally();
         void flipVertically();
 
+        // Draw src at x, y. RGBA sources are alpha blended, other layouts are converted and copied
+        void blit(const PixmapView& src, int x, int y);
+
+        // Convert to another number of components (1 grey, 2 grey + alpha, 3 RGB, 4 RGBA). Works on static pixmaps too (New storage)
+        int  convert(int components);
+
+        // Typed access for image processing loops, the format is checked once and not per pixel.
+        // Empty span / false if the pixmap is not Format. Same rules as view() for shared and static pixmaps
+        template<typename Format>
+        PixelSpan<Format> span();
+        template<typename Format, typename Function>
+        bool forEach(Function fn);
+
         color_t getPixel(int px, int py);
         void    setPixel(int px, int py, color_t color);
 
@@ -72,9 +123,25 @@ class Pixmap {
 
 
         static Pixmap loadImage(const char* fileName);
+        // Encoded image in memory (PNG, JPG...), the buffer is not kept
+        static Pixmap loadImageFromMemory(const void* data, size_t size);
+        // Level 0 of an image in a raw pack (Copied, ETC1 images decoded)
+        static Pixmap loadRaw(const RawPack& pack, const char* name);
         static Pixmap loadArray(void* px_ptr, int width, int height, int components);
         static Pixmap loadStaticArray(void* px_ptr, int width, int height, int components);
+        // Blocking, ImageWriter::save() encodes in the background
         static void   saveImage(const char* fileName, const Pixmap& pixmap);
 };
 
+
+template<typename Format>
+PixelSpan<Format> Pixmap::span(){
+    return this->view(0, 0, this->width, this->height).span<Format>();
+}
+
+template<typename Format, typename Function>
+bool Pixmap::forEach(Function fn){
+    return this->view(0, 0, this->width, this->height).forEach<Format>(fn);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * @file PixmapView.h
+ * @author Brais Solla González
+ * @brief Pixmap views (Borrowed pixels with row stride) for Enyx
+ * @version 0.1
+ * @date 2021-12-04
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ */
+
+#ifndef _PIXMAPVIEW_INCLUDED
+#define _PIXMAPVIEW_INCLUDED
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+#include "AGL.h"
+#include "PixelFormat.h"
+
+class Pixmap;
+
+// A rectangle of pixels inside someone else's storage. Nothing is copied or freed.
+// Rows are stride bytes apart, so a view can be a region of a bigger image (Atlas, sprite sheet...)
+class PixmapView {
+    private:
+        // First pixel of the view
+        uint8_t* px;
+        int width, height, components;
+        // Bytes between the start of two rows
+        int stride;
+        bool modifiable;
+    public:
+        PixmapView();
+        // View of a raw pixel array. stride 0 = tightly packed rows
+        PixmapView(void* px, int width, int height, int components, int stride);
+        PixmapView(const void* px, int width, int height, int components, int stride);
+        // Whole pixmap / region of a pixmap (Clipped to the pixmap)
+        PixmapView(Pixmap& pixmap);
+        PixmapView(Pixmap& pixmap, int x, int y, int width, int height);
+
+        // Region of this view (Clipped to this view)
+        PixmapView region(int x, int y, int width, int height) const;
+
+        bool onImage(int px, int py) const;
+        bool isModifiable()          const;
+        bool exists()                const;
+        // Rows are tightly packed (One block of memory)
+        bool isContiguous()          const;
+
+        // First pixel / first pixel of a row
+        void* getPixels()    const;
+        void* getRow(int py) const;
+
+        void clear();
+        void fill(color_t color);
+
+        // Draw src at x, y (Clipped). RGBA sources are alpha blended, other layouts are converted and copied
+        void blit(const PixmapView& src, int x, int y);
+
+        color_t getPixel(int px, int py) const;
+        void    setPixel(int px, int py, color_t color);
+
+        // Copy the pixels of this view to a tightly packed array (width * height * components bytes)
+        void copyTo(void* dest) const;
+
+        // Typed span of the pixels. Empty if the view is not Format (Or read only and Format is not const)
+        template<typename Format>
+        PixelSpan<Format> span() const;
+
+        // fn(Format& px) for every pixel. false (Nothing done) if the view is not Format
+        template<typename Format, typename Function>
+        bool forEach(Function fn) const;
+
+        int getWidth()      const;
+        int getHeight()     const;
+        int getComponents() const;
+        int getStride()     const;
+};
+
+
+template<typename Format>
+PixelSpan<Format> PixmapView::span() const {
+    if(this->px == NULL || this->components != (int) Format::components) return PixelSpan<Format>();
+    if(!this->modifiable && !std::is_const<Format>::value) return PixelSpan<Format>();
+
+    return PixelSpan<Format>((Format*) this->px, this->width, this->height, this->stride);
+}
+
+template<typename Format, typename Function>
+bool PixmapView::forEach(Function fn) const {
+    PixelSpan<Format> pixels = this->span<Format>();
+    if(!pixels.exists()) return false;
+
+    pixels.forEach(fn);
+    return true;
+}
+
+#endif
\ No newline at end of file
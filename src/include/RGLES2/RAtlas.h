@@ -0,0 +1,88 @@
+/**
+ * @file RAtlas.h
+ * @author Brais Solla González
+ * @brief RAtlas / Runtime texture atlas for RGLES2
+ * @version 0.1
+ * @date 2021-12-08
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ * Packs many small images (Sprites, glyphs, icons) into a few large texture pages,
+ * so sprites of the same page are drawn in one draw call (RGLES2::drawAtlas).
+ * Pages are filled with a skyline bottom-left packer. Images are padded and their
+ * borders extruded into the padding, so linear filtering does not bleed between images.
+ */
+
+#ifndef _ENYX_RGLES2_RATLAS_INCLUDED
+#define _ENYX_RGLES2_RATLAS_INCLUDED
+
+#include "Pixmap.h"
+#include "PixmapView.h"
+
+class RTexture;
+
+// Default page size in texels (Clamped to GL_MAX_TEXTURE_SIZE)
+#define ATLAS_DEFAULT_PAGE_SIZE 1024
+// Default texels around every image
+#define ATLAS_DEFAULT_PADDING   1
+
+// Image placed in an atlas page, in texels (Padding not included)
+struct ratlasregion_t {
+    int page;
+    int x, y, width, height;
+};
+
+// Skyline segment: texels [x, x + width) of the page are used up to row y
+struct ratlasnode_t {
+    int x, y, width;
+};
+
+struct ratlaspage_t {
+    RTexture*     texture;
+    ratlasnode_t* skyline;
+    int           nodes;
+    int           capacity;
+};
+
+class RAtlas {
+    private:
+        int pageSize, components, padding;
+
+        ratlaspage_t*   pages;
+        int             pageCount;
+        ratlasregion_t* regions;
+        int             regionCount;
+        int             regionCapacity;
+
+        // Lowest position for a width x height rectangle. false if it does not fit in the page
+        bool findPosition(const ratlaspage_t* page, int width, int height, int* node, int* px, int* py) const;
+        // Raise the skyline over a rectangle placed at px, py (found at node)
+        bool placeRectangle(ratlaspage_t* page, int node, int px, int py, int width, int height);
+        // New empty page, -1 on error
+        int  addPage();
+    public:
+        // components: texel layout of the pages (1 grey, 2 grey + alpha, 3 RGB, 4 RGBA)
+        RAtlas();
+        RAtlas(int pageSize, int components, int padding);
+        ~RAtlas();
+
+        // Place an image, a new page is created when it does not fit in the others.
+        // Returns the region handle, -1 on error (Too big or out of memory)
+        int  add(const PixmapView& view);
+        // Pixmaps of another layout are converted first
+        int  add(Pixmap& pixmap);
+
+        // NULL if the handle is not valid
+        const ratlasregion_t* getRegion(int region) const;
+        RTexture* getPage(int page) const;
+
+        int  getPageCount()   const;
+        int  getRegionCount() const;
+        int  getPageSize()    const;
+        int  getComponents()  const;
+
+        // Delete every page and region
+        void clear();
+};
+
+#endif
@@ -14,6 +14,29 @@
 
 #define DEFAULT_DRAW_BUFFER_SIZE_ELEMENTS 512
 #define CIRCLE_STEPS                      32
+// Adaptive circles: max distance in pixels between the rim and the segments (0 = always CIRCLE_STEPS)
+#define CIRCLE_TOLERANCE                  0.25f
+#define CIRCLE_MIN_STEPS                  8
+#define CIRCLE_MAX_STEPS                  256
+// Number of GPU buffer objects used as a ring for VBO streaming
+#define VBO_RING_SIZE                     4
+// Indices reserved per draw buffer element (Enough for triangle fans and quads)
+#define RBUFFER_INDICES_PER_ELEMENT       3
+// 16 bit indices: Max elements an indexed draw buffer can address
+#define RBUFFER_MAX_INDEXED_ELEMENTS      65536
+// Quads covered by the static quad index buffer
+#define QUAD_INDEX_BUFFER_QUADS           (RBUFFER_MAX_INDEXED_ELEMENTS / 4)
+// Deferred commands: batches looked back when merging a command
+#define COMMAND_MERGE_LOOKBACK            32
+// Deferred commands: initial command list and arena sizes
+#define COMMAND_LIST_INITIAL_SIZE         256
+#define COMMAND_ARENA_INITIAL_SIZE        (64 * 1024)
+// Textures sampled by one texture pipeline draw call (Also limited by GL_MAX_TEXTURE_IMAGE_UNITS)
+#define TEXTURE_MAX_UNITS                 8
+// Texture cache: default GPU memory budget in bytes
+#define TEXTURE_CACHE_DEFAULT_BUDGET      (128 * 1024 * 1024)
+// Upload queue: bytes of texture rows uploaded per frame
+#define TEXTURE_UPLOAD_FRAME_BUDGET       (1024 * 1024)
 
 
 
@@ -27,6 +27,8 @@ class RDotPipeline : public RPipeline {
         void setTransform(RMatrix4& matrix);
         void draw(void* buffer);
 
+        int  getVertexFormat() const;
+
         void setPointSize(int pointSize);
 };
 
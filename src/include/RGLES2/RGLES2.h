@@ -16,12 +16,14 @@
 #include "AGL.h"
 #include "Platform_SDL2.h"
 #include "Pixmap.h"
+#include "RawPack.h"
 #include <GLES2/gl2.h>
 
 // RGLES2
 #include "RGLES2/RVector2i.h"
 #include "RGLES2/RVector2.h"
 #include "RGLES2/RMatrix4.h"
+#include "RGLES2/RMatrix3.h"
 #include "RGLES2/RUtils.h"
 #include "RGLES2/RConstants.h"
 #include "RGLES2/RShader.h"
@@ -31,8 +33,13 @@
 #include "RGLES2/RDotPipeline.h"
 #include "RGLES2/RLinePipeline.h"
 #include "RGLES2/RTrianglePipeline.h"
+#include "RGLES2/RShapePipeline.h"
+#include "RGLES2/RParticlePipeline.h"
 #include "RGLES2/RBasicTexturePipeline.h"
 #include "RGLES2/RTexturePipeline.h"
+#include "RGLES2/RAtlas.h"
+#include "RGLES2/RTextureCache.h"
+#include "RGLES2/RUploadQueue.h"
 
 #define rmalloc(n)    malloc(n)
 #define rrealloc(p,n) realloc(p,n)
@@ -48,14 +55,27 @@ class RTexture {
 
         float left, right, top, bottom;
         bool flipped;
+        // ETC1 storage, alpha in the bottom half of the texture (See ETC1.h)
+        bool compressed;
+        bool alphaPlane;
     public:
         RTexture();
         RTexture(int width, int heigth, int comp);
         RTexture(Pixmap& pixmap);
+        // Upload an image of a raw pack, mip levels included. Nothing is decoded (But ETC1 images without GPU support)
+        RTexture(const RawPack& pack, const char* name);
         ~RTexture();
 
         int  genMipmaps();
+        // Upload count levels of a mip chain (ImageDriver::buildMipChain layout) of this texture size.
+        // Only level 0 is used unless the texture is power of 2 and the chain is complete. Returns the levels used
+        int  uploadMipChain(const uint8_t* levels, int count);
+        // Upload count ETC1 levels (RAWPACK_FLAG_ETC1 layout) of this texture size. Decoded on the CPU
+        // when OES_compressed_ETC1_RGB8_texture is missing. Returns the levels used
+        int  uploadETC1(const uint8_t* levels, int count);
         void uploadPixels(int px, int py, int width, int height, int cmp, void* pixels);
+        // Upload a view (Region of a pixmap, any row stride) at px, py
+        void uploadPixels(int px, int py, const PixmapView& view);
 
         // Attach
         void attach(int texture_unit);
@@ -80,6 +100,13 @@ class RTexture {
         float Bottom() const;
 
         bool isFlipped() const;
+        // Compressed textures cannot be updated with uploadPixels() / genMipmaps()
+        bool isCompressed()  const;
+        // Alpha sampled from the bottom half, the image covers [0, getTBorder()] in t
+        bool hasAlphaPlane() const;
+
+        // OpenGL texture name (0 = not initialized)
+        GLuint getTextureId() const;
 
         static RTexture loadImage(const char* fileName);
 };
@@ -93,8 +120,9 @@ typedef struct {
     float x, y, z;
 } __attribute__((packed)) normal3_t;
 
+// Normalized 8 bit color, uploaded as GL_UNSIGNED_BYTE
 typedef struct {
-    float r, g, b, a;
+    uint8_t r, g, b, a;
 } __attribute__((packed)) color4_t;
 
 typedef struct {
@@ -105,6 +133,14 @@ typedef struct {
     float s, t, u;
 } __attribute__((packed)) texcrd3_t;
 
+// Shape parameters in pixels: half width, half height, corner radius (< 0, ellipse), stroke width (0 = filled)
+typedef struct {
+    float hw, hh, radius, stroke;
+} __attribute__((packed)) shape4_t;
+
+// Element index (GL_UNSIGNED_SHORT)
+typedef uint16_t rindex_t;
+
 // Performance counter struct
 // This should be a global struct accesible from the rendering pipelines
 struct rperfstats_t {
@@ -114,12 +150,21 @@ struct rperfstats_t {
     uint32_t vertices_drawn;
     // Total context changes operations
     uint32_t context_changes;
+    // Textures bound to a unit of the texture pipeline. A draw call ends only when every unit is taken
+    uint32_t texture_changes;
     // Number of auxiliary buffers used in this frame
     uint32_t auxiliary_buffers_used;
     // Maximum buffer usage in elements!
     uint32_t buffer_max_elements_used;
-    // Total bytes transfered via glAttibPointer / glTexImage2D operation
+    // Total bytes transfered via glAttibPointer / glBufferSubData / glTexImage2D operation
     uint32_t bytes_transfered;
+    // Total bytes streamed to GPU buffer objects (VBO streaming only)
+    uint32_t bytes_uploaded;
+    // Total indices drawn (glDrawElements)
+    uint32_t indices_drawn;
+    // Deferred mode: commands recorded and batches they were merged into
+    uint32_t commands_recorded;
+    uint32_t commands_batches;
     // Total time usage for the draw operation (newTime - lastTime)
     uint32_t time_ms;
     // ...
@@ -133,14 +178,31 @@ struct rbufferptr_t {
     void* nrm_ptr;
     // Color pointer
     void* clr_ptr;
-    // Texcoord pointer
+    // Texcoord pointer (NULL if the vertex format has no texcoords)
     void* txc_ptr;
+    // Shape parameters pointer (NULL if the vertex format has no shape parameters)
+    void* prm_ptr;
+    // Distance in bytes between two consecutive elements (planar or interleaved)
+    uint32_t vtx_stride;
+    uint32_t clr_stride;
+    uint32_t txc_stride;
+    uint32_t prm_stride;
+    // 2D affine transform applied to vertices while writing (RMatrix3 array, NULL = none)
+    const float* transform;
+    // Index pointer (NULL if no indices were requested)
+    rindex_t* idx_ptr;
+    // Index of the first element of this allocation, add it to every index written
+    uint32_t  idx_base;
 };
 
 // Enum for buffer header flags
 enum rbufferheader_flags_t {
-    FLAG_NONE     = 0,
-    FLAG_TEMPORAL = _BV(0)
+    FLAG_NONE          = 0,
+    FLAG_TEMPORAL      = _BV(0),
+    // Index stream holds only quads (0,1,2,2,3,0, 4,5,6...). The static quad index buffer can be used
+    FLAG_QUAD_INDICES  = _BV(1),
+    // Buffer of a deferred command, lives in the command arena
+    FLAG_COMMAND       = _BV(2)
 };
 // Struct for buffer header
 struct rbufferheader_t {
@@ -148,6 +210,8 @@ struct rbufferheader_t {
     uint32_t buffer_size;
     // Buffer size in elements
     uint32_t buffer_max_elements;
+    // Buffer size in indices
+    uint32_t buffer_max_indices;
 
     // Number of elements (glDrawArrays)
     uint32_t elements;
@@ -155,15 +219,75 @@ struct rbufferheader_t {
     uint32_t vtx_count;
     uint32_t clr_count;
     uint32_t txc_count;
+    // Number of indices (glDrawElements if not zero)
+    uint32_t idx_count;
     // Buffer offsets counting from base + RBUFFERHEADER_SIZE
     intptr_t vtx_offset;
     intptr_t clr_offset;
     intptr_t txc_offset;
+    intptr_t prm_offset;
+    // Index stream offset, after the elements
+    intptr_t idx_offset;
+    // Vertex format (rvertexformat_t) and stride in bytes of every attribute (txc_stride = 0, no texcoords. prm_stride = 0, no shape parameters)
+    uint32_t format;
+    uint32_t vtx_stride;
+    uint32_t clr_stride;
+    uint32_t txc_stride;
+    uint32_t prm_stride;
     // flags? / textures? / parameters?
     uint32_t flags;
+    // Buffer object holding this buffer contents while drawing (0 = client-side arrays)
+    uint32_t vbo;
+    // Buffer object holding the indices while drawing (0 = client-side indices)
+    uint32_t ibo;
 };
 
 #define RBUFFERHEADER_SIZE sizeof(rbufferheader_t)
+// Bytes reserved per element in a draw buffer (Enough for any vertex format)
+#define RBUFFER_ELEMENT_SIZE (sizeof(vertex3_t) + sizeof(color4_t) + sizeof(texcrd2_t) + sizeof(shape4_t))
+// Total bytes of a draw buffer (Header + elements + index stream)
+#define RBUFFER_TOTAL_SIZE(elements, indices) (RBUFFERHEADER_SIZE + ((elements) * RBUFFER_ELEMENT_SIZE) + ((indices) * sizeof(rindex_t)))
+
+// Enum for renderer init flags
+enum rgles2_init_flags_t {
+    INIT_FLAG_NONE          = 0,
+    // Stream draw buffers through a ring of GPU buffer objects instead of client-side arrays
+    INIT_FLAG_VBO_STREAMING = _BV(0),
+    // Record draw calls and sort and merge them at render() (Fewer pipeline switches)
+    INIT_FLAG_DEFERRED      = _BV(1),
+    // Transform vertices on the CPU, translate / rotate / scale do not break batches
+    INIT_FLAG_CPU_TRANSFORM = _BV(2),
+    // Draw circles as antialiased quads through the shape pipeline (Not tessellated)
+    INIT_FLAG_SHAPE_CIRCLES = _BV(3)
+};
+
+// Render state snapshot of deferred commands
+struct rstate_t {
+    // Transformation matrix (RMatrix4 contents)
+    float    matrix[16];
+    int32_t  viewport[4];
+    int32_t  scissor[4];
+    uint32_t scissor_enabled;
+    // Particle pipeline point size
+    float    point_size;
+};
+
+// Deferred draw command. Commands with the same key (pipeline, texture, state) can be merged
+struct rcommand_t {
+    RPipeline* pipeline;
+    // Texture bound to the pipeline (0 = none)
+    uint32_t   texture;
+    // Render state index
+    uint32_t   state;
+    // Submission order (painter's order)
+    uint32_t   order;
+    // Batch the command was merged into
+    uint32_t   batch;
+    // Window space bounding box: x0, y0, x1, y1
+    float      bbox[4];
+    // Command buffer offset in the command arena
+    size_t     offset;
+};
 
 // Info for OpenGL ES 2.0 renderer
 struct rgles2info_t {
@@ -195,16 +319,70 @@ class RGLES2 {
         // Number of MAX elements in the draw buffer. Used via 
         uint32_t drawBufferSizeElements;
         int circle_steps;
+        // Adaptive circle tessellation tolerance in pixels (<= 0, fixed circle_steps)
+        float circleTolerance;
+        // Unit circle tables (cos, sin pairs) by step count, built on first use
+        float* circleTables[CIRCLE_MAX_STEPS + 1];
+        // Flags passed to init()
+        uint32_t initFlags;
+
+        // VBO streaming ring (Only with INIT_FLAG_VBO_STREAMING)
+        GLuint streamBuffers[VBO_RING_SIZE];
+        size_t streamBufferSizes[VBO_RING_SIZE];
+        int    streamBufferIndex;
+        // Index buffers of the streaming ring, paired with streamBuffers
+        GLuint streamIndexBuffers[VBO_RING_SIZE];
+        size_t streamIndexBufferSizes[VBO_RING_SIZE];
+
+        // Static index buffer for quads (0,1,2,2,3,0, 4,5,6,6,7,4, ...)
+        GLuint quadIndexBuffer;
+
+        // Current viewport and scissor (Recorded by deferred commands)
+        int32_t  viewportRect[4];
+        int32_t  scissorRect[4];
+        uint32_t scissorEnabled;
+
+        // Deferred mode (Only with INIT_FLAG_DEFERRED). Not recording while commands are replayed
+        bool        recordingCommands;
+        RPipeline*  recordPipeline;
+        // Texture of the commands recorded with the texture pipeline
+        GLuint      recordTexture;
+        // Command buffers (rbufferheader_t + elements + indices)
+        void*       commandArena;
+        size_t      commandArenaSize;
+        size_t      commandArenaUsed;
+        rcommand_t* commands;
+        uint32_t    commandCount;
+        uint32_t    commandCapacity;
+        rstate_t*   states;
+        uint32_t    stateCount;
+        uint32_t    stateCapacity;
+        bool        stateDirty;
+
+        // Performance stats of the last rendered frame
+        rperfstats_t framePerfstats;
+        uint32_t     frameStartTime;
 
         RPipeline* currentRPipeline;
 
         // Where's the Matrix?
         RMatrix4 tMatrix;
+        // CPU transform (Only with INIT_FLAG_CPU_TRANSFORM): tMatrix = projMatrix * modelMatrix
+        // Only the projection reaches the shaders, vertices are written with modelMatrix applied
+        RMatrix4 projMatrix;
+        RMatrix3 modelMatrix;
+        bool     modelIdentity;
         // Pipelines
         RDotPipeline*      dotPipeline;
         RLinePipeline*     linePipeline;
         RTrianglePipeline* trianglePipeline;
-        // RTexturePipeline*  texturePipeline;
+        RShapePipeline*    shapePipeline;
+        RParticlePipeline* particlePipeline;
+        RTexturePipeline*  texturePipeline;
+        // Textures by asset name, under a memory budget
+        RTextureCache*     textureCache;
+        // Big textures uploaded a few rows every frame
+        RUploadQueue*      uploadQueue;
         // Probably pixelWidth and lineWidth
         // Point sprites will be supported!
 
@@ -213,22 +391,67 @@ class RGLES2 {
         // Internal methods
         // Switch pipeline: Only if new pipeline is different to the new pipeline
         void setPipeline(RPipeline* pipeline);
+        // Texture unit of a texture in the texture pipeline (Submits if every unit is taken). Set the pipeline first
+        int  setTexture(GLuint texture);
 
         // Zero performance stats counter. Call every frame!
         // Or not
         void zeroPerfstats();
 
+        // Upload buffer contents to the next buffer object of the streaming ring
+        void streamBuffer(void* buffer);
+
+        // Draw a buffer with the current pipeline (Streams it first if enabled)
+        void drawPipelineBuffer(void* buffer);
+
         // Generate draw buffers / resize draw buffer
         void* genDrawBuffers(void* drawBuffer, uint32_t drawBufferElements);
 
+        // Current vertex format (From the active pipeline)
+        int   getVertexFormat() const;
+
         // Request elements for drawing
         void* allocateElements(size_t elements, rbufferptr_t* rbufferptr);
+        // Request elements and indices for indexed drawing
+        void* allocateElements(size_t elements, size_t indices, rbufferptr_t* rbufferptr);
+        // Request 4 elements per quad, indices already written (Two triangles: 0,1,2 and 2,3,0)
+        void* allocateQuads(size_t quads, rbufferptr_t* rbufferptr);
+
+        // Create the static quad index buffer
+        void  genQuadIndexBuffer();
+
+        // Deferred mode: command buffer in the arena, command recording, state snapshots and replay
+        void*    allocateCommand(size_t elements, size_t indices, int format);
+        void     recordCommand(void* buffer);
+        uint32_t recordState();
+        void     saveState(rstate_t* state);
+        void     applyState(const rstate_t* state);
+        void     replayCommands();
+        void     discardCommands();
 
         // Update drawing buffers before allocation
        void updateBuffer(void* buffer, size_t vtx, size_t nrm, size_t clr, size_t txc);
 
        // Update transform
        void updateTransform();
+
+       // Matrix for the u_tmtrx uniform (tMatrix, or projMatrix with CPU transform)
+       RMatrix4& shaderMatrix();
+
+       // Pixels per unit of the current transform (Largest axis)
+       float transformScale() const;
+
+       // Segments for a circle of radius r with the current transform and tolerance
+       int   circleSteps(int r) const;
+
+       // Unit circle table for a step count (steps cos, sin pairs). NULL if out of memory
+       const float* circleTable(int steps);
+
+       // One shape pipeline quad. Sizes in drawing units, stroke in pixels (0 = filled), radius < 0 = ellipse
+       void  drawShape(float cx, float cy, float hw, float hh, float radius, float stroke, color_t color);
+
+       // One texture pipeline quad. Texel rectangle sx, sy, sw, sh of the texture drawn at x, y, w, h
+       void  drawTextureQuad(const RTexture& texture, int sx, int sy, int sw, int sh, float x, float y, float w, float h, color_t color);
     public:
         RGLES2();
         ~RGLES2();
@@ -254,6 +477,14 @@ class RGLES2 {
          */
         int  init();
 
+        /**
+         * @brief Starts the RGLES2 renderer with init flags
+         * 
+         * @param flags Bitmask of rgles2_init_flags_t (INIT_FLAG_VBO_STREAMING, ...)
+         * @return int Returns zero on sucess, other on error
+         */
+        int  init(uint32_t flags);
+
         /**
          * @brief Ends the RGLES2 renderer. Called automatically from the destructor
          * 
@@ -286,6 +517,27 @@ class RGLES2 {
          */
         void clearBuffers();
 
+        /**
+         * @brief Get the performance stats of the last rendered frame
+         * 
+         * @return rperfstats_t Draw calls, vertices and bytes uploaded in the last frame
+         */
+        rperfstats_t getPerfstats() const;
+
+        /**
+         * @brief Get the texture cache (Textures by asset name, LRU evicted under a memory budget)
+         * 
+         * @return RTextureCache* NULL before init()
+         */
+        RTextureCache* getTextureCache();
+
+        /**
+         * @brief Get the upload queue (Textures uploaded in bands of rows over several frames, see RUploadQueue.h)
+         * 
+         * @return RUploadQueue* NULL before init()
+         */
+        RUploadQueue*  getUploadQueue();
+
 
         // Viewport, scissor and coordinate transformations!
 
@@ -384,6 +636,23 @@ class RGLES2 {
          */
         void     setTransfomationMatrix(const RMatrix4& tmatrix);
 
+        /**
+         * @brief Sets the number of circle segments used when adaptive tessellation is disabled
+         * 
+         * @param steps Segments (3 to CIRCLE_MAX_STEPS)
+         */
+        void     setCircleSteps(int steps);
+
+        /**
+         * @brief Sets the adaptive circle tessellation tolerance
+         * 
+         * Segments are chosen from the on-screen radius so the rim is never further than
+         * tolerance pixels from the drawn segments. Defaults to CIRCLE_TOLERANCE
+         * 
+         * @param tolerance Max error in pixels. Zero or less disables adaptive tessellation
+         */
+        void     setCircleTolerance(float tolerance);
+
 
         // RENDERING METHODS!
         void clearColor(color_t color);
@@ -499,6 +768,196 @@ class RGLES2 {
          */
         void drawFillCircle(int x, int y, int r, color_t color1, color_t color2);
 
+        /**
+         * @brief Draws a ring (Antialiased, shape pipeline)
+         * 
+         * @param x 
+         * @param y 
+         * @param r Outer radius
+         * @param thickness Ring width, towards the center
+         * @param color 
+         */
+        void drawRing(int x, int y, int r, int thickness, color_t color);
+
+        /**
+         * @brief Draws an ellipse (Antialiased, shape pipeline)
+         * 
+         * @param x 
+         * @param y 
+         * @param rx Horizontal radius
+         * @param ry Vertical radius
+         * @param color 
+         */
+        void drawEllipse(int x, int y, int rx, int ry, color_t color);
+
+        /**
+         * @brief Draws a filled ellipse (Antialiased, shape pipeline)
+         * 
+         * @param x 
+         * @param y 
+         * @param rx Horizontal radius
+         * @param ry Vertical radius
+         * @param color 
+         */
+        void drawFillEllipse(int x, int y, int rx, int ry, color_t color);
+
+        /**
+         * @brief Draws a rounded rectangle (Antialiased, shape pipeline)
+         * 
+         * @param x 
+         * @param y 
+         * @param w 
+         * @param h 
+         * @param r Corner radius
+         * @param color 
+         */
+        void drawRoundRect(int x, int y, int w, int h, int r, color_t color);
+
+        /**
+         * @brief Draws a filled rounded rectangle (Antialiased, shape pipeline)
+         * 
+         * @param x 
+         * @param y 
+         * @param w 
+         * @param h 
+         * @param r Corner radius
+         * @param color 
+         */
+        void drawFillRoundRect(int x, int y, int w, int h, int r, color_t color);
+
+        /**
+         * @brief Draws a particle (Round point sprite, particle pipeline)
+         * 
+         * @param x 
+         * @param y 
+         * @param size Particle diameter
+         * @param color 
+         */
+        void drawParticle(float x, float y, float size, color_t color);
+
+        /**
+         * @brief Draws many particles from caller owned arrays (Structure of arrays)
+         * 
+         * Particles are written straight into the draw buffer, no per particle calls.
+         * Sprite sizes are limited by GL_ALIASED_POINT_SIZE_RANGE
+         * 
+         * @param x Particle x coordinates
+         * @param y Particle y coordinates
+         * @param size Particle diameters (NULL, all particles are 1 unit)
+         * @param colors Particle colors
+         * @param count Number of particles
+         */
+        void drawParticles(const float* x, const float* y, const float* size, const color_t* colors, size_t count);
+
+        /**
+         * @brief Sets the particle size multiplier (u_pointsize uniform, default 1)
+         * 
+         * Particles drawn before the call keep the old value.
+         * In deferred mode, the last value set before render() is used
+         * 
+         * @param size Multiplier for every particle size
+         */
+        void setPointSize(float size);
+
+        /**
+         * @brief Draws a texture (Texture pipeline, alpha blended)
+         * 
+         * Consecutive draws batch in one draw call while they use no more than TEXTURE_MAX_UNITS textures
+         * 
+         * @param texture 
+         * @param x 
+         * @param y 
+         */
+        void drawTexture(const RTexture& texture, int x, int y);
+
+        /**
+         * @brief Draws a texture scaled to w, h
+         * 
+         * @param texture 
+         * @param x 
+         * @param y 
+         * @param w 
+         * @param h 
+         */
+        void drawTexture(const RTexture& texture, int x, int y, int w, int h);
+
+        /**
+         * @brief Draws a texture tinted (Texels multiplied by color)
+         * 
+         * @param texture 
+         * @param x 
+         * @param y 
+         * @param w 
+         * @param h 
+         * @param color Tint color
+         */
+        void drawTexture(const RTexture& texture, int x, int y, int w, int h, color_t color);
+
+        /**
+         * @brief Draws a texture of the texture cache (Loaded on first use)
+         * 
+         * @param name Asset name (Image file name if not registered)
+         * @param x 
+         * @param y 
+         */
+        void drawTexture(const char* name, int x, int y);
+
+        /**
+         * @brief Draws a region of a texture
+         * 
+         * @param texture 
+         * @param sx Region X coordinate in texels
+         * @param sy Region Y coordinate in texels
+         * @param sw Region width in texels
+         * @param sh Region height in texels
+         * @param x 
+         * @param y 
+         * @param w 
+         * @param h 
+         */
+        void drawSubTexture(const RTexture& texture, int sx, int sy, int sw, int sh, int x, int y, int w, int h);
+
+        /**
+         * @brief Draws a tinted region of a texture
+         * 
+         * @param texture 
+         * @param sx Region X coordinate in texels
+         * @param sy Region Y coordinate in texels
+         * @param sw Region width in texels
+         * @param sh Region height in texels
+         * @param x 
+         * @param y 
+         * @param w 
+         * @param h 
+         * @param color Tint color
+         */
+        void drawSubTexture(const RTexture& texture, int sx, int sy, int sw, int sh, int x, int y, int w, int h, color_t color);
+
+        /**
+         * @brief Draws an atlas image (See RAtlas::add)
+         * 
+         * Images of the same atlas page are batched in one draw call, whatever image they are
+         * 
+         * @param atlas 
+         * @param region Region handle returned by RAtlas::add
+         * @param x 
+         * @param y 
+         */
+        void drawAtlas(const RAtlas& atlas, int region, int x, int y);
+
+        /**
+         * @brief Draws a tinted atlas image scaled to w, h
+         * 
+         * @param atlas 
+         * @param region Region handle returned by RAtlas::add
+         * @param x 
+         * @param y 
+         * @param w 
+         * @param h 
+         * @param color Tint color
+         */
+        void drawAtlas(const RAtlas& atlas, int region, int x, int y, int w, int h, color_t color);
+
         /**
          * @brief Draws a triangle (lines)
          * 
@@ -26,6 +26,8 @@ class RLinePipeline : public RPipeline {
         void disable();
         void setTransform(RMatrix4& matrix);
         void draw(void* buffer);
+
+        int  getVertexFormat() const;
 };
 
 #endif
\ No newline at end of file
@@ -12,6 +12,8 @@
 #ifndef _ENYX_RGLES2_RMATRIX3_INCLUDED
 #define _ENYX_RGLES2_RMATRIX3_INCLUDED
 
+#include <stddef.h>
+
 class RMatrix3 {
     public:
         float e[9];
@@ -35,6 +37,15 @@ class RMatrix3 {
         float* getArray();
         void   loadIdentity();
 
+        /**
+         * @brief Transforms n 2D points (affine). SIMD accelerated
+         *
+         * @param in  n (x, y) pairs. An RVector2 array works too
+         * @param out n (x, y) pairs, can be the same as in
+         * @param n   Number of points
+         */
+        void   transformPoints(const float* in, float* out, size_t n) const;
+
         static RMatrix3 translation(float tx, float ty);
         static RMatrix3 rotation(float angle);
         static RMatrix3 scaling(float sx, float sy);
@@ -12,6 +12,8 @@
 #ifndef _ENYX_RGLES2_RMATRIX4_INCLUDED
 #define _ENYX_RGLES2_RMATRIX4_INCLUDED
 
+#include <stddef.h>
+
 class RMatrix4 {
     public:
         float e[16];
@@ -35,6 +37,15 @@ class RMatrix4 {
         float* getArray();
         void   loadIdentity();
 
+        /**
+         * @brief Transforms n 2D points (z = 0, w = 1). SIMD accelerated
+         *
+         * @param in  n (x, y) pairs. An RVector2 array works too
+         * @param out n (x, y) pairs, can be the same as in
+         * @param n   Number of points
+         */
+        void   transformPoints(const float* in, float* out, size_t n) const;
+
         static RMatrix4 translation(float tx, float ty);
 
         // Do not use for now! Enyx is NOT intended to be a 3D graphics engine (yet)
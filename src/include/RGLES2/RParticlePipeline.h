@@ -0,0 +1,41 @@
+/**
+ * @file RParticlePipeline.h
+ * @author Brais Solla González
+ * @brief RParticlePipeline
+ * @version 0.1
+ * @date 2021-12-03
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ * Round point sprites with per vertex size and color.
+ * Vertices use the position + color layout, z is the sprite size in pixels.
+ */
+
+#ifndef _ENYX_RGLES2_RPARTICLEPIPELINE_INCLUDED
+#define _ENYX_RGLES2_RPARTICLEPIPELINE_INCLUDED
+
+#include "RGLES2/RPipeline.h"
+#include "RGLES2/RShader.h"
+
+class RParticlePipeline : public RPipeline {
+    private:
+        RShader* internalShader;
+        // u_pointsize value, multiplies every particle size
+        float pointSize;
+        bool  enabled;
+    public:
+        RParticlePipeline();
+        ~RParticlePipeline();
+
+        void enable();
+        void disable();
+        void setTransform(RMatrix4& matrix);
+        void draw(void* buffer);
+
+        int  getVertexFormat() const;
+
+        void  setPointSize(float pointSize);
+        float getPointSize() const;
+};
+
+#endif
@@ -15,6 +15,20 @@
 #include "RGLES2/RMatrix3.h"
 #include "RGLES2/RMatrix4.h"
 
+// Vertex formats (draw buffer layouts) requested by the pipelines
+enum rvertexformat_t {
+    // Planar arrays: [vertex3_t...][color4_t...][texcrd2_t...]
+    VERTEX_FORMAT_PLANAR = 0,
+    // Interleaved position + color: [vertex3_t color4_t]...
+    VERTEX_FORMAT_PC     = 1,
+    // Interleaved position + color + texcoord: [vertex3_t color4_t texcrd2_t]...
+    VERTEX_FORMAT_PCT    = 2,
+    // Interleaved position + color + texcoord + shape parameters: [vertex3_t color4_t texcrd2_t shape4_t]...
+    VERTEX_FORMAT_PCTS   = 3,
+    // Interleaved position + color + texcoord and texture unit: [vertex3_t color4_t texcrd3_t]... (u = unit)
+    VERTEX_FORMAT_PCTU   = 4
+};
+
 class RPipeline {
     public:
         virtual ~RPipeline();
@@ -27,6 +41,14 @@ class RPipeline {
 
         // Set uniforms!
         virtual void setTransform(RMatrix4& matrix)  = 0;
+
+        // Draw buffer layout used by this pipeline (rvertexformat_t). Planar by default
+        virtual int getVertexFormat() const;
+    protected:
+        // Alpha blending for pipelines with transparent or antialiased pixels. Call the first one from enable()
+        // and the second one from disable(), it restores the default blend function the other pipelines expect
+        static void enableAlphaBlend();
+        static void disableAlphaBlend();
 };
 
 
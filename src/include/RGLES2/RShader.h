@@ -24,6 +24,7 @@ class RShader {
         GLint color_attrib;
         GLint texcoord_attrib;
         GLint normal_attrib;
+        GLint params_attrib;
 
         GLint txMatrix_uniform;
         GLint texTxMatrix_uniform;
@@ -44,6 +45,7 @@ class RShader {
         GLint getColorAttrib()    const;
         GLint getTexcoordAttrib() const;
         GLint getNormalAttrib()   const;
+        GLint getParamsAttrib()   const;
 
         GLint getTransformMatrixUniform() const;
         GLint getTextureTxMatrixUniform() const;
@@ -0,0 +1,35 @@
+/**
+ * @file RShapePipeline.h
+ * @author Brais Solla González
+ * @brief RShapePipeline
+ * @version 0.1
+ * @date 2021-12-03
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ * Circles, rings, ellipses and rounded rectangles, one quad per shape.
+ * Shape edges are computed in the fragment shader (Signed distance), antialiased.
+ */
+
+#ifndef _ENYX_RGLES2_RSHAPEPIPELINE_INCLUDED
+#define _ENYX_RGLES2_RSHAPEPIPELINE_INCLUDED
+
+#include "RGLES2/RPipeline.h"
+#include "RGLES2/RShader.h"
+
+class RShapePipeline : public RPipeline {
+    private:
+        RShader* internalShader;
+    public:
+        RShapePipeline();
+        ~RShapePipeline();
+
+        void enable();
+        void disable();
+        void setTransform(RMatrix4& matrix);
+        void draw(void* buffer);
+
+        int  getVertexFormat() const;
+};
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file RTextureCache.h
+ * @author Brais Solla González
+ * @brief RTextureCache / Texture residency cache for RGLES2
+ * @version 0.1
+ * @date 2021-12-09
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ * Textures by asset name (Or its hash), uploaded on first use and kept under a GPU memory budget.
+ * The least recently used textures are deleted when the budget is exceeded and uploaded
+ * again from their source (An image file or a pixmap kept in memory) when they are used again.
+ * Textures used in the current frame are never deleted, pending draws may still sample them:
+ * the budget can be exceeded for a frame if they do not fit. Released or replaced ones are
+ * deleted by nextFrame().
+ */
+
+#ifndef _ENYX_RGLES2_RTEXTURECACHE_INCLUDED
+#define _ENYX_RGLES2_RTEXTURECACHE_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Pixmap.h"
+
+class RTexture;
+
+enum rtexturecache_flags_t {
+    TEXTURECACHE_NONE    = 0,
+    // Generate mipmaps (Power of 2 textures only)
+    TEXTURECACHE_MIPMAPS = (1 << 0)
+};
+
+// Counters since the cache was created (Or resetStats())
+struct rtexturecachestats_t {
+    // get() calls with the texture resident / uploaded
+    uint32_t hits;
+    uint32_t misses;
+    // Textures deleted to stay under the budget (Or released)
+    uint32_t evictions;
+    // Textures that could not be loaded
+    uint32_t failures;
+    // Current GPU memory use (Released textures waiting for nextFrame() included) and budget (Bytes)
+    uint64_t bytes_resident;
+    uint64_t budget;
+    // Resident textures and registered assets
+    uint32_t resident;
+    uint32_t entries;
+};
+
+struct rtexturecacheentry_t {
+    uint64_t  hash;
+    // Asset name, file name of the image if there is no pixmap
+    char*     name;
+    // Pixmap the texture is uploaded from (NULL = image file)
+    Pixmap*   source;
+    // NULL if not resident
+    RTexture* texture;
+    // Bytes resident (Mip levels included)
+    size_t    bytes;
+    uint32_t  flags;
+    // Last frame the texture was used
+    uint32_t  frame;
+    // LRU list of resident textures, most recent first (-1 = end)
+    int32_t   prev, next;
+};
+
+class RTextureCache {
+    private:
+        rtexturecacheentry_t* entries;
+        uint32_t entryCount;
+        uint32_t entryCapacity;
+        // Open addressing hash table of entry indices (-1 = empty), power of 2 size
+        int32_t* slots;
+        uint32_t slotCount;
+
+        // LRU list ends
+        int32_t  head, tail;
+        uint32_t frame;
+
+        // Textures taken out of the cache while used this frame, deleted by nextFrame()
+        RTexture** retired;
+        uint32_t   retiredCount;
+        uint32_t   retiredCapacity;
+        size_t     retiredBytes;
+
+        rtexturecachestats_t stats;
+
+        // Entry index, -1 if not registered
+        int32_t find(uint64_t hash, const char* name) const;
+        int32_t insert(uint64_t hash, const char* name, Pixmap* source, uint32_t flags);
+        bool    growSlots();
+
+        void    unlink(int32_t index);
+        void    pushFront(int32_t index);
+
+        // Hit or miss, the texture is uploaded on a miss. Marks it used this frame
+        RTexture* use(int32_t index);
+        // Upload a texture, evicting others first. false if it cannot be loaded
+        bool    load(int32_t index);
+        // Not resident any more. Deleted now, or at nextFrame() if used this frame
+        void    evict(int32_t index);
+        void    deleteRetired();
+        // Evict least recently used textures (Not used this frame) until bytes more fit in the budget
+        void    makeRoom(size_t bytes);
+    public:
+        RTextureCache(uint64_t budget);
+        ~RTextureCache();
+
+        // Register an image file, loaded on first use. The file name is the asset name
+        int  add(const char* fileName, uint32_t flags);
+        // Register a pixmap (Copied, or shared if it is in shared mode). Kept to upload it again after eviction.
+        // Adding a registered name replaces its contents, the old texture is released
+        int  add(const char* name, const Pixmap& pixmap, uint32_t flags);
+
+        // Resident texture of an asset (Uploaded now on a miss). Unknown names are registered as image files.
+        // Valid until the end of the frame, get it again every frame. NULL if it cannot be loaded
+        RTexture* get(const char* name);
+        // Faster lookup by hash (See hash()). Only registered assets, NULL if not registered
+        RTexture* get(uint64_t hash);
+
+        bool contains(const char* name) const;
+        bool isResident(const char* name) const;
+
+        // Delete the texture of an asset (Uploaded again if used later). If it was used this frame
+        // it is deleted by nextFrame()
+        void release(const char* name);
+
+        // Budget in bytes. Textures not used this frame are evicted now if needed
+        void     setBudget(uint64_t budget);
+        uint64_t getBudget() const;
+
+        rtexturecachestats_t getStats() const;
+        void resetStats();
+
+        // Frame done (Its draws submitted), textures used in it can be evicted again and the
+        // released ones are deleted. Called from RGLES2::render()
+        void nextFrame();
+
+        // Delete every texture and asset
+        void clear();
+
+        // 64 bit FNV-1a hash of an asset name
+        static uint64_t hash(const char* name);
+        // Bytes of a texture, all mip levels when mipmaps is true
+        static size_t   textureBytes(int width, int height, int components, bool mipmaps);
+};
+
+#endif
@@ -7,26 +7,48 @@
  * 
  * @copyright Copyright (c) 2021
  * 
+ * Textured quads (Sprites, atlas regions), alpha blended.
+ * Vertices use the position + color + texcoord and texture unit layout, the color tints the texels.
+ * Up to getUnits() textures are bound at once, quads of different textures share the draw call.
  */
 
 #ifndef _ENYX_RGLES2_RTEXTUREPIPELINE_INCLUDED
 #define _ENYX_RGLES2_RTEXTUREPIPELINE_INCLUDED
 
+#include <GLES2/gl2.h>
+
 #include "RGLES2/RPipeline.h"
 #include "RGLES2/RShader.h"
+#include "RGLES2/RConstants.h"
 
 class RTexturePipeline : public RPipeline {
     private:
         RShader* internalShader;
+        // Textures sampled by the next draw, texture i on unit i
+        GLuint textures[TEXTURE_MAX_UNITS];
+        int    textureCount;
+        // Samplers of the shader (1 to TEXTURE_MAX_UNITS)
+        int    units;
     public:
-        RTexturePipeline();
+        // units: textures per draw call, clamped to 1 - TEXTURE_MAX_UNITS
+        RTexturePipeline(int units);
         ~RTexturePipeline();
 
         void enable();
         void disable();
         void setTransform(RMatrix4& matrix);
         void draw(void* buffer);
+
+        int  getVertexFormat() const;
+
+        // Unit of a texture in the next draw, a free unit is taken if it has none. -1 if every unit is taken
+        int  getTextureUnit(GLuint texture);
+        // Free every unit. Only with an empty draw buffer
+        void clearTextures();
+
+        int  getUnits()        const;
+        int  getTextureCount() const;
 };
 
 
-#endif
\ No newline at end of file
+#endif
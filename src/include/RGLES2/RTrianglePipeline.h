@@ -26,6 +26,8 @@ class RTrianglePipeline : public RPipeline {
         void disable();
         void setTransform(RMatrix4& matrix);
         void draw(void* buffer);
+
+        int  getVertexFormat() const;
 };
 
 #endif
\ No newline at end of file
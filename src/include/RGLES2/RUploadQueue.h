@@ -0,0 +1,100 @@
+/**
+ * @file RUploadQueue.h
+ * @author Brais Solla González
+ * @brief RUploadQueue / Incremental texture uploads for RGLES2
+ * @version 0.1
+ * @date 2021-12-09
+ * 
+ * @copyright Copyright (c) 2021
+ * 
+ * Large images are uploaded in bands of rows (RTexture::uploadPixels), a few every frame,
+ * so loading an atlas mid-game does not stall one frame with a huge glTexImage2D.
+ * At most the frame budget (Bytes) is uploaded per frame, at least one row.
+ * Until its upload is done a texture can be swapped for the placeholder (See ready()).
+ */
+
+#ifndef _ENYX_RGLES2_RUPLOADQUEUE_INCLUDED
+#define _ENYX_RGLES2_RUPLOADQUEUE_INCLUDED
+
+#include <stdint.h>
+#include <stddef.h>
+#include "AGL.h"
+#include "Pixmap.h"
+
+class RTexture;
+
+// Handle of an upload. 0 is never a valid handle
+typedef uint32_t rupload_t;
+
+// Called from process() / flush() when the last row of a texture is uploaded
+typedef void (*rupload_callback_t)(rupload_t upload, RTexture* texture, void* userdata);
+
+struct ruploadjob_t {
+    rupload_t          handle;
+    RTexture*          texture;
+    // Destination of the first row in the texture
+    int                px, py;
+    Pixmap*            pixmap;
+    // Rows already uploaded
+    int                rows;
+    rupload_callback_t callback;
+    void*              userdata;
+};
+
+class RUploadQueue {
+    private:
+        // FIFO, oldest upload first
+        ruploadjob_t* jobs;
+        uint32_t      jobCount;
+        uint32_t      jobCapacity;
+        rupload_t     nextHandle;
+
+        size_t        frameBudget;
+        RTexture*     placeholder;
+
+        rupload_t queue(RTexture* texture, int px, int py, Pixmap* pixmap, rupload_callback_t callback, void* userdata);
+        // Upload up to budget bytes of the first job. Returns the bytes uploaded
+        size_t    uploadRows(ruploadjob_t* job, size_t budget);
+        void      finish(uint32_t index);
+    public:
+        // frameBudget: bytes uploaded per process() call, 0 = no limit. Needs a GL context
+        RUploadQueue(size_t frameBudget);
+        ~RUploadQueue();
+
+        // Upload a pixmap into a new empty texture of its size, owned by the caller.
+        // The pixmap is copied (Or shared if it is in shared mode), moved with the && version
+        RTexture* createTexture(const Pixmap& pixmap, rupload_callback_t callback, void* userdata, rupload_t* handle);
+        RTexture* createTexture(Pixmap&& pixmap, rupload_callback_t callback, void* userdata, rupload_t* handle);
+
+        // Upload a pixmap at px, py of an existing texture. Returns the handle, 0 on error.
+        // Cancel the upload before deleting the texture
+        rupload_t upload(RTexture* texture, int px, int py, const Pixmap& pixmap, rupload_callback_t callback, void* userdata);
+        rupload_t upload(RTexture* texture, int px, int py, Pixmap&& pixmap, rupload_callback_t callback, void* userdata);
+
+        // Drop an upload not done yet (No callback, rows already uploaded stay)
+        void cancel(rupload_t upload);
+        bool isPending(rupload_t upload) const;
+        // A texture with uploads not done yet
+        bool isPending(const RTexture* texture) const;
+
+        // The texture, or the placeholder while it has pending uploads
+        const RTexture& ready(const RTexture& texture) const;
+        // 1x1 texture, drawn scaled instead of textures not uploaded yet
+        const RTexture& getPlaceholder() const;
+        void  setPlaceholderColor(color_t color);
+
+        // Upload the next rows within the frame budget. Called once per frame from RGLES2::render().
+        // Returns the bytes uploaded
+        size_t process();
+        // Upload everything now
+        size_t flush();
+
+        void   setFrameBudget(size_t bytes);
+        size_t getFrameBudget() const;
+
+        uint32_t getPending() const;
+        // Bytes still waiting to be uploaded
+        size_t   getPendingBytes() const;
+};
+
+#endif
@@ -0,0 +1,13 @@
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+varying vec4  v_color;
+varying float v_size;
+
+void main(){
+    // Round sprite, antialiased border
+    float distance = length(gl_PointCoord - vec2(0.5)) * v_size;
+    float coverage = clamp((v_size * 0.5) - distance + 0.5, 0.0, 1.0);
+    gl_FragColor   = vec4(v_color.rgb, v_color.a * coverage);
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+attribute vec3 a_vertex;
+attribute vec4 a_color;
+
+uniform mat4  u_tmtrx;
+// Size multiplier for every particle
+uniform float u_pointsize;
+
+varying vec4  v_color;
+varying float v_size;
+
+void main(){
+    // a_vertex.z is the particle size in pixels, not a depth
+    v_size       = a_vertex.z * u_pointsize;
+    v_color      = a_color;
+    gl_PointSize = v_size;
+    gl_Position  = u_tmtrx * vec4(a_vertex.xy, 0.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifdef GL_ES
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+#endif
+
+varying vec4 v_color;
+varying vec2 v_local;
+varying vec4 v_params;
+
+// Signed distance to a rounded rectangle (Circles are round rects with radius = half size)
+float roundRectDistance(vec2 p, vec2 size, float radius){
+    vec2 q = abs(p) - size + radius;
+    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - radius;
+}
+
+// Approximated signed distance to an ellipse
+float ellipseDistance(vec2 p, vec2 size){
+    float k0 = length(p / size);
+    float k1 = length(p / (size * size));
+    if(k1 == 0.0) return -min(size.x, size.y);
+    return k0 * (k0 - 1.0) / k1;
+}
+
+void main(){
+    float d;
+    if(v_params.z < 0.0){
+        d = ellipseDistance(v_local, v_params.xy);
+    } else {
+        d = roundRectDistance(v_local, v_params.xy, v_params.z);
+    }
+
+    // Outline, stroke inside the shape border
+    if(v_params.w > 0.0){
+        d = abs(d + v_params.w * 0.5) - v_params.w * 0.5;
+    }
+
+    // Distance is in pixels, one pixel antialiasing ramp
+    float coverage = clamp(0.5 - d, 0.0, 1.0);
+    gl_FragColor   = vec4(v_color.rgb, v_color.a * coverage);
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+attribute vec3 a_vertex;
+attribute vec4 a_color;
+// Position in pixels from the shape center
+attribute vec2 a_vtxcoord;
+// Half width, half height, corner radius (< 0, ellipse), stroke width. In pixels
+attribute vec4 a_params;
+
+uniform mat4 u_tmtrx;
+
+varying vec4 v_color;
+varying vec2 v_local;
+varying vec4 v_params;
+
+void main(){
+    v_color     = a_color;
+    v_local     = a_vtxcoord;
+    v_params    = a_params;
+    gl_Position = u_tmtrx * vec4(a_vertex.xyz,1.0);
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifdef GL_ES
+precision mediump float;
+#endif
+
+// Samplers in u_textures (1 to 8), defined before this source
+#ifndef TEXTURE_UNITS
+#define TEXTURE_UNITS 1
+#endif
+
+uniform sampler2D u_textures[TEXTURE_UNITS];
+
+varying vec4 v_color;
+// The alpha plane is half a texture away, mediump coordinates blur its hard edges
+#if defined(GL_ES) && defined(GL_FRAGMENT_PRECISION_HIGH)
+#define COORD_PRECISION highp
+#else
+#define COORD_PRECISION
+#endif
+varying COORD_PRECISION vec3 v_vtxcoord;
+
+// ETC1 textures have no alpha, it is stored gray in the bottom half (See ETC1.h)
+vec4 fetch(sampler2D unitSampler, COORD_PRECISION vec2 coord, bool alphaPlane){
+    vec4 texel = texture2D(unitSampler, coord);
+    if(alphaPlane) texel.a = texture2D(unitSampler, coord + vec2(0.0, 0.5)).g;
+    return texel;
+}
+
+void main(){
+    // Samplers can only be indexed by constants, the unit is picked by branches.
+    // Every vertex of a quad has the same unit, all fragments take the same branch.
+    // Units from 8 (TEXTURE_MAX_UNITS) up are textures with an alpha plane
+    float unit       = v_vtxcoord.z;
+    bool  alphaPlane = unit > 7.5;
+    vec4  texel;
+
+    if(alphaPlane) unit -= 8.0;
+
+    if(unit < 0.5) texel = fetch(u_textures[0], v_vtxcoord.xy, alphaPlane);
+#if TEXTURE_UNITS > 1
+    else if(unit < 1.5) texel = fetch(u_textures[1], v_vtxcoord.xy, alphaPlane);
+#endif
+#if TEXTURE_UNITS > 2
+    else if(unit < 2.5) texel = fetch(u_textures[2], v_vtxcoord.xy, alphaPlane);
+#endif
+#if TEXTURE_UNITS > 3
+    else if(unit < 3.5) texel = fetch(u_textures[3], v_vtxcoord.xy, alphaPlane);
+#endif
+#if TEXTURE_UNITS > 4
+    else if(unit < 4.5) texel = fetch(u_textures[4], v_vtxcoord.xy, alphaPlane);
+#endif
+#if TEXTURE_UNITS > 5
+    else if(unit < 5.5) texel = fetch(u_textures[5], v_vtxcoord.xy, alphaPlane);
+#endif
+#if TEXTURE_UNITS > 6
+    else if(unit < 6.5) texel = fetch(u_textures[6], v_vtxcoord.xy, alphaPlane);
+#endif
+#if TEXTURE_UNITS > 7
+    else if(unit < 7.5) texel = fetch(u_textures[7], v_vtxcoord.xy, alphaPlane);
+#endif
+    else texel = vec4(1.0, 0.0, 1.0, 1.0);
+
+    gl_FragColor = v_color * texel;
+}
\ No newline at end of file
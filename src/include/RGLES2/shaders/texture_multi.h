@@ -0,0 +1,208 @@
+const char texture_multi_vert[] = {
+  0x61, 0x74, 0x74, 0x72, 0x69, 0x62, 0x75, 0x74, 0x65, 0x20, 0x76, 0x65,
+  0x63, 0x33, 0x20, 0x61, 0x5f, 0x76, 0x65, 0x72, 0x74, 0x65, 0x78, 0x3b,
+  0x0a, 0x61, 0x74, 0x74, 0x72, 0x69, 0x62, 0x75, 0x74, 0x65, 0x20, 0x76,
+  0x65, 0x63, 0x34, 0x20, 0x61, 0x5f, 0x63, 0x6f, 0x6c, 0x6f, 0x72, 0x3b,
+  0x0a, 0x2f, 0x2f, 0x20, 0x73, 0x2c, 0x20, 0x74, 0x2c, 0x20, 0x74, 0x65,
+  0x78, 0x74, 0x75, 0x72, 0x65, 0x20, 0x75, 0x6e, 0x69, 0x74, 0x0a, 0x61,
+  0x74, 0x74, 0x72, 0x69, 0x62, 0x75, 0x74, 0x65, 0x20, 0x76, 0x65, 0x63,
+  0x33, 0x20, 0x61, 0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64,
+  0x3b, 0x0a, 0x0a, 0x75, 0x6e, 0x69, 0x66, 0x6f, 0x72, 0x6d, 0x20, 0x6d,
+  0x61, 0x74, 0x34, 0x20, 0x75, 0x5f, 0x74, 0x6d, 0x74, 0x72, 0x78, 0x3b,
+  0x0a, 0x0a, 0x76, 0x61, 0x72, 0x79, 0x69, 0x6e, 0x67, 0x20, 0x76, 0x65,
+  0x63, 0x34, 0x20, 0x76, 0x5f, 0x63, 0x6f, 0x6c, 0x6f, 0x72, 0x3b, 0x0a,
+  0x76, 0x61, 0x72, 0x79, 0x69, 0x6e, 0x67, 0x20, 0x76, 0x65, 0x63, 0x33,
+  0x20, 0x76, 0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x3b,
+  0x0a, 0x0a, 0x76, 0x6f, 0x69, 0x64, 0x20, 0x6d, 0x61, 0x69, 0x6e, 0x28,
+  0x29, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x76, 0x5f, 0x63, 0x6f, 0x6c,
+  0x6f, 0x72, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3d, 0x20, 0x61, 0x5f, 0x63,
+  0x6f, 0x6c, 0x6f, 0x72, 0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x76, 0x5f,
+  0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x20, 0x20, 0x3d, 0x20,
+  0x61, 0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x3b, 0x0a,
+  0x20, 0x20, 0x20, 0x20, 0x67, 0x6c, 0x5f, 0x50, 0x6f, 0x73, 0x69, 0x74,
+  0x69, 0x6f, 0x6e, 0x20, 0x3d, 0x20, 0x75, 0x5f, 0x74, 0x6d, 0x74, 0x72,
+  0x78, 0x20, 0x2a, 0x20, 0x76, 0x65, 0x63, 0x34, 0x28, 0x61, 0x5f, 0x76,
+  0x65, 0x72, 0x74, 0x65, 0x78, 0x2e, 0x78, 0x79, 0x7a, 0x2c, 0x31, 0x2e,
+  0x30, 0x29, 0x3b, 0x0a, 0x7d, 0x00
+};
+
+const char texture_multi_frag[] = {
+  0x23, 0x69, 0x66, 0x64, 0x65, 0x66, 0x20, 0x47, 0x4c, 0x5f, 0x45, 0x53,
+  0x0a, 0x70, 0x72, 0x65, 0x63, 0x69, 0x73, 0x69, 0x6f, 0x6e, 0x20, 0x6d,
+  0x65, 0x64, 0x69, 0x75, 0x6d, 0x70, 0x20, 0x66, 0x6c, 0x6f, 0x61, 0x74,
+  0x3b, 0x0a, 0x23, 0x65, 0x6e, 0x64, 0x69, 0x66, 0x0a, 0x0a, 0x2f, 0x2f,
+  0x20, 0x53, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x72, 0x73, 0x20, 0x69, 0x6e,
+  0x20, 0x75, 0x5f, 0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 0x20,
+  0x28, 0x31, 0x20, 0x74, 0x6f, 0x20, 0x38, 0x29, 0x2c, 0x20, 0x64, 0x65,
+  0x66, 0x69, 0x6e, 0x65, 0x64, 0x20, 0x62, 0x65, 0x66, 0x6f, 0x72, 0x65,
+  0x20, 0x74, 0x68, 0x69, 0x73, 0x20, 0x73, 0x6f, 0x75, 0x72, 0x63, 0x65,
+  0x0a, 0x23, 0x69, 0x66, 0x6e, 0x64, 0x65, 0x66, 0x20, 0x54, 0x45, 0x58,
+  0x54, 0x55, 0x52, 0x45, 0x5f, 0x55, 0x4e, 0x49, 0x54, 0x53, 0x0a, 0x23,
+  0x64, 0x65, 0x66, 0x69, 0x6e, 0x65, 0x20, 0x54, 0x45, 0x58, 0x54, 0x55,
+  0x52, 0x45, 0x5f, 0x55, 0x4e, 0x49, 0x54, 0x53, 0x20, 0x31, 0x0a, 0x23,
+  0x65, 0x6e, 0x64, 0x69, 0x66, 0x0a, 0x0a, 0x75, 0x6e, 0x69, 0x66, 0x6f,
+  0x72, 0x6d, 0x20, 0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x72, 0x32, 0x44,
+  0x20, 0x75, 0x5f, 0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 0x5b,
+  0x54, 0x45, 0x58, 0x54, 0x55, 0x52, 0x45, 0x5f, 0x55, 0x4e, 0x49, 0x54,
+  0x53, 0x5d, 0x3b, 0x0a, 0x0a, 0x76, 0x61, 0x72, 0x79, 0x69, 0x6e, 0x67,
+  0x20, 0x76, 0x65, 0x63, 0x34, 0x20, 0x76, 0x5f, 0x63, 0x6f, 0x6c, 0x6f,
+  0x72, 0x3b, 0x0a, 0x2f, 0x2f, 0x20, 0x54, 0x68, 0x65, 0x20, 0x61, 0x6c,
+  0x70, 0x68, 0x61, 0x20, 0x70, 0x6c, 0x61, 0x6e, 0x65, 0x20, 0x69, 0x73,
+  0x20, 0x68, 0x61, 0x6c, 0x66, 0x20, 0x61, 0x20, 0x74, 0x65, 0x78, 0x74,
+  0x75, 0x72, 0x65, 0x20, 0x61, 0x77, 0x61, 0x79, 0x2c, 0x20, 0x6d, 0x65,
+  0x64, 0x69, 0x75, 0x6d, 0x70, 0x20, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x69,
+  0x6e, 0x61, 0x74, 0x65, 0x73, 0x20, 0x62, 0x6c, 0x75, 0x72, 0x20, 0x69,
+  0x74, 0x73, 0x20, 0x68, 0x61, 0x72, 0x64, 0x20, 0x65, 0x64, 0x67, 0x65,
+  0x73, 0x0a, 0x23, 0x69, 0x66, 0x20, 0x64, 0x65, 0x66, 0x69, 0x6e, 0x65,
+  0x64, 0x28, 0x47, 0x4c, 0x5f, 0x45, 0x53, 0x29, 0x20, 0x26, 0x26, 0x20,
+  0x64, 0x65, 0x66, 0x69, 0x6e, 0x65, 0x64, 0x28, 0x47, 0x4c, 0x5f, 0x46,
+  0x52, 0x41, 0x47, 0x4d, 0x45, 0x4e, 0x54, 0x5f, 0x50, 0x52, 0x45, 0x43,
+  0x49, 0x53, 0x49, 0x4f, 0x4e, 0x5f, 0x48, 0x49, 0x47, 0x48, 0x29, 0x0a,
+  0x23, 0x64, 0x65, 0x66, 0x69, 0x6e, 0x65, 0x20, 0x43, 0x4f, 0x4f, 0x52,
+  0x44, 0x5f, 0x50, 0x52, 0x45, 0x43, 0x49, 0x53, 0x49, 0x4f, 0x4e, 0x20,
+  0x68, 0x69, 0x67, 0x68, 0x70, 0x0a, 0x23, 0x65, 0x6c, 0x73, 0x65, 0x0a,
+  0x23, 0x64, 0x65, 0x66, 0x69, 0x6e, 0x65, 0x20, 0x43, 0x4f, 0x4f, 0x52,
+  0x44, 0x5f, 0x50, 0x52, 0x45, 0x43, 0x49, 0x53, 0x49, 0x4f, 0x4e, 0x0a,
+  0x23, 0x65, 0x6e, 0x64, 0x69, 0x66, 0x0a, 0x76, 0x61, 0x72, 0x79, 0x69,
+  0x6e, 0x67, 0x20, 0x43, 0x4f, 0x4f, 0x52, 0x44, 0x5f, 0x50, 0x52, 0x45,
+  0x43, 0x49, 0x53, 0x49, 0x4f, 0x4e, 0x20, 0x76, 0x65, 0x63, 0x33, 0x20,
+  0x76, 0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x3b, 0x0a,
+  0x0a, 0x2f, 0x2f, 0x20, 0x45, 0x54, 0x43, 0x31, 0x20, 0x74, 0x65, 0x78,
+  0x74, 0x75, 0x72, 0x65, 0x73, 0x20, 0x68, 0x61, 0x76, 0x65, 0x20, 0x6e,
+  0x6f, 0x20, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x2c, 0x20, 0x69, 0x74, 0x20,
+  0x69, 0x73, 0x20, 0x73, 0x74, 0x6f, 0x72, 0x65, 0x64, 0x20, 0x67, 0x72,
+  0x61, 0x79, 0x20, 0x69, 0x6e, 0x20, 0x74, 0x68, 0x65, 0x20, 0x62, 0x6f,
+  0x74, 0x74, 0x6f, 0x6d, 0x20, 0x68, 0x61, 0x6c, 0x66, 0x20, 0x28, 0x53,
+  0x65, 0x65, 0x20, 0x45, 0x54, 0x43, 0x31, 0x2e, 0x68, 0x29, 0x0a, 0x76,
+  0x65, 0x63, 0x34, 0x20, 0x66, 0x65, 0x74, 0x63, 0x68, 0x28, 0x73, 0x61,
+  0x6d, 0x70, 0x6c, 0x65, 0x72, 0x32, 0x44, 0x20, 0x75, 0x6e, 0x69, 0x74,
+  0x53, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x72, 0x2c, 0x20, 0x43, 0x4f, 0x4f,
+  0x52, 0x44, 0x5f, 0x50, 0x52, 0x45, 0x43, 0x49, 0x53, 0x49, 0x4f, 0x4e,
+  0x20, 0x76, 0x65, 0x63, 0x32, 0x20, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x2c,
+  0x20, 0x62, 0x6f, 0x6f, 0x6c, 0x20, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x50,
+  0x6c, 0x61, 0x6e, 0x65, 0x29, 0x7b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x76,
+  0x65, 0x63, 0x34, 0x20, 0x74, 0x65, 0x78, 0x65, 0x6c, 0x20, 0x3d, 0x20,
+  0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x32, 0x44, 0x28, 0x75, 0x6e,
+  0x69, 0x74, 0x53, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x72, 0x2c, 0x20, 0x63,
+  0x6f, 0x6f, 0x72, 0x64, 0x29, 0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x69,
+  0x66, 0x28, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x50, 0x6c, 0x61, 0x6e, 0x65,
+  0x29, 0x20, 0x74, 0x65, 0x78, 0x65, 0x6c, 0x2e, 0x61, 0x20, 0x3d, 0x20,
+  0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x32, 0x44, 0x28, 0x75, 0x6e,
+  0x69, 0x74, 0x53, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x72, 0x2c, 0x20, 0x63,
+  0x6f, 0x6f, 0x72, 0x64, 0x20, 0x2b, 0x20, 0x76, 0x65, 0x63, 0x32, 0x28,
+  0x30, 0x2e, 0x30, 0x2c, 0x20, 0x30, 0x2e, 0x35, 0x29, 0x29, 0x2e, 0x67,
+  0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x72, 0x65, 0x74, 0x75, 0x72, 0x6e,
+  0x20, 0x74, 0x65, 0x78, 0x65, 0x6c, 0x3b, 0x0a, 0x7d, 0x0a, 0x0a, 0x76,
+  0x6f, 0x69, 0x64, 0x20, 0x6d, 0x61, 0x69, 0x6e, 0x28, 0x29, 0x7b, 0x0a,
+  0x20, 0x20, 0x20, 0x20, 0x2f, 0x2f, 0x20, 0x53, 0x61, 0x6d, 0x70, 0x6c,
+  0x65, 0x72, 0x73, 0x20, 0x63, 0x61, 0x6e, 0x20, 0x6f, 0x6e, 0x6c, 0x79,
+  0x20, 0x62, 0x65, 0x20, 0x69, 0x6e, 0x64, 0x65, 0x78, 0x65, 0x64, 0x20,
+  0x62, 0x79, 0x20, 0x63, 0x6f, 0x6e, 0x73, 0x74, 0x61, 0x6e, 0x74, 0x73,
+  0x2c, 0x20, 0x74, 0x68, 0x65, 0x20, 0x75, 0x6e, 0x69, 0x74, 0x20, 0x69,
+  0x73, 0x20, 0x70, 0x69, 0x63, 0x6b, 0x65, 0x64, 0x20, 0x62, 0x79, 0x20,
+  0x62, 0x72, 0x61, 0x6e, 0x63, 0x68, 0x65, 0x73, 0x2e, 0x0a, 0x20, 0x20,
+  0x20, 0x20, 0x2f, 0x2f, 0x20, 0x45, 0x76, 0x65, 0x72, 0x79, 0x20, 0x76,
+  0x65, 0x72, 0x74, 0x65, 0x78, 0x20, 0x6f, 0x66, 0x20, 0x61, 0x20, 0x71,
+  0x75, 0x61, 0x64, 0x20, 0x68, 0x61, 0x73, 0x20, 0x74, 0x68, 0x65, 0x20,
+  0x73, 0x61, 0x6d, 0x65, 0x20, 0x75, 0x6e, 0x69, 0x74, 0x2c, 0x20, 0x61,
+  0x6c, 0x6c, 0x20, 0x66, 0x72, 0x61, 0x67, 0x6d, 0x65, 0x6e, 0x74, 0x73,
+  0x20, 0x74, 0x61, 0x6b, 0x65, 0x20, 0x74, 0x68, 0x65, 0x20, 0x73, 0x61,
+  0x6d, 0x65, 0x20, 0x62, 0x72, 0x61, 0x6e, 0x63, 0x68, 0x2e, 0x0a, 0x20,
+  0x20, 0x20, 0x20, 0x2f, 0x2f, 0x20, 0x55, 0x6e, 0x69, 0x74, 0x73, 0x20,
+  0x66, 0x72, 0x6f, 0x6d, 0x20, 0x38, 0x20, 0x28, 0x54, 0x45, 0x58, 0x54,
+  0x55, 0x52, 0x45, 0x5f, 0x4d, 0x41, 0x58, 0x5f, 0x55, 0x4e, 0x49, 0x54,
+  0x53, 0x29, 0x20, 0x75, 0x70, 0x20, 0x61, 0x72, 0x65, 0x20, 0x74, 0x65,
+  0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 0x20, 0x77, 0x69, 0x74, 0x68, 0x20,
+  0x61, 0x6e, 0x20, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x20, 0x70, 0x6c, 0x61,
+  0x6e, 0x65, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x66, 0x6c, 0x6f, 0x61, 0x74,
+  0x20, 0x75, 0x6e, 0x69, 0x74, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+  0x3d, 0x20, 0x76, 0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64,
+  0x2e, 0x7a, 0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x62, 0x6f, 0x6f, 0x6c,
+  0x20, 0x20, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x50, 0x6c, 0x61, 0x6e, 0x65,
+  0x20, 0x3d, 0x20, 0x75, 0x6e, 0x69, 0x74, 0x20, 0x3e, 0x20, 0x37, 0x2e,
+  0x35, 0x3b, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x76, 0x65, 0x63, 0x34, 0x20,
+  0x20, 0x74, 0x65, 0x78, 0x65, 0x6c, 0x3b, 0x0a, 0x0a, 0x20, 0x20, 0x20,
+  0x20, 0x69, 0x66, 0x28, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x50, 0x6c, 0x61,
+  0x6e, 0x65, 0x29, 0x20, 0x75, 0x6e, 0x69, 0x74, 0x20, 0x2d, 0x3d, 0x20,
+  0x38, 0x2e, 0x30, 0x3b, 0x0a, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x69, 0x66,
+  0x28, 0x75, 0x6e, 0x69, 0x74, 0x20, 0x3c, 0x20, 0x30, 0x2e, 0x35, 0x29,
+  0x20, 0x74, 0x65, 0x78, 0x65, 0x6c, 0x20, 0x3d, 0x20, 0x66, 0x65, 0x74,
+  0x63, 0x68, 0x28, 0x75, 0x5f, 0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65,
+  0x73, 0x5b, 0x30, 0x5d, 0x2c, 0x20, 0x76, 0x5f, 0x76, 0x74, 0x78, 0x63,
+  0x6f, 0x6f, 0x72, 0x64, 0x2e, 0x78, 0x79, 0x2c, 0x20, 0x61, 0x6c, 0x70,
+  0x68, 0x61, 0x50, 0x6c, 0x61, 0x6e, 0x65, 0x29, 0x3b, 0x0a, 0x23, 0x69,
+  0x66, 0x20, 0x54, 0x45, 0x58, 0x54, 0x55, 0x52, 0x45, 0x5f, 0x55, 0x4e,
+  0x49, 0x54, 0x53, 0x20, 0x3e, 0x20, 0x31, 0x0a, 0x20, 0x20, 0x20, 0x20,
+  0x65, 0x6c, 0x73, 0x65, 0x20, 0x69, 0x66, 0x28, 0x75, 0x6e, 0x69, 0x74,
+  0x20, 0x3c, 0x20, 0x31, 0x2e, 0x35, 0x29, 0x20, 0x74, 0x65, 0x78, 0x65,
+  0x6c, 0x20, 0x3d, 0x20, 0x66, 0x65, 0x74, 0x63, 0x68, 0x28, 0x75, 0x5f,
+  0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 0x5b, 0x31, 0x5d, 0x2c,
+  0x20, 0x76, 0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x2e,
+  0x78, 0x79, 0x2c, 0x20, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x50, 0x6c, 0x61,
+  0x6e, 0x65, 0x29, 0x3b, 0x0a, 0x23, 0x65, 0x6e, 0x64, 0x69, 0x66, 0x0a,
+  0x23, 0x69, 0x66, 0x20, 0x54, 0x45, 0x58, 0x54, 0x55, 0x52, 0x45, 0x5f,
+  0x55, 0x4e, 0x49, 0x54, 0x53, 0x20, 0x3e, 0x20, 0x32, 0x0a, 0x20, 0x20,
+  0x20, 0x20, 0x65, 0x6c, 0x73, 0x65, 0x20, 0x69, 0x66, 0x28, 0x75, 0x6e,
+  0x69, 0x74, 0x20, 0x3c, 0x20, 0x32, 0x2e, 0x35, 0x29, 0x20, 0x74, 0x65,
+  0x78, 0x65, 0x6c, 0x20, 0x3d, 0x20, 0x66, 0x65, 0x74, 0x63, 0x68, 0x28,
+  0x75, 0x5f, 0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 0x5b, 0x32,
+  0x5d, 0x2c, 0x20, 0x76, 0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72,
+  0x64, 0x2e, 0x78, 0x79, 0x2c, 0x20, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x50,
+  0x6c, 0x61, 0x6e, 0x65, 0x29, 0x3b, 0x0a, 0x23, 0x65, 0x6e, 0x64, 0x69,
+  0x66, 0x0a, 0x23, 0x69, 0x66, 0x20, 0x54, 0x45, 0x58, 0x54, 0x55, 0x52,
+  0x45, 0x5f, 0x55, 0x4e, 0x49, 0x54, 0x53, 0x20, 0x3e, 0x20, 0x33, 0x0a,
+  0x20, 0x20, 0x20, 0x20, 0x65, 0x6c, 0x73, 0x65, 0x20, 0x69, 0x66, 0x28,
+  0x75, 0x6e, 0x69, 0x74, 0x20, 0x3c, 0x20, 0x33, 0x2e, 0x35, 0x29, 0x20,
+  0x74, 0x65, 0x78, 0x65, 0x6c, 0x20, 0x3d, 0x20, 0x66, 0x65, 0x74, 0x63,
+  0x68, 0x28, 0x75, 0x5f, 0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73,
+  0x5b, 0x33, 0x5d, 0x2c, 0x20, 0x76, 0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f,
+  0x6f, 0x72, 0x64, 0x2e, 0x78, 0x79, 0x2c, 0x20, 0x61, 0x6c, 0x70, 0x68,
+  0x61, 0x50, 0x6c, 0x61, 0x6e, 0x65, 0x29, 0x3b, 0x0a, 0x23, 0x65, 0x6e,
+  0x64, 0x69, 0x66, 0x0a, 0x23, 0x69, 0x66, 0x20, 0x54, 0x45, 0x58, 0x54,
+  0x55, 0x52, 0x45, 0x5f, 0x55, 0x4e, 0x49, 0x54, 0x53, 0x20, 0x3e, 0x20,
+  0x34, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x65, 0x6c, 0x73, 0x65, 0x20, 0x69,
+  0x66, 0x28, 0x75, 0x6e, 0x69, 0x74, 0x20, 0x3c, 0x20, 0x34, 0x2e, 0x35,
+  0x29, 0x20, 0x74, 0x65, 0x78, 0x65, 0x6c, 0x20, 0x3d, 0x20, 0x66, 0x65,
+  0x74, 0x63, 0x68, 0x28, 0x75, 0x5f, 0x74, 0x65, 0x78, 0x74, 0x75, 0x72,
+  0x65, 0x73, 0x5b, 0x34, 0x5d, 0x2c, 0x20, 0x76, 0x5f, 0x76, 0x74, 0x78,
+  0x63, 0x6f, 0x6f, 0x72, 0x64, 0x2e, 0x78, 0x79, 0x2c, 0x20, 0x61, 0x6c,
+  0x70, 0x68, 0x61, 0x50, 0x6c, 0x61, 0x6e, 0x65, 0x29, 0x3b, 0x0a, 0x23,
+  0x65, 0x6e, 0x64, 0x69, 0x66, 0x0a, 0x23, 0x69, 0x66, 0x20, 0x54, 0x45,
+  0x58, 0x54, 0x55, 0x52, 0x45, 0x5f, 0x55, 0x4e, 0x49, 0x54, 0x53, 0x20,
+  0x3e, 0x20, 0x35, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x65, 0x6c, 0x73, 0x65,
+  0x20, 0x69, 0x66, 0x28, 0x75, 0x6e, 0x69, 0x74, 0x20, 0x3c, 0x20, 0x35,
+  0x2e, 0x35, 0x29, 0x20, 0x74, 0x65, 0x78, 0x65, 0x6c, 0x20, 0x3d, 0x20,
+  0x66, 0x65, 0x74, 0x63, 0x68, 0x28, 0x75, 0x5f, 0x74, 0x65, 0x78, 0x74,
+  0x75, 0x72, 0x65, 0x73, 0x5b, 0x35, 0x5d, 0x2c, 0x20, 0x76, 0x5f, 0x76,
+  0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x2e, 0x78, 0x79, 0x2c, 0x20,
+  0x61, 0x6c, 0x70, 0x68, 0x61, 0x50, 0x6c, 0x61, 0x6e, 0x65, 0x29, 0x3b,
+  0x0a, 0x23, 0x65, 0x6e, 0x64, 0x69, 0x66, 0x0a, 0x23, 0x69, 0x66, 0x20,
+  0x54, 0x45, 0x58, 0x54, 0x55, 0x52, 0x45, 0x5f, 0x55, 0x4e, 0x49, 0x54,
+  0x53, 0x20, 0x3e, 0x20, 0x36, 0x0a, 0x20, 0x20, 0x20, 0x20, 0x65, 0x6c,
+  0x73, 0x65, 0x20, 0x69, 0x66, 0x28, 0x75, 0x6e, 0x69, 0x74, 0x20, 0x3c,
+  0x20, 0x36, 0x2e, 0x35, 0x29, 0x20, 0x74, 0x65, 0x78, 0x65, 0x6c, 0x20,
+  0x3d, 0x20, 0x66, 0x65, 0x74, 0x63, 0x68, 0x28, 0x75, 0x5f, 0x74, 0x65,
+  0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 0x5b, 0x36, 0x5d, 0x2c, 0x20, 0x76,
+  0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x2e, 0x78, 0x79,
+  0x2c, 0x20, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x50, 0x6c, 0x61, 0x6e, 0x65,
+  0x29, 0x3b, 0x0a, 0x23, 0x65, 0x6e, 0x64, 0x69, 0x66, 0x0a, 0x23, 0x69,
+  0x66, 0x20, 0x54, 0x45, 0x58, 0x54, 0x55, 0x52, 0x45, 0x5f, 0x55, 0x4e,
+  0x49, 0x54, 0x53, 0x20, 0x3e, 0x20, 0x37, 0x0a, 0x20, 0x20, 0x20, 0x20,
+  0x65, 0x6c, 0x73, 0x65, 0x20, 0x69, 0x66, 0x28, 0x75, 0x6e, 0x69, 0x74,
+  0x20, 0x3c, 0x20, 0x37, 0x2e, 0x35, 0x29, 0x20, 0x74, 0x65, 0x78, 0x65,
+  0x6c, 0x20, 0x3d, 0x20, 0x66, 0x65, 0x74, 0x63, 0x68, 0x28, 0x75, 0x5f,
+  0x74, 0x65, 0x78, 0x74, 0x75, 0x72, 0x65, 0x73, 0x5b, 0x37, 0x5d, 0x2c,
+  0x20, 0x76, 0x5f, 0x76, 0x74, 0x78, 0x63, 0x6f, 0x6f, 0x72, 0x64, 0x2e,
+  0x78, 0x79, 0x2c, 0x20, 0x61, 0x6c, 0x70, 0x68, 0x61, 0x50, 0x6c, 0x61,
+  0x6e, 0x65, 0x29, 0x3b, 0x0a, 0x23, 0x65, 0x6e, 0x64, 0x69, 0x66, 0x0a,
+  0x20, 0x20, 0x20, 0x20, 0x65, 0x6c, 0x73, 0x65, 0x20, 0x74, 0x65, 0x78,
+  0x65, 0x6c, 0x20, 0x3d, 0x20, 0x76, 0x65, 0x63, 0x34, 0x28, 0x31, 0x2e,
+  0x30, 0x2c, 0x20, 0x30, 0x2e, 0x30, 0x2c, 0x20, 0x31, 0x2e, 0x30, 0x2c,
+  0x20, 0x31, 0x2e, 0x30, 0x29, 0x3b, 0x0a, 0x0a, 0x20, 0x20, 0x20, 0x20,
+  0x67, 0x6c, 0x5f, 0x46, 0x72, 0x61, 0x67, 0x43, 0x6f, 0x6c, 0x6f, 0x72,
+  0x20, 0x3d, 0x20, 0x76, 0x5f, 0x63, 0x6f, 0x6c, 0x6f, 0x72, 0x20, 0x2a,
+  0x20, 0x74, 0x65, 0x78, 0x65, 0x6c, 0x3b, 0x0a, 0x7d, 0x00
+};
+
+const unsigned int texture_multi_vert_len = 294;
+const unsigned int texture_multi_frag_len = 2098;
@@ -0,0 +1,15 @@
+attribute vec3 a_vertex;
+attribute vec4 a_color;
+// s, t, texture unit
+attribute vec3 a_vtxcoord;
+
+uniform mat4 u_tmtrx;
+
+varying vec4 v_color;
+varying vec3 v_vtxcoord;
+
+void main(){
+    v_color     = a_color;
+    v_vtxcoord  = a_vtxcoord;
+    gl_Position = u_tmtrx * vec4(a_vertex.xyz,1.0);
+}
\ No newline at end of file
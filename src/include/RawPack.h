@@ -0,0 +1,129 @@
+/**
+ * @file RawPack.h
+ * @author Brais Solla González
+ * @brief Raw (Pre-decoded) image pack format, loader and writer for Enyx
+ * @version 0.1
+ * @date 2021-12-06
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * A pack holds many images already decoded to 8 bit pixels, written by tools/Image2Raw.
+ * The file is memory mapped and uncompressed images are uploaded straight from the mapping,
+ * so shipped assets skip PNG / JPEG decoding at startup.
+ *
+ * Layout (Little endian):
+ *   rawpack_header_t
+ *   rawpack_entry_t[count]   (Directory, at header.directory)
+ *   Image data, every image starts at a multiple of header.alignment.
+ *   Mip levels follow each other, level 0 first, tightly packed rows.
+ *   Images with RAWPACK_FLAG_LZ4 are stored as one LZ4 block (All levels).
+ *   Images with RAWPACK_FLAG_ETC1 store ETC1 blocks (See ETC1.h, written by tools/Image2ETC1):
+ *   3 components, or 4 with the alpha plane (One level only).
+ */
+
+#ifndef _RAWPACK_INCLUDED
+#define _RAWPACK_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "ImageDriver.h"
+
+#define RAWPACK_MAGIC      "ERPK"
+#define RAWPACK_VERSION    1
+#define RAWPACK_NAME_SIZE  48
+// Default image data alignment (Bytes)
+#define RAWPACK_ALIGNMENT  16
+
+enum RAWPACK_FLAGS {
+    // Data is an LZ4 block
+    RAWPACK_FLAG_LZ4  = (1 << 0),
+    // Levels are ETC1 blocks
+    RAWPACK_FLAG_ETC1 = (1 << 1)
+};
+
+struct rawpack_header_t {
+    char     magic[4];
+    uint32_t version;
+    // Images in the directory
+    uint32_t count;
+    // Image data alignment in the file (Power of 2)
+    uint32_t alignment;
+    // File offset of the directory
+    uint64_t directory;
+    uint64_t reserved;
+};
+
+struct rawpack_entry_t {
+    // NUL terminated
+    char     name[RAWPACK_NAME_SIZE];
+    uint32_t width, height;
+    uint8_t  components;
+    // Mip levels stored (1 = no mipmaps)
+    uint8_t  mips;
+    // RAWPACK_FLAGS
+    uint8_t  flags;
+    uint8_t  reserved[5];
+    // File offset and bytes of the stored data
+    uint64_t offset;
+    uint64_t size;
+    // Bytes of all the levels, decompressed
+    uint64_t raw_size;
+};
+
+static_assert(sizeof(rawpack_header_t) == 32, "rawpack_header_t must be 32 bytes");
+static_assert(sizeof(rawpack_entry_t)  == 88, "rawpack_entry_t must be 88 bytes");
+
+// Image given to RawPack::write (Tools)
+struct rawpack_image_t {
+    // offset is filled by write()
+    rawpack_entry_t entry;
+    // Stored data, entry.size bytes (malloc)
+    uint8_t*        data;
+};
+
+// Read only pack (Memory mapped)
+class RawPack {
+    private:
+        imagemapping_t          mapping;
+        const rawpack_header_t* header;
+        const rawpack_entry_t*  entries;
+    public:
+        RawPack();
+        RawPack(const char* fileName);
+        ~RawPack();
+
+        // 0 on success. The pack is checked before use
+        int  open(const char* fileName);
+        void close();
+        bool isOpen() const;
+
+        int  getCount() const;
+        // Index of an image, -1 if not in the pack
+        int  find(const char* name) const;
+        const rawpack_entry_t* getEntry(int index) const;
+
+        // All the mip levels of an image, level 0 first. Uncompressed images point into the mapping (Nothing copied),
+        // compressed images are decompressed to a new buffer. Both are released with releasePixels()
+        const uint8_t* acquirePixels(int index) const;
+        void           releasePixels(int index, const uint8_t* pixels) const;
+
+        // Size / offset (From level 0) of a mip level in bytes (Stored bytes of ETC1 levels)
+        static size_t levelSize  (const rawpack_entry_t* entry, int level);
+        static size_t levelOffset(const rawpack_entry_t* entry, int level);
+
+        // LZ4 block format. compress returns the bytes written (0 = does not fit in capacity)
+        static size_t compressBound(size_t size);
+        static size_t compress  (const void* src, size_t size, void* dest, size_t capacity);
+        // true if src decodes to exactly size bytes
+        static bool   decompress(const void* src, size_t src_size, void* dest, size_t size);
+
+        // Writing (tools/Image2Raw, tools/Image2ETC1). Name an entry after a file (Folders dropped), false if too long
+        static bool   setName(rawpack_entry_t* entry, const char* path);
+        // LZ4 compress the stored data, kept as it is when that does not save space
+        static void   compressImage(rawpack_image_t* image);
+        // Header, directory and aligned data of count images. Names must be unique. 0 on success
+        static int    write(rawpack_image_t* images, int count, uint32_t alignment, FILE* file);
+};
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file SIMD.h
+ * @author Brais Solla González
+ * @brief SIMD instruction set detection for Enyx
+ * @version 0.1
+ * @date 2021-12-02
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Every SIMD code path must have a scalar fallback.
+ * Build with -DENYX_NO_SIMD to force the scalar code paths.
+ */
+
+#ifndef _ENYX_SIMD_INCLUDED
+#define _ENYX_SIMD_INCLUDED
+
+#ifndef ENYX_NO_SIMD
+
+// x86 / x86_64
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define ENYX_SIMD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Byte shuffles (pshufb)
+#if defined(__SSSE3__)
+#define ENYX_SIMD_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define ENYX_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+// ARM / AArch64
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ENYX_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#endif
+
+#if defined(ENYX_SIMD_SSE2) || defined(ENYX_SIMD_NEON)
+#define ENYX_SIMD 1
+#endif
+
+// Name of the SIMD code path in use (For logs and benchmarks)
+#if defined(ENYX_SIMD_AVX2)
+#define ENYX_SIMD_NAME "AVX2"
+#elif defined(ENYX_SIMD_SSSE3)
+#define ENYX_SIMD_NAME "SSSE3"
+#elif defined(ENYX_SIMD_SSE2)
+#define ENYX_SIMD_NAME "SSE2"
+#elif defined(ENYX_SIMD_NEON)
+#define ENYX_SIMD_NAME "NEON"
+#else
+#define ENYX_SIMD_NAME "Scalar"
+#endif
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * @file rawpacktool.h
+ * @author Brais Solla González
+ * @brief Options and output shared by the raw pack tools (Image2Raw, Image2ETC1)
+ * @version 0.1
+ * @date 2021-12-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * The pack itself is written by RawPack::write (See RawPack.h), the tools only encode images.
+ */
+
+#ifndef _RAWPACKTOOL_INCLUDED
+#define _RAWPACKTOOL_INCLUDED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "RawPack.h"
+
+#define RAWPACKTOOL_MAX_IMAGES 4096
+
+// Options of every pack tool
+struct rawpacktool_options_t {
+    bool        mips;
+    bool        lz4;
+    uint32_t    alignment;
+    const char* output;
+
+    const char* inputs[RAWPACKTOOL_MAX_IMAGES];
+    int         count;
+};
+
+static void rawpacktool_init(rawpacktool_options_t* options){
+    memset(options, 0, sizeof(rawpacktool_options_t));
+    options->alignment = RAWPACK_ALIGNMENT;
+}
+
+// Parse argv[*i] if it is a common option or an input image. false if the tool has to handle it
+static bool rawpacktool_parse(rawpacktool_options_t* options, int argc, char* argv[], int* i){
+    const char* arg = argv[*i];
+
+    if(strcmp(arg, "-mips") == 0){
+        options->mips = true;
+    } else if(strcmp(arg, "-lz4") == 0){
+        options->lz4 = true;
+    } else if(strcmp(arg, "-align") == 0 && *i + 1 < argc){
+        options->alignment = (uint32_t) atoi(argv[++(*i)]);
+    } else if(strcmp(arg, "-o") == 0 && *i + 1 < argc){
+        options->output = argv[++(*i)];
+    } else if(arg[0] == '-'){
+        return false;
+    } else if(options->count < RAWPACKTOOL_MAX_IMAGES){
+        options->inputs[options->count++] = arg;
+    }
+    return true;
+}
+
+// Write the pack and free the image data. 0 on success
+static int rawpacktool_write(const rawpacktool_options_t* options, rawpack_image_t* images, int count){
+    FILE* file = fopen(options->output, "wb");
+    if(file == NULL){
+        fprintf(stderr, "Error: Cannot create %s\n", options->output);
+        return -4;
+    }
+
+    int  result = RawPack::write(images, count, options->alignment, file);
+    long size   = ftell(file);
+    if(fclose(file) != 0 && result == 0) result = 3;
+
+    for(int i = 0; i < count; i++) free(images[i].data);
+
+    if(result != 0){
+        fprintf(stderr, "Error: Cannot write %s\n", options->output);
+        remove(options->output);
+        return -4;
+    }
+
+    fprintf(stderr, "Pack %s written: %d images, %ld bytes\n", options->output, count, size);
+    return 0;
+}
+
+#endif
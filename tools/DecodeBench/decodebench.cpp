@@ -0,0 +1,175 @@
+/**
+ * @file decodebench.cpp
+ * @author Brais Solla González
+ * @brief Image decoding throughput benchmark for Enyx
+ * @version 0.1
+ * @date 2021-12-05
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Decodes the sample assets in fonts/ and synthetic 2048x2048 JPEG / PNG images with ImageDriver,
+ * reports MB/s of decoded pixels. Build (from this folder):
+ *   g++ -O2 -pthread -I../../src/include -o decodebench decodebench.cpp ../../src/ImageDriver.cpp ../../src/Debug.cpp
+ * Add -DENYX_STBI_NO_SIMD to benchmark the scalar decoder, or pass image files to decode them instead of fonts/.
+ * ImageDriver logs every load on stdout, results are printed on stderr.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "ImageDriver.h"
+
+#define SYNTHETIC_SIZE 2048
+#define SYNTHETIC_JPG  "decodebench_synthetic.jpg"
+#define SYNTHETIC_PNG  "decodebench_synthetic.png"
+#define FONTS_PATH     "../../fonts"
+#define MAX_FILES      64
+#define BENCH_RUNS     5
+
+static double now_ms(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+static long file_size(const char* fileName){
+    struct stat st;
+    if(stat(fileName, &st) != 0) return -1;
+    return (long) st.st_size;
+}
+
+// Best of BENCH_RUNS decodes of one file. Returns the decoded bytes, 0 on error
+static size_t bench_file(const char* fileName, double* best_ms){
+    size_t bytes = 0;
+    for(int r = 0; r < BENCH_RUNS; r++){
+        int w, h, n;
+
+        double   start = now_ms();
+        uint8_t* px    = ImageDriver::loadImage(fileName, &w, &h, &n);
+        double   time  = now_ms() - start;
+
+        if(px == NULL) return 0;
+        ImageDriver::freeImage(px);
+
+        bytes = (size_t) w * h * n;
+        if(r == 0 || time < *best_ms) *best_ms = time;
+    }
+    return bytes;
+}
+
+static void report(const char* fileName, size_t bytes, double ms){
+    long input = file_size(fileName);
+    fprintf(stderr, "%-44s %8.1f KB in %8.1f KB out %9.2f ms %9.1f MB/s\n", fileName, input / 1024.0, bytes / 1024.0, ms, (bytes / (1024.0 * 1024.0)) / (ms / 1000.0));
+}
+
+// Smooth gradients with some noise, so both encoders have real work to do
+static uint8_t* synthetic_image(int size){
+    uint8_t* px = (uint8_t*) malloc((size_t) size * size * 3);
+    if(px == NULL) return NULL;
+
+    srand(1);
+    for(int y = 0; y < size; y++){
+        for(int x = 0; x < size; x++){
+            uint8_t* p = px + ((size_t) y * size + x) * 3;
+            int noise  = rand() % 16;
+            p[0] = (uint8_t) ((x * 255) / size + noise);
+            p[1] = (uint8_t) ((y * 255) / size + noise);
+            p[2] = (uint8_t) (((x ^ y) & 0xff) / 2 + noise);
+        }
+    }
+    return px;
+}
+
+static int compare_names(const void* a, const void* b){
+    return strcmp(*(const char**) a, *(const char**) b);
+}
+
+// Images in FONTS_PATH and its folders
+static int find_fonts(char** files, int max){
+    const char* folders[] = {FONTS_PATH "/alpha", FONTS_PATH "/bmp"};
+    int count = 0;
+
+    for(size_t f = 0; f < sizeof(folders) / sizeof(folders[0]); f++){
+        DIR* dir = opendir(folders[f]);
+        if(dir == NULL) continue;
+
+        struct dirent* entry;
+        while((entry = readdir(dir)) != NULL && count < max){
+            if(entry->d_name[0] == '.') continue;
+
+            size_t len = strlen(folders[f]) + strlen(entry->d_name) + 2;
+            files[count] = (char*) malloc(len);
+            snprintf(files[count], len, "%s/%s", folders[f], entry->d_name);
+            count++;
+        }
+        closedir(dir);
+    }
+
+    qsort(files, count, sizeof(char*), compare_names);
+    return count;
+}
+
+int main(int argc, char* argv[]){
+    char*  files[MAX_FILES];
+    int    count = 0;
+    double ms    = 0.0;
+    size_t total_bytes = 0;
+    double total_ms    = 0.0;
+
+    fprintf(stderr, "Enyx image decoding benchmark (%s decoder, best of %d runs)\n\n", ImageDriver::getDecoderSIMD(), BENCH_RUNS);
+
+    if(argc > 1){
+        for(int i = 1; i < argc && count < MAX_FILES; i++) files[count++] = strdup(argv[i]);
+    } else {
+        count = find_fonts(files, MAX_FILES);
+        if(count == 0) fprintf(stderr, "No images found in %s, run from tools/DecodeBench\n", FONTS_PATH);
+    }
+
+    for(int i = 0; i < count; i++){
+        size_t bytes = bench_file(files[i], &ms);
+        if(bytes == 0){
+            fprintf(stderr, "%-44s cannot decode\n", files[i]);
+        } else {
+            report(files[i], bytes, ms);
+            total_bytes += bytes;
+            total_ms    += ms;
+        }
+        free(files[i]);
+    }
+
+    if(argc <= 1){
+        // Synthetic images: large JPEG (IDCT / colour conversion) and PNG (zlib / filters)
+        uint8_t* px = synthetic_image(SYNTHETIC_SIZE);
+        if(px == NULL){
+            fprintf(stderr, "Error: Not enough memory\n");
+            return -1;
+        }
+
+        const char* synthetic[] = {SYNTHETIC_JPG, SYNTHETIC_PNG};
+        ImageDriver::writeImage(SYNTHETIC_JPG, SYNTHETIC_SIZE, SYNTHETIC_SIZE, 3, px, 90);
+        ImageDriver::writeImage(SYNTHETIC_PNG, SYNTHETIC_SIZE, SYNTHETIC_SIZE, 3, px);
+        free(px);
+
+        for(int i = 0; i < 2; i++){
+            size_t bytes = bench_file(synthetic[i], &ms);
+            if(bytes == 0){
+                fprintf(stderr, "%-44s cannot decode\n", synthetic[i]);
+            } else {
+                report(synthetic[i], bytes, ms);
+                total_bytes += bytes;
+                total_ms    += ms;
+            }
+            remove(synthetic[i]);
+        }
+    }
+
+    if(total_ms > 0.0){
+        fprintf(stderr, "\nTotal %.1f MB decoded in %.2f ms, %.1f MB/s\n", total_bytes / (1024.0 * 1024.0), total_ms, (total_bytes / (1024.0 * 1024.0)) / (total_ms / 1000.0));
+    }
+    return 0;
+}
@@ -0,0 +1,363 @@
+/**
+ * @file image2etc1.cpp
+ * @author Brais Solla González
+ * @brief Image2ETC1 Tool for Enyx
+ * @version 0.1
+ * @date 2021-12-10
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * This tool encodes images to ETC1 (See ETC1.h) and writes them to a raw pack (See RawPack.h).
+ * Images with alpha get an alpha plane. -verify decodes every image again and checks its PSNR,
+ * -test runs the encoder / decoder round trip on generated images (No files needed).
+ * Build (from this folder):
+ *   g++ -O2 -pthread -I../../src/include -o image2etc1 image2etc1.cpp ../../src/ETC1.cpp ../../src/RawPack.cpp ../../src/ImageDriver.cpp ../../src/Debug.cpp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "ImageDriver.h"
+#include "RawPack.h"
+#include "ETC1.h"
+#include "../Common/rawpacktool.h"
+
+// Default minimum PSNR (dB) of -verify
+#define DEFAULT_MIN_PSNR 30.0
+
+struct psnr_t {
+    double color;
+    // Images with alpha only (INFINITY otherwise)
+    double alpha;
+};
+
+static void usage(const char* name){
+    fprintf(stderr, "Usage: %s [-mips] [-lz4] [-high] [-verify] [-psnr dB] [-align bytes] -o pack.raw image.png [image.jpg ...]\n", name);
+    fprintf(stderr, "       %s -test [-high]\n", name);
+    fprintf(stderr, "  -mips    Store the mip levels (Down to 1x1, images without alpha)\n");
+    fprintf(stderr, "  -lz4     LZ4 compress the blocks (Kept raw when it does not save space)\n");
+    fprintf(stderr, "  -high    Slower encoding, better quality\n");
+    fprintf(stderr, "  -verify  Decode the images again, fail when level 0 is under the minimum PSNR\n");
+    fprintf(stderr, "  -psnr    Minimum PSNR of -verify and -test (Default %.0f dB)\n", DEFAULT_MIN_PSNR);
+    fprintf(stderr, "  -align   Image data alignment in the pack, power of 2 (Default %d)\n", RAWPACK_ALIGNMENT);
+    fprintf(stderr, "  -test    Encode and decode generated images, check their PSNR\n");
+}
+
+static double to_psnr(double error, uint64_t samples){
+    if(error == 0.0) return INFINITY;
+    double mse = error / samples;
+    return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+// PSNR of decoded (ETC1::storedComponents(n) components) against the n component source
+static psnr_t image_psnr(const uint8_t* source, const uint8_t* decoded, int w, int h, int n){
+    int    stored      = ETC1::storedComponents(n);
+    double color_error = 0.0;
+    double alpha_error = 0.0;
+
+    for(size_t i = 0; i < (size_t) w * h; i++){
+        const uint8_t* s = source  + i * n;
+        const uint8_t* d = decoded + i * stored;
+
+        for(int c = 0; c < 3; c++){
+            // Gray images decode to R = G = B
+            double diff = (double) d[c] - (n < 3 ? s[0] : s[c]);
+            color_error += diff * diff;
+        }
+        if(stored == 4){
+            double diff = (double) d[3] - s[n - 1];
+            alpha_error += diff * diff;
+        }
+    }
+
+    psnr_t psnr;
+    psnr.color = to_psnr(color_error, (uint64_t) w * h * 3);
+    psnr.alpha = (stored == 4) ? to_psnr(alpha_error, (uint64_t) w * h) : INFINITY;
+    return psnr;
+}
+
+// Encode, decode and measure one image. Returns false on error
+static bool round_trip(const uint8_t* pixels, int w, int h, int n, int quality, psnr_t* psnr){
+    size_t   size    = ETC1::imageSize(w, h, n);
+    uint8_t* blocks  = (uint8_t*) malloc(size);
+    uint8_t* decoded = (uint8_t*) malloc((size_t) w * h * ETC1::storedComponents(n));
+
+    bool ok = blocks && decoded && ETC1::encode(pixels, w, h, n, 0, blocks, quality);
+    if(ok){
+        ETC1::decode(blocks, w, h, ETC1::storedComponents(n), decoded);
+        *psnr = image_psnr(pixels, decoded, w, h, n);
+    }
+
+    free(blocks);
+    free(decoded);
+    return ok;
+}
+
+// Decode an image and encode its levels. Returns false on error
+static bool convert_image(const char* fileName, bool mips, bool lz4, int quality, bool verify, double min_psnr, rawpack_image_t* image){
+    int w, h, n;
+    uint8_t* px = ImageDriver::loadImage(fileName, &w, &h, &n);
+    if(px == NULL){
+        fprintf(stderr, "Error: Image %s cannot be decoded\n", fileName);
+        return false;
+    }
+
+    rawpack_entry_t* entry = &image->entry;
+    memset(entry, 0, sizeof(rawpack_entry_t));
+    if(!RawPack::setName(entry, fileName)){
+        ImageDriver::freeImage(px);
+        return false;
+    }
+    const char* name = entry->name;
+    entry->width      = w;
+    entry->height     = h;
+    entry->components = ETC1::storedComponents(n);
+    entry->mips       = 1;
+    entry->flags      = RAWPACK_FLAG_ETC1;
+
+    if(mips && entry->components == 4){
+        fprintf(stderr, "Warning: %s has alpha, the alpha plane is stored without mip levels\n", name);
+        mips = false;
+    }
+
+    // Source levels, n components
+    uint8_t* levels = px;
+    if(mips){
+        imageresize_t options = ImageDriver::resizeOptions(n);
+        options.flags |= IMAGE_RESIZE_SRGB;
+
+        int count = 0;
+        levels = ImageDriver::buildMipChain(px, w, h, n, &count, &options);
+        entry->mips = count;
+
+        if(levels == NULL){
+            fprintf(stderr, "Error: Cannot build the levels of %s\n", fileName);
+            ImageDriver::freeImage(px);
+            return false;
+        }
+    }
+    entry->raw_size = RawPack::levelOffset(entry, entry->mips);
+
+    uint8_t* blocks = (uint8_t*) malloc(entry->raw_size);
+    bool     ok     = blocks != NULL;
+    for(int level = 0; level < entry->mips && ok; level++){
+        int lw = w >> level;
+        int lh = h >> level;
+        if(lw == 0) lw = 1;
+        if(lh == 0) lh = 1;
+
+        const uint8_t* source = levels + ImageDriver::getMipOffset(w, h, n, level);
+        uint8_t*       dest   = blocks + RawPack::levelOffset(entry, level);
+        ok = ETC1::encode(source, lw, lh, n, 0, dest, quality);
+
+        if(ok && verify){
+            uint8_t* decoded = (uint8_t*) malloc((size_t) lw * lh * entry->components);
+            if(decoded == NULL){
+                ok = false;
+                break;
+            }
+            ETC1::decode(dest, lw, lh, entry->components, decoded);
+            psnr_t psnr = image_psnr(source, decoded, lw, lh, n);
+            free(decoded);
+
+            fprintf(stderr, "  %s level %d (%dx%d): color %.2f dB", name, level, lw, lh, psnr.color);
+            if(entry->components == 4) fprintf(stderr, ", alpha %.2f dB", psnr.alpha);
+            fprintf(stderr, "\n");
+
+            // Small levels are mostly detail, only reported
+            if(level == 0 && (psnr.color < min_psnr || psnr.alpha < min_psnr)){
+                fprintf(stderr, "Error: %s level %d is under %.2f dB\n", name, level, min_psnr);
+                ok = false;
+            }
+        }
+    }
+
+    if(levels != px) free(levels);
+    ImageDriver::freeImage(px);
+
+    if(!ok){
+        fprintf(stderr, "Error: Cannot encode %s\n", fileName);
+        free(blocks);
+        return false;
+    }
+
+    image->data = blocks;
+    entry->size = entry->raw_size;
+
+    if(lz4) RawPack::compressImage(image);
+
+    fprintf(stderr, "Image %s (%dx%dx%d), %d levels, %lu bytes -> %lu bytes%s\n", name, w, h, n, entry->mips,
+        (unsigned long) ImageDriver::getMipOffset(w, h, n, entry->mips), (unsigned long) entry->size, (entry->flags & RAWPACK_FLAG_LZ4) ? " (LZ4)" : "");
+    return true;
+}
+
+// Generated test image of n components
+static uint8_t* test_image(int kind, int w, int h, int n){
+    uint8_t* px = (uint8_t*) malloc((size_t) w * h * n);
+    if(px == NULL) return NULL;
+
+    uint32_t seed = 12345;
+    for(int y = 0; y < h; y++){
+        for(int x = 0; x < w; x++){
+            uint8_t* p = px + ((size_t) y * w + x) * n;
+            int value[4];
+
+            switch(kind){
+                case 0:
+                    // Flat color
+                    value[0] = 0x88; value[1] = 0x44; value[2] = 0xcc; value[3] = 0xff;
+                    break;
+                case 1:
+                    // Smooth gradients (Same slope at every size)
+                    value[0] = x * 3;
+                    value[1] = y * 3;
+                    value[2] = (x + y) * 2;
+                    value[3] = 255 - x * 2;
+                    break;
+                case 2:
+                    // Smooth shapes with mild noise (Photo like)
+                    seed = seed * 1103515245 + 12345;
+                    value[0] = (int) (128 + 100 * sin(x * 0.05) * cos(y * 0.07)) + (int) ((seed >> 16) & 7) - 4;
+                    value[1] = (int) (128 + 90 * sin((x + y) * 0.03)) + (int) ((seed >> 20) & 7) - 4;
+                    value[2] = (int) (128 + 80 * cos(x * 0.02 - y * 0.04));
+                    value[3] = ((x / 8 + y / 8) & 1) ? 255 : 0;
+                    break;
+                default:
+                    // Sprite: opaque disc over transparent texels
+                    {
+                        int dx = x - w / 2, dy = y - h / 2;
+                        bool inside = dx * dx + dy * dy < (w * w) / 9;
+                        value[0] = inside ? 220 : 0;
+                        value[1] = inside ? 180 : 0;
+                        value[2] = inside ? 40  : 0;
+                        value[3] = inside ? 255 : 0;
+                    }
+                    break;
+            }
+
+            for(int c = 0; c < 4; c++) value[c] = value[c] < 0 ? 0 : (value[c] > 255 ? 255 : value[c]);
+            if(n < 3){
+                p[0] = (uint8_t) value[0];
+                if(n == 2) p[1] = (uint8_t) value[3];
+            } else {
+                for(int c = 0; c < n; c++) p[c] = (uint8_t) value[c];
+            }
+        }
+    }
+    return px;
+}
+
+// Round trip of generated images. Returns the failed tests
+static int run_tests(int quality, double min_psnr){
+    static const char* kinds[] = {"flat", "gradient", "photo", "sprite"};
+    static const int   sizes[][2] = {{64, 64}, {1, 1}, {5, 3}, {17, 33}, {256, 128}};
+
+    int failed = 0;
+    int count  = 0;
+
+    for(int kind = 0; kind < 4; kind++){
+        for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+            for(int n = 1; n <= 4; n++){
+                int w = sizes[s][0];
+                int h = sizes[s][1];
+
+                uint8_t* px = test_image(kind, w, h, n);
+                psnr_t   psnr;
+                bool     ok = px && round_trip(px, w, h, n, quality, &psnr);
+                free(px);
+
+                // Flat colors are almost exact (Every texel gets a modifier, the base color is 4 or 5 bits).
+                // Hard edges (Two colors in a block) lose up to 10 dB more
+                double minimum = min_psnr;
+                if(kind == 0) minimum = min_psnr + 10.0;
+                if(kind == 3) minimum = min_psnr - 10.0;
+                bool   passed  = ok && psnr.color >= minimum && psnr.alpha >= minimum;
+
+                fprintf(stderr, "%s %-8s %3dx%-3d %d components: color %6.2f dB, alpha %6.2f dB\n",
+                    passed ? "PASS" : "FAIL", kinds[kind], w, h, n, ok ? psnr.color : 0.0, ok ? psnr.alpha : 0.0);
+
+                if(!passed) failed++;
+                count++;
+            }
+        }
+    }
+
+    // Every block mode decodes to what the encoder measured: re-encoding a decoded image is stable
+    uint8_t* px = test_image(2, 64, 64, 3);
+    if(px){
+        size_t   size     = ETC1::imageSize(64, 64, 3);
+        uint8_t* blocks   = (uint8_t*) malloc(size);
+        uint8_t* decoded  = (uint8_t*) malloc(64 * 64 * 3);
+        uint8_t* decoded2 = (uint8_t*) malloc(64 * 64 * 3);
+
+        bool passed = false;
+        if(blocks && decoded && decoded2){
+            ETC1::encode(px, 64, 64, 3, 0, blocks, quality);
+            ETC1::decode(blocks, 64, 64, 3, decoded);
+            ETC1::encode(decoded, 64, 64, 3, 0, blocks, quality);
+            ETC1::decode(blocks, 64, 64, 3, decoded2);
+            psnr_t psnr = image_psnr(decoded, decoded2, 64, 64, 3);
+            passed = psnr.color >= 40.0;
+            fprintf(stderr, "%s re-encode photo 64x64: %6.2f dB\n", passed ? "PASS" : "FAIL", psnr.color);
+        }
+        if(!passed) failed++;
+        count++;
+
+        free(blocks);
+        free(decoded);
+        free(decoded2);
+        free(px);
+    }
+
+    fprintf(stderr, "%d of %d tests passed\n", count - failed, count);
+    return failed;
+}
+
+int main(int argc, char* argv[]){
+    bool   verify   = false;
+    bool   test     = false;
+    int    quality  = ETC1_QUALITY_FAST;
+    double min_psnr = DEFAULT_MIN_PSNR;
+
+    rawpacktool_options_t options;
+    rawpacktool_init(&options);
+
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-high") == 0){
+            quality = ETC1_QUALITY_HIGH;
+        } else if(strcmp(argv[i], "-verify") == 0){
+            verify = true;
+        } else if(strcmp(argv[i], "-test") == 0){
+            test = true;
+        } else if(strcmp(argv[i], "-psnr") == 0 && i + 1 < argc){
+            min_psnr = atof(argv[++i]);
+        } else if(!rawpacktool_parse(&options, argc, argv, &i)){
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if(test) return run_tests(quality, min_psnr) == 0 ? 0 : -5;
+
+    if(options.output == NULL || options.count == 0){
+        usage(argv[0]);
+        return -1;
+    }
+
+    rawpack_image_t* images = (rawpack_image_t*) calloc(options.count, sizeof(rawpack_image_t));
+    if(images == NULL){
+        fprintf(stderr, "Error: Not enough memory\n");
+        return -2;
+    }
+
+    for(int i = 0; i < options.count; i++){
+        if(!convert_image(options.inputs[i], options.mips, options.lz4, quality, verify, min_psnr, &images[i])) return -3;
+    }
+
+    int result = rawpacktool_write(&options, images, options.count);
+    free(images);
+    return result;
+}
@@ -4,10 +4,12 @@
  * @brief Image2Raw Tool for Enyx
  * @version 0.1
  * @date 2021-11-19
- * 
+ *
  * @copyright Copyright (c) 2021
- * 
- * This tool converts image to raw bitstreams
+ *
+ * This tool converts images to a raw pack (See RawPack.h), loaded by the engine without decoding.
+ * Build (from this folder):
+ *   g++ -O2 -pthread -I../../src/include -o image2raw image2raw.cpp ../../src/RawPack.cpp ../../src/ETC1.cpp ../../src/ImageDriver.cpp ../../src/Debug.cpp
  */
 
 #include <stdio.h>
@@ -16,39 +18,95 @@
 #include <string.h>
 #include <math.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "ImageDriver.h"
+#include "RawPack.h"
+#include "../Common/rawpacktool.h"
 
-int main(int argc, char* argv[]){
-    if(argc < 2){
-        fprintf(stderr, "Usage: %s image.png > image.raw\n", argv[0]);
-        return -1;
+static void usage(const char* name){
+    fprintf(stderr, "Usage: %s [-mips] [-lz4] [-align bytes] -o pack.raw image.png [image.jpg ...]\n", name);
+    fprintf(stderr, "  -mips   Store the mip levels (Down to 1x1)\n");
+    fprintf(stderr, "  -lz4    LZ4 compress the pixels (Kept raw when it does not save space)\n");
+    fprintf(stderr, "  -align  Image data alignment in the pack, power of 2 (Default %d)\n", RAWPACK_ALIGNMENT);
+}
+
+// Decode an image and build its levels. Returns false on error
+static bool convert_image(const char* fileName, bool mips, bool lz4, rawpack_image_t* image){
+    int w, h, n;
+    uint8_t* px = ImageDriver::loadImage(fileName, &w, &h, &n);
+    if(px == NULL){
+        fprintf(stderr, "Error: Image %s cannot be decoded\n", fileName);
+        return false;
     }
 
-    int x,y,n;
-    int ok = stbi_info(argv[1], &x, &y, &n);
-    if(ok){
-        fprintf(stderr, "Image: %s\n", argv[1]);
-        fprintf(stderr, "Resolution: %dx%d, Channels: %d\n", x, y, n);
-    } else {
-        fprintf(stderr, "Error: Image %s cannot be opened or is not valid.\n", argv[1]);
-        return -2;
+    rawpack_entry_t* entry = &image->entry;
+    memset(entry, 0, sizeof(rawpack_entry_t));
+    if(!RawPack::setName(entry, fileName)){
+        ImageDriver::freeImage(px);
+        return false;
     }
+    entry->width      = w;
+    entry->height     = h;
+    entry->components = n;
+    entry->mips       = 1;
 
-    unsigned char *data = stbi_load(argv[1], &x, &y, &n, 0);
-    if(data){
-        size_t length = x * y * n;
-        fprintf(stderr,"Writing image %s (%dx%dx%d) (%d bytes)\n", argv[1], x, y, n, (int) length);
-        fwrite(data, 1, length, stdout);
-        fflush(stdout);
-        fprintf(stderr, "Image write completed!\n");
+    uint8_t* levels = NULL;
+    if(mips){
+        // sRGB and alpha aware filtering, bands resized in parallel
+        imageresize_t options = ImageDriver::resizeOptions(n);
+        options.flags |= IMAGE_RESIZE_SRGB;
+
+        int count = 0;
+        levels = ImageDriver::buildMipChain(px, w, h, n, &count, &options);
+        entry->mips = count;
     } else {
-        fprintf(stderr, "Error: Image %s cannot be decoded\n", argv[1]);
-        return -3;
+        levels = (uint8_t*) malloc((size_t) w * h * n);
+        if(levels) memcpy(levels, px, (size_t) w * h * n);
+    }
+    ImageDriver::freeImage(px);
+
+    if(levels == NULL){
+        fprintf(stderr, "Error: Cannot build the levels of %s\n", fileName);
+        return false;
     }
+    entry->raw_size   = RawPack::levelOffset(entry, entry->mips);
 
+    image->data = levels;
+    entry->size = entry->raw_size;
 
-    stbi_image_free(data);
-    return 0;
+    if(lz4) RawPack::compressImage(image);
+
+    fprintf(stderr, "Image %s (%dx%dx%d), %d levels, %lu bytes -> %lu bytes%s\n", entry->name, w, h, n, entry->mips,
+        (unsigned long) entry->raw_size, (unsigned long) entry->size, (entry->flags & RAWPACK_FLAG_LZ4) ? " (LZ4)" : "");
+    return true;
 }
 
+int main(int argc, char* argv[]){
+    rawpacktool_options_t options;
+    rawpacktool_init(&options);
+
+    for(int i = 1; i < argc; i++){
+        if(!rawpacktool_parse(&options, argc, argv, &i)){
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if(options.output == NULL || options.count == 0){
+        usage(argv[0]);
+        return -1;
+    }
+
+    rawpack_image_t* images = (rawpack_image_t*) calloc(options.count, sizeof(rawpack_image_t));
+    if(images == NULL){
+        fprintf(stderr, "Error: Not enough memory\n");
+        return -2;
+    }
+
+    for(int i = 0; i < options.count; i++){
+        if(!convert_image(options.inputs[i], options.mips, options.lz4, &images[i])) return -3;
+    }
+
+    int result = rawpacktool_write(&options, images, options.count);
+    free(images);
+    return result;
+}
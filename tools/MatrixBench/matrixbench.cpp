@@ -0,0 +1,237 @@
+/**
+ * @file matrixbench.cpp
+ * @author Brais Solla González
+ * @brief RMatrix4 / RMatrix3 microbenchmark for Enyx
+ * @version 0.1
+ * @date 2021-12-02
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Compares the SIMD matrix kernels against the old scalar code and checks results.
+ * Build (from this folder):
+ *   g++ -O2 -I../../src/include -o matrixbench matrixbench.cpp ../../src/RGLES2/RMatrix4.cpp ../../src/RGLES2/RMatrix3.cpp
+ * Add -DENYX_NO_SIMD to benchmark the scalar fallback.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "SIMD.h"
+#include "RGLES2/RMatrix4.h"
+#include "RGLES2/RMatrix3.h"
+
+#define MULTIPLY_ITERATIONS  10000000
+#define TRANSFORM_POINTS     4096
+#define TRANSFORM_ITERATIONS 20000
+#define BENCH_RUNS           5
+
+static double now_ms(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+// Reference code is kept out of line, like the library methods it is compared with
+
+// Old RMatrix4::operator*= code, hand written multiply-adds
+static __attribute__((noinline)) void reference_mat4(const float* a, const float* b, float* r){
+    r[0]  = a[0] * b[0]  + a[4] * b[1]  + a[8]  * b[2]  + a[12] * b[3];
+    r[1]  = a[1] * b[0]  + a[5] * b[1]  + a[9]  * b[2]  + a[13] * b[3];
+    r[2]  = a[2] * b[0]  + a[6] * b[1]  + a[10] * b[2]  + a[14] * b[3];
+    r[3]  = a[3] * b[0]  + a[7] * b[1]  + a[11] * b[2]  + a[15] * b[3];
+
+    r[4]  = a[0] * b[4]  + a[4] * b[5]  + a[8]  * b[6]  + a[12] * b[7];
+    r[5]  = a[1] * b[4]  + a[5] * b[5]  + a[9]  * b[6]  + a[13] * b[7];
+    r[6]  = a[2] * b[4]  + a[6] * b[5]  + a[10] * b[6]  + a[14] * b[7];
+    r[7]  = a[3] * b[4]  + a[7] * b[5]  + a[11] * b[6]  + a[15] * b[7];
+
+    r[8]  = a[0] * b[8]  + a[4] * b[9]  + a[8]  * b[10] + a[12] * b[11];
+    r[9]  = a[1] * b[8]  + a[5] * b[9]  + a[9]  * b[10] + a[13] * b[11];
+    r[10] = a[2] * b[8]  + a[6] * b[9]  + a[10] * b[10] + a[14] * b[11];
+    r[11] = a[3] * b[8]  + a[7] * b[9]  + a[11] * b[10] + a[15] * b[11];
+
+    r[12] = a[0] * b[12] + a[4] * b[13] + a[8]  * b[14] + a[12] * b[15];
+    r[13] = a[1] * b[12] + a[5] * b[13] + a[9]  * b[14] + a[13] * b[15];
+    r[14] = a[2] * b[12] + a[6] * b[13] + a[10] * b[14] + a[14] * b[15];
+    r[15] = a[3] * b[12] + a[7] * b[13] + a[11] * b[14] + a[15] * b[15];
+}
+
+// Old RMatrix3::operator*= code
+static __attribute__((noinline)) void reference_mat3(const float* a, const float* b, float* r){
+    r[0] = a[0] * b[0] + a[3] * b[1] + a[6] * b[2];
+    r[1] = a[1] * b[0] + a[4] * b[1] + a[7] * b[2];
+    r[2] = a[2] * b[0] + a[5] * b[1] + a[8] * b[2];
+
+    r[3] = a[0] * b[3] + a[3] * b[4] + a[6] * b[5];
+    r[4] = a[1] * b[3] + a[4] * b[4] + a[7] * b[5];
+    r[5] = a[2] * b[3] + a[5] * b[4] + a[8] * b[5];
+
+    r[6] = a[0] * b[6] + a[3] * b[7] + a[6] * b[8];
+    r[7] = a[1] * b[6] + a[4] * b[7] + a[7] * b[8];
+    r[8] = a[2] * b[6] + a[5] * b[7] + a[8] * b[8];
+}
+
+// Per point transform, what the batcher did before transformPoints()
+static __attribute__((noinline)) void reference_transform(const float* m, const float* in, float* out, size_t n){
+    for(size_t i = 0; i < n; i++){
+        float x = in[i*2 + 0];
+        float y = in[i*2 + 1];
+
+        out[i*2 + 0] = m[0] * x + m[3] * y + m[6];
+        out[i*2 + 1] = m[1] * x + m[4] * y + m[7];
+    }
+}
+
+static float max_error(const float* a, const float* b, size_t n){
+    float error = 0.f;
+    for(size_t i = 0; i < n; i++){
+        float d = fabsf(a[i] - b[i]);
+        if(d > error) error = d;
+    }
+    return error;
+}
+
+static void report(const char* name, double reference_ms, double simd_ms, float error){
+    printf("%-28s reference %9.2f ms   %-6s %9.2f ms   speedup %5.2fx   max error %g\n", name, reference_ms, ENYX_SIMD_NAME, simd_ms, reference_ms / simd_ms, error);
+}
+
+// Benchmark state
+static RMatrix4 step4, simd4;
+static RMatrix3 step3, simd3;
+static float    ref4[16], ref3[9];
+static RMatrix3 transform3;
+static RMatrix4 transform4;
+static float*   points;
+static float*   ref_out;
+static float*   out;
+// Keeps the compiler from removing the loops
+static volatile float sink = 0.f;
+
+// Multiplies are accumulated, so every iteration depends on the previous one
+static void bench_reference_mat4(){
+    float tmp[16];
+    for(int i = 0; i < MULTIPLY_ITERATIONS; i++){
+        reference_mat4(ref4, step4.e, tmp);
+        memcpy(ref4, tmp, sizeof(tmp));
+    }
+    sink += ref4[0];
+}
+
+static void bench_mat4(){
+    for(int i = 0; i < MULTIPLY_ITERATIONS; i++) simd4 *= step4;
+    sink += simd4.e[0];
+}
+
+static void bench_reference_mat3(){
+    float tmp[9];
+    for(int i = 0; i < MULTIPLY_ITERATIONS; i++){
+        reference_mat3(ref3, step3.e, tmp);
+        memcpy(ref3, tmp, sizeof(tmp));
+    }
+    sink += ref3[0];
+}
+
+static void bench_mat3(){
+    for(int i = 0; i < MULTIPLY_ITERATIONS; i++) simd3 *= step3;
+    sink += simd3.e[0];
+}
+
+static void bench_reference_transform(){
+    for(int i = 0; i < TRANSFORM_ITERATIONS; i++){
+        reference_transform(transform3.e, points, ref_out, TRANSFORM_POINTS);
+        sink += ref_out[i % TRANSFORM_POINTS];
+    }
+}
+
+static void bench_transform3(){
+    for(int i = 0; i < TRANSFORM_ITERATIONS; i++){
+        transform3.transformPoints(points, out, TRANSFORM_POINTS);
+        sink += out[i % TRANSFORM_POINTS];
+    }
+}
+
+static void bench_transform4(){
+    for(int i = 0; i < TRANSFORM_ITERATIONS; i++){
+        transform4.transformPoints(points, out, TRANSFORM_POINTS);
+        sink += out[i % TRANSFORM_POINTS];
+    }
+}
+
+// Best of BENCH_RUNS, less noise
+static double run(void (*bench)(void), void (*reset)(void)){
+    double best = 0.0;
+    for(int r = 0; r < BENCH_RUNS; r++){
+        if(reset) reset();
+
+        double start = now_ms();
+        bench();
+        double time  = now_ms() - start;
+
+        if(r == 0 || time < best) best = time;
+    }
+    return best;
+}
+
+static void reset_reference(){
+    RMatrix4 identity4;
+    RMatrix3 identity3;
+
+    identity4.loadIdentity();
+    identity3.loadIdentity();
+    memcpy(ref4, identity4.e, sizeof(ref4));
+    memcpy(ref3, identity3.e, sizeof(ref3));
+}
+
+static void reset_simd(){
+    simd4.loadIdentity();
+    simd3.loadIdentity();
+}
+
+int main(int argc, char* argv[]){
+    double reference_ms, simd_ms;
+
+    printf("Enyx matrix benchmark (%s code path, best of %d runs)\n\n", ENYX_SIMD_NAME, BENCH_RUNS);
+
+    step4 = RMatrix4::rotation(0.001f) * RMatrix4::translation(0.5f, -0.25f);
+    step3 = RMatrix3::rotation(0.001f) * RMatrix3::translation(0.5f, -0.25f);
+
+    reference_ms = run(bench_reference_mat4, reset_reference);
+    simd_ms      = run(bench_mat4, reset_simd);
+    report("RMatrix4 *=", reference_ms, simd_ms, max_error(ref4, simd4.e, 16));
+
+    reference_ms = run(bench_reference_mat3, reset_reference);
+    simd_ms      = run(bench_mat3, reset_simd);
+    report("RMatrix3 *=", reference_ms, simd_ms, max_error(ref3, simd3.e, 9));
+
+    // Batch transform
+    points  = (float*) malloc(TRANSFORM_POINTS * 2 * sizeof(float));
+    ref_out = (float*) malloc(TRANSFORM_POINTS * 2 * sizeof(float));
+    out     = (float*) malloc(TRANSFORM_POINTS * 2 * sizeof(float));
+    if(points == NULL || ref_out == NULL || out == NULL){
+        fprintf(stderr, "Error: Not enough memory\n");
+        return -1;
+    }
+
+    for(int i = 0; i < TRANSFORM_POINTS * 2; i++) points[i] = (float) (rand() % 1600) - 800.f;
+
+    transform3 = RMatrix3::translation(400.f, 300.f) * RMatrix3::rotation(0.7f) * RMatrix3::scaling(1.5f, 0.75f);
+    transform4 = RMatrix4::translation(400.f, 300.f) * RMatrix4::rotation(0.7f) * RMatrix4::scaling(1.5f, 0.75f);
+
+    reference_ms = run(bench_reference_transform, NULL);
+    simd_ms      = run(bench_transform3, NULL);
+    report("RMatrix3::transformPoints", reference_ms, simd_ms, max_error(ref_out, out, TRANSFORM_POINTS * 2));
+
+    simd_ms      = run(bench_transform4, NULL);
+    report("RMatrix4::transformPoints", reference_ms, simd_ms, max_error(ref_out, out, TRANSFORM_POINTS * 2));
+
+    printf("\n%d multiplies, %d x %d points (sink %g)\n", MULTIPLY_ITERATIONS, TRANSFORM_ITERATIONS, TRANSFORM_POINTS, (double) sink);
+
+    free(points);
+    free(ref_out);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,384 @@
+/**
+ * @file pixelbench.cpp
+ * @author Brais Solla González
+ * @brief Pixmap bulk operations benchmark for Enyx
+ * @version 0.1
+ * @date 2021-12-04
+ *
+ * @copyright Copyright (c) 2021
+ *
+ * Compares the PixelOps kernels and PixelSpan loops against the old per pixel Pixmap code on 4K images and checks results.
+ * Also checks PixmapView::blit clipping (Offsets partly outside the destination).
+ * Build (from this folder):
+ *   g++ -O2 -pthread -I../../src/include -o pixelbench pixelbench.cpp ../../src/PixelOps.cpp ../../src/PixmapView.cpp ../../src/Pixmap.cpp ../../src/ImageDriver.cpp ../../src/RawPack.cpp ../../src/ETC1.cpp ../../src/Debug.cpp
+ * Add -mavx2 for the AVX2 kernels, -mssse3 for the SSSE3 conversions or -DENYX_NO_SIMD for the scalar fallback.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "AGL.h"
+#include "SIMD.h"
+#include "PixelOps.h"
+#include "PixelFormat.h"
+#include "PixmapView.h"
+
+#define IMAGE_WIDTH  3840
+#define IMAGE_HEIGHT 2160
+#define IMAGE_PIXELS (IMAGE_WIDTH * IMAGE_HEIGHT)
+#define BENCH_RUNS   5
+
+static double now_ms(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1000.0) + (ts.tv_nsec / 1000000.0);
+}
+
+// Old Pixmap code: a switch on the components for every pixel, through color_t.
+// Kept out of line, like the Pixmap methods they replace
+struct image_t {
+    uint8_t* px;
+    int width, height, components;
+};
+
+static __attribute__((noinline)) color_t reference_getPixel(const image_t* image, int px, int py){
+    if(px < 0 || px >= image->width || py < 0 || py >= image->height) return 0;
+
+    int offset = (image->components * image->width * py) + (image->components * px);
+    switch(image->components){
+        case 1:  return RGB(image->px[offset + 0], 0, 0);
+        case 2:  return RGB(image->px[offset + 0], image->px[offset + 1], 0);
+        case 3:  return RGB(image->px[offset + 0], image->px[offset + 1], image->px[offset + 2]);
+        case 4:  return RGBA(image->px[offset + 0], image->px[offset + 1], image->px[offset + 2], image->px[offset + 3]);
+        default: return 0;
+    }
+}
+
+static __attribute__((noinline)) void reference_setPixel(image_t* image, int px, int py, color_t color){
+    int offset = (image->components * image->width * py) + (image->components * px);
+    switch(image->components){
+        case 1:
+            image->px[offset + 0] = R(color);
+            break;
+        case 2:
+            image->px[offset + 0] = R(color);
+            image->px[offset + 1] = G(color);
+            break;
+        case 3:
+            image->px[offset + 0] = R(color);
+            image->px[offset + 1] = G(color);
+            image->px[offset + 2] = B(color);
+            break;
+        case 4:
+            image->px[offset + 0] = R(color);
+            image->px[offset + 1] = G(color);
+            image->px[offset + 2] = B(color);
+            image->px[offset + 3] = A(color);
+            break;
+    }
+}
+
+// Old Pixmap::fill
+static __attribute__((noinline)) void reference_fill(image_t* image, color_t color){
+    int size = image->width * image->height * image->components;
+    switch(image->components){
+        case 1:
+            memset(image->px, R(color), size);
+            break;
+        case 3:
+            for(int i = 0; i < size; i += 3){
+                image->px[i + 0] = R(color);
+                image->px[i + 1] = G(color);
+                image->px[i + 2] = B(color);
+            }
+            break;
+        case 4:
+            for(int i = 0; i < size; i += 4){
+                image->px[i + 0] = R(color);
+                image->px[i + 1] = G(color);
+                image->px[i + 2] = B(color);
+                image->px[i + 3] = A(color);
+            }
+            break;
+    }
+}
+
+// Old Pixmap::flipHorizontally / flipVertically, with the off by one fixed
+static __attribute__((noinline)) void reference_flip_rows(image_t* image){
+    for(int y = 0; y < (image->height >> 1); y++){
+        for(int x = 0; x < image->width; x++){
+            color_t px1 = reference_getPixel(image, x, y);
+            color_t px2 = reference_getPixel(image, x, image->height - 1 - y);
+
+            reference_setPixel(image, x, y, px2);
+            reference_setPixel(image, x, image->height - 1 - y, px1);
+        }
+    }
+}
+
+static __attribute__((noinline)) void reference_mirror_rows(image_t* image){
+    for(int y = 0; y < image->height; y++){
+        for(int x = 0; x < (image->width >> 1); x++){
+            color_t px1 = reference_getPixel(image, x, y);
+            color_t px2 = reference_getPixel(image, image->width - 1 - x, y);
+
+            reference_setPixel(image, x, y, px2);
+            reference_setPixel(image, image->width - 1 - x, y, px1);
+        }
+    }
+}
+
+// What a blit looked like without kernels: getPixel, blend, setPixel
+static uint8_t div255(uint32_t x){
+    x += 128;
+    return (uint8_t) ((x + (x >> 8)) >> 8);
+}
+
+static __attribute__((noinline)) void reference_blit(image_t* dest, const image_t* src){
+    for(int y = 0; y < src->height; y++){
+        for(int x = 0; x < src->width; x++){
+            color_t s = reference_getPixel(src, x, y);
+            color_t d = reference_getPixel(dest, x, y);
+
+            uint32_t a   = (s >> 0) & 0xff;
+            uint32_t inv = 255 - a;
+
+            color_t color = RGBA(div255(((s >> 24) & 0xff) * a + ((d >> 24) & 0xff) * inv),
+                                 div255(((s >> 16) & 0xff) * a + ((d >> 16) & 0xff) * inv),
+                                 div255(((s >> 8)  & 0xff) * a + ((d >> 8)  & 0xff) * inv),
+                                 div255(255 * a + ((d >> 0) & 0xff) * inv));
+            reference_setPixel(dest, x, y, color);
+        }
+    }
+}
+
+// RGB to RGBA through getPixel / setPixel
+static __attribute__((noinline)) void reference_convert(image_t* dest, const image_t* src){
+    for(int y = 0; y < src->height; y++){
+        for(int x = 0; x < src->width; x++){
+            reference_setPixel(dest, x, y, reference_getPixel(src, x, y));
+        }
+    }
+}
+
+// Test.cpp colour invert through getPixel / setPixel
+static __attribute__((noinline)) void reference_invert(image_t* image){
+    for(int y = 0; y < image->height; y++){
+        for(int x = 0; x < image->width; x++){
+            color_t px = reference_getPixel(image, x, y);
+            px = (px ^ 0xffffff00) | 0xff;
+            reference_setPixel(image, x, y, px);
+        }
+    }
+}
+
+static image_t new_image(int components){
+    image_t image;
+    image.width      = IMAGE_WIDTH;
+    image.height     = IMAGE_HEIGHT;
+    image.components = components;
+    image.px         = (uint8_t*) malloc(IMAGE_PIXELS * components);
+    if(image.px == NULL){
+        fprintf(stderr, "Error: Not enough memory\n");
+        exit(-1);
+    }
+    return image;
+}
+
+static void random_image(image_t* image, unsigned int seed){
+    srand(seed);
+    for(int i = 0; i < IMAGE_PIXELS * image->components; i++) image->px[i] = (uint8_t) rand();
+}
+
+static void report(const char* name, double reference_ms, double kernel_ms, bool same){
+    printf("%-24s reference %9.2f ms   %-6s %8.2f ms   speedup %6.2fx   %s\n", name, reference_ms, ENYX_SIMD_NAME, kernel_ms, reference_ms / kernel_ms, same ? "OK" : "MISMATCH");
+}
+
+// Benchmark state
+static image_t rgba_a, rgba_b, rgb, src;
+static volatile uint8_t sink = 0;
+
+// Best of BENCH_RUNS, less noise
+static double run(void (*bench)(void), void (*reset)(void)){
+    double best = 0.0;
+    for(int r = 0; r < BENCH_RUNS; r++){
+        if(reset) reset();
+
+        double start = now_ms();
+        bench();
+        double time  = now_ms() - start;
+
+        if(r == 0 || time < best) best = time;
+    }
+    return best;
+}
+
+static void reset_a(){ random_image(&rgba_a, 1); }
+static void reset_b(){ random_image(&rgba_b, 1); }
+
+static void bench_reference_fill(){ reference_fill(&rgba_a, RGBA(10, 20, 30, 40)); sink += rgba_a.px[7]; }
+static void bench_fill(){
+    uint8_t pixel[4] = {10, 20, 30, 40};
+    PixelOps::fill(rgba_b.px, pixel, 4, IMAGE_PIXELS);
+    sink += rgba_b.px[7];
+}
+
+static void bench_reference_fill3(){ reference_fill(&rgb, RGB(10, 20, 30)); sink += rgb.px[7]; }
+static void bench_fill3(){
+    uint8_t pixel[3] = {10, 20, 30};
+    PixelOps::fill(src.px, pixel, 3, IMAGE_PIXELS);
+    sink += src.px[7];
+}
+
+static void bench_reference_flip(){ reference_flip_rows(&rgba_a); sink += rgba_a.px[7]; }
+static void bench_flip(){
+    size_t row_size = IMAGE_WIDTH * 4;
+    for(int y = 0; y < (IMAGE_HEIGHT >> 1); y++){
+        PixelOps::swapRows(rgba_b.px + (row_size * y), rgba_b.px + (row_size * (IMAGE_HEIGHT - 1 - y)), row_size);
+    }
+    sink += rgba_b.px[7];
+}
+
+static void bench_reference_mirror(){ reference_mirror_rows(&rgba_a); sink += rgba_a.px[7]; }
+static void bench_mirror(){
+    for(int y = 0; y < IMAGE_HEIGHT; y++) PixelOps::mirrorRow(rgba_b.px + (IMAGE_WIDTH * 4 * y), 4, IMAGE_WIDTH);
+    sink += rgba_b.px[7];
+}
+
+static void bench_reference_blit(){ reference_blit(&rgba_a, &src); sink += rgba_a.px[7]; }
+static void bench_blit(){
+    PixelOps::blendRow(rgba_b.px, 4, src.px, IMAGE_PIXELS);
+    sink += rgba_b.px[7];
+}
+
+static void bench_reference_convert(){ reference_convert(&rgba_a, &rgb); sink += rgba_a.px[7]; }
+static void bench_convert(){
+    PixelOps::convertRow(rgba_b.px, 4, rgb.px, 3, IMAGE_PIXELS);
+    sink += rgba_b.px[7];
+}
+
+static void bench_reference_invert(){ reference_invert(&rgba_a); sink += rgba_a.px[7]; }
+static void bench_invert(){
+    PixelSpan<RGBA8> pixels((RGBA8*) rgba_b.px, IMAGE_WIDTH, IMAGE_HEIGHT, 0);
+    pixels.forEach([](RGBA8& px){
+        px.r ^= 0xff;
+        px.g ^= 0xff;
+        px.b ^= 0xff;
+        px.a  = 0xff;
+    });
+    sink += rgba_b.px[7];
+}
+
+static bool same_pixels(const image_t* a, const image_t* b){
+    return memcmp(a->px, b->px, IMAGE_PIXELS * a->components) == 0;
+}
+
+// RGB source blitted (Converted) into a smaller RGBA view at offsets inside and outside of it.
+// Every destination texel is checked against the source texel it should get, or its old value
+static bool check_clipped_blits(){
+    static const int offsets[] = {-12, -4, -1, 0, 3, 7, 9};
+    uint8_t source[16 * 16 * 3];
+    uint8_t dest[8 * 8 * 4];
+
+    for(int i = 0; i < (int) sizeof(source); i++) source[i] = (uint8_t) (i * 7 + 3);
+
+    for(int oy = 0; oy < (int) (sizeof(offsets) / sizeof(offsets[0])); oy++){
+        for(int ox = 0; ox < (int) (sizeof(offsets) / sizeof(offsets[0])); ox++){
+            int x = offsets[ox];
+            int y = offsets[oy];
+
+            memset(dest, 0x55, sizeof(dest));
+            PixmapView view(dest, 8, 8, 4, 0);
+            view.blit(PixmapView((const void*) source, 16, 16, 3, 0), x, y);
+
+            for(int dy = 0; dy < 8; dy++){
+                for(int dx = 0; dx < 8; dx++){
+                    const uint8_t* texel = dest + (dy * 8 + dx) * 4;
+                    int sx = dx - x;
+                    int sy = dy - y;
+
+                    uint8_t expected[4] = {0x55, 0x55, 0x55, 0x55};
+                    if(sx >= 0 && sx < 16 && sy >= 0 && sy < 16){
+                        memcpy(expected, source + (sy * 16 + sx) * 3, 3);
+                        expected[3] = 0xff;
+                    }
+
+                    if(memcmp(texel, expected, 4) != 0){
+                        printf("blit at %d, %d: texel %d, %d is wrong\n", x, y, dx, dy);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]){
+    double reference_ms, kernel_ms;
+
+    printf("Enyx pixel operations benchmark, %dx%d (%s code path, best of %d runs)\n\n", IMAGE_WIDTH, IMAGE_HEIGHT, ENYX_SIMD_NAME, BENCH_RUNS);
+
+    rgba_a = new_image(4);
+    rgba_b = new_image(4);
+    rgb    = new_image(3);
+
+    // Fill RGBA / RGB
+    reference_ms = run(bench_reference_fill, NULL);
+    kernel_ms    = run(bench_fill, NULL);
+    report("fill (RGBA)", reference_ms, kernel_ms, same_pixels(&rgba_a, &rgba_b));
+
+    src = new_image(3);
+    reference_ms = run(bench_reference_fill3, NULL);
+    kernel_ms    = run(bench_fill3, NULL);
+    report("fill (RGB)", reference_ms, kernel_ms, same_pixels(&rgb, &src));
+    free(src.px);
+
+    // Flips, checked once from the same pixels
+    reference_ms = run(bench_reference_flip, NULL);
+    kernel_ms    = run(bench_flip, NULL);
+    reset_a();
+    reset_b();
+    bench_reference_flip();
+    bench_flip();
+    report("flip rows", reference_ms, kernel_ms, same_pixels(&rgba_a, &rgba_b));
+
+    reference_ms = run(bench_reference_mirror, NULL);
+    kernel_ms    = run(bench_mirror, NULL);
+    reset_a();
+    reset_b();
+    bench_reference_mirror();
+    bench_mirror();
+    report("mirror rows", reference_ms, kernel_ms, same_pixels(&rgba_a, &rgba_b));
+
+    // Alpha blended blit of a random RGBA image
+    src = new_image(4);
+    random_image(&src, 2);
+    reference_ms = run(bench_reference_blit, reset_a);
+    kernel_ms    = run(bench_blit, reset_b);
+    report("blit (RGBA over RGBA)", reference_ms, kernel_ms, same_pixels(&rgba_a, &rgba_b));
+    free(src.px);
+
+    // RGB to RGBA
+    random_image(&rgb, 3);
+    reference_ms = run(bench_reference_convert, NULL);
+    kernel_ms    = run(bench_convert, NULL);
+    report("convert (RGB to RGBA)", reference_ms, kernel_ms, same_pixels(&rgba_a, &rgba_b));
+
+    // Per pixel loop, typed span against getPixel / setPixel
+    reference_ms = run(bench_reference_invert, reset_a);
+    kernel_ms    = run(bench_invert, reset_b);
+    report("invert (PixelSpan)", reference_ms, kernel_ms, same_pixels(&rgba_a, &rgba_b));
+
+    printf("%-24s %s\n", "blit clipping", check_clipped_blits() ? "OK" : "MISMATCH");
+
+    printf("\n(sink %d)\n", (int) sink);
+
+    free(rgba_a.px);
+    free(rgba_b.px);
+    free(rgb.px);
+    return 0;
+}